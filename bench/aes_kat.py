@@ -0,0 +1,256 @@
+# SPDX-License-Identifier: ZPL-2.1
+# SPDX-FileCopyrightText: Copyright fincs, devkitPro
+# Known-answer tests for the software AES implementation (source/arm/arm-aes.32.s
+# and source/arm/arm-aes-ccm.c), using the NIST SP 800-38A (CBC, CTR) and
+# SP 800-38C (CCM) example vectors. The assembly runs on an emulated ARM9,
+# whereas the CCM layer is built for the host with its AES calls forwarded to
+# the emulated assembly.
+# Requirements: cpp, llvm-mc (or $LLVM_MC) and a host C compiler (or $CC).
+# Usage: python3 aes_kat.py [calico source directory]
+import ctypes
+import os
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from armemu import Emu, load_objects, assemble
+
+ROOT = os.path.abspath(sys.argv[1] if len(sys.argv) > 1 else os.path.join(os.path.dirname(__file__), '..'))
+
+# Emulator memory map. Buffers are deliberately misaligned, as the bulk
+# functions accept any alignment.
+ADDR_KEY = 0x02200000
+ADDR_CTX = 0x02201000
+ADDR_IV  = 0x02202002
+ADDR_IN  = 0x02210001
+ADDR_OUT = 0x02220003
+CTX_SZ   = 16*15 + 4 # sizeof(ArmAesContext)
+
+h = bytes.fromhex
+
+# SP 800-38A, Appendix F
+SP800_38A_KEYS = {
+	128: h('2b7e151628aed2a6abf7158809cf4f3c'),
+	192: h('8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b'),
+	256: h('603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4'),
+}
+SP800_38A_PT = h(
+	'6bc1bee22e409f96e93d7e117393172a'
+	'ae2d8a571e03ac9c9eb76fac45af8e51'
+	'30c81c46a35ce411e5fbc1191a0a52ef'
+	'f69f2445df4f9b17ad2b417be66c3710')
+SP800_38A_CBC_IV = h('000102030405060708090a0b0c0d0e0f')
+SP800_38A_CBC = { # F.2.1, F.2.3, F.2.5
+	128: h('7649abac8119b246cee98e9b12e9197d'
+	       '5086cb9b507219ee95db113a917678b2'
+	       '73bed6b8e3c1743b7116e69e22229516'
+	       '3ff1caa1681fac09120eca307586e1a7'),
+	192: h('4f021db243bc633d7178183a9fa071e8'
+	       'b4d9ada9ad7dedf4e5e738763f69145a'
+	       '571b242012fb7ae07fa9baac3df102e0'
+	       '08b0e27988598881d920a9e64f5615cd'),
+	256: h('f58c4c04d6e5f1ba779eabfb5f7bfbd6'
+	       '9cfc4e967edb808d679f777bc6702c7d'
+	       '39f23369a9d9bacfa530e26304231461'
+	       'b2eb05e2c39be9fcda6c19078c6a9d1b'),
+}
+SP800_38A_CTR_IV = h('f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff')
+SP800_38A_CTR = { # F.5.1, F.5.3, F.5.5
+	128: h('874d6191b620e3261bef6864990db6ce'
+	       '9806f66b7970fdff8617187bb9fffdff'
+	       '5ae4df3edbd5d35e5b4f09020db03eab'
+	       '1e031dda2fbe03d1792170a0f3009cee'),
+	192: h('1abc932417521ca24f2b0459fe7e6e0b'
+	       '090339ec0aa6faefd5ccc2c6f4ce8e94'
+	       '1e36b26bd1ebc670d1bd1d665620abf7'
+	       '4f78a7f6d29809585a97daec58c6b050'),
+	256: h('601ec313775789a5b7a7f504bbf3d228'
+	       'f443e3ca4d62b59aca84e990cacaf5c5'
+	       '2b0930daa23de94ce87017ba2d84988d'
+	       'dfc9c58db67aada613c2dd08457941a6'),
+}
+
+# SP 800-38C, Appendix C: (nonce, aad, plaintext, ciphertext || tag, tag length)
+SP800_38C_KEY = h('404142434445464748494a4b4c4d4e4f')
+SP800_38C = [
+	('C.1', h('10111213141516'), h('0001020304050607'), h('20212223'),
+		h('7162015b4dac255d'), 4),
+	('C.2', h('1011121314151617'), h('000102030405060708090a0b0c0d0e0f'),
+		h('202122232425262728292a2b2c2d2e2f'), h('d2a1f0e051ea5f62081a7792073d593d1fc64fbfaccd'), 6),
+	('C.3', h('101112131415161718191a1b'), bytes(range(0x00, 0x14)), bytes(range(0x20, 0x38)),
+		h('e3b201a9f5b71a7a9b1ceaeccd97e70b6176aad9a4428aa5484392fbc1b09951'), 8),
+	('C.4', h('101112131415161718191a1b1c'), bytes(range(256))*256, bytes(range(0x20, 0x40)),
+		h('69915dad1e84c6376a68c2967e4dab615ae0fd1faec44cc484828529463ccf72'
+		  'b4ac6bec93e8598e7f0dadbcea5b'), 14),
+]
+
+class AesEmu:
+	def __init__(self):
+		objs = assemble([os.path.join(ROOT, 'source/arm/arm-aes.32.s')], os.path.join(ROOT, 'include'))
+		self.emu = Emu()
+		self.syms = load_objects(self.emu, objs)
+
+	def call(self, name, *args):
+		return self.emu.call(self.syms[name], *args)
+
+	def set_key(self, key, decrypt=False):
+		self.emu.write(ADDR_KEY, key)
+		self.call('armAesSetDecryptKey' if decrypt else 'armAesSetEncryptKey', ADDR_KEY, len(key)*8, ADDR_CTX)
+
+	def bulk(self, name, data, iv):
+		# Splits the data in two calls, to check that the IV/counter is updated
+		num_blocks = len(data) // 16
+		first = num_blocks // 2
+		self.emu.write(ADDR_IN, data)
+		self.emu.write(ADDR_IV, iv)
+		self.call(name, ADDR_IN, ADDR_OUT, first, ADDR_IV, ADDR_CTX)
+		self.call(name, ADDR_IN + 16*first, ADDR_OUT + 16*first, num_blocks - first, ADDR_IV, ADDR_CTX)
+		return self.emu.read(ADDR_OUT, len(data)), self.emu.read(ADDR_IV, 16)
+
+	def bulk_inplace(self, name, data, iv):
+		self.emu.write(ADDR_IN, data)
+		self.emu.write(ADDR_IV, iv)
+		self.call(name, ADDR_IN, ADDR_IN, len(data) // 16, ADDR_IV, ADDR_CTX)
+		return self.emu.read(ADDR_IN, len(data))
+
+	def cbc_mac(self, data):
+		self.emu.write(ADDR_IN, data)
+		self.emu.write(ADDR_IV, bytes(16))
+		self.call('armAesCbcMac', ADDR_IN, len(data) // 16, ADDR_IV, ADDR_CTX)
+		return self.emu.read(ADDR_IV, 16)
+
+def _xor(a, b):
+	return bytes(x ^ y for x, y in zip(a, b))
+
+def _inc_ctr(ctr, n):
+	return ((int.from_bytes(ctr, 'big') + n) % (1 << 128)).to_bytes(16, 'big')
+
+class KatRunner:
+	def __init__(self):
+		self.num_fails = 0
+		self.num_tests = 0
+
+	def check(self, name, got, expected):
+		self.num_tests += 1
+		if got != expected:
+			self.num_fails += 1
+			print('FAIL %s\n  got      %s\n  expected %s' % (name, got.hex(), expected.hex()))
+
+def test_sp800_38a(kat, aes):
+	for bits, key in SP800_38A_KEYS.items():
+		cbc_ct = SP800_38A_CBC[bits]
+		ctr_ct = SP800_38A_CTR[bits]
+
+		# ECB (first block of the CBC vector)
+		aes.set_key(key)
+		aes.emu.write(ADDR_IN, _xor(SP800_38A_PT[:16], SP800_38A_CBC_IV))
+		aes.call('armAesEncrypt', ADDR_IN, ADDR_OUT, ADDR_CTX)
+		kat.check('ECB-AES%d.Encrypt' % bits, aes.emu.read(ADDR_OUT, 16), cbc_ct[:16])
+
+		# CBC
+		out, iv = aes.bulk('armAesCbcEncrypt', SP800_38A_PT, SP800_38A_CBC_IV)
+		kat.check('CBC-AES%d.Encrypt' % bits, out, cbc_ct)
+		kat.check('CBC-AES%d.Encrypt IV' % bits, iv, cbc_ct[-16:])
+		kat.check('CBC-AES%d.Encrypt in-place' % bits, aes.bulk_inplace('armAesCbcEncrypt', SP800_38A_PT, SP800_38A_CBC_IV), cbc_ct)
+		# CBC-MAC uses a zero IV, so the IV is folded into the first block
+		kat.check('CBC-AES%d.MAC' % bits, aes.cbc_mac(_xor(SP800_38A_PT[:16], SP800_38A_CBC_IV) + SP800_38A_PT[16:]), cbc_ct[-16:])
+
+		# CTR
+		out, ctr = aes.bulk('armAesCtrCrypt', SP800_38A_PT, SP800_38A_CTR_IV)
+		kat.check('CTR-AES%d.Encrypt' % bits, out, ctr_ct)
+		kat.check('CTR-AES%d.Encrypt counter' % bits, ctr, _inc_ctr(SP800_38A_CTR_IV, 4))
+		out, _ = aes.bulk('armAesCtrCrypt', ctr_ct, SP800_38A_CTR_IV)
+		kat.check('CTR-AES%d.Decrypt' % bits, out, SP800_38A_PT)
+		kat.check('CTR-AES%d.Decrypt in-place' % bits, aes.bulk_inplace('armAesCtrCrypt', ctr_ct, SP800_38A_CTR_IV), SP800_38A_PT)
+
+		# CBC decryption and single block decryption
+		aes.set_key(key, decrypt=True)
+		aes.emu.write(ADDR_IN, cbc_ct)
+		aes.call('armAesDecrypt', ADDR_IN, ADDR_OUT, ADDR_CTX)
+		kat.check('ECB-AES%d.Decrypt' % bits, aes.emu.read(ADDR_OUT, 16), _xor(SP800_38A_PT[:16], SP800_38A_CBC_IV))
+		out, iv = aes.bulk('armAesCbcDecrypt', cbc_ct, SP800_38A_CBC_IV)
+		kat.check('CBC-AES%d.Decrypt' % bits, out, SP800_38A_PT)
+		kat.check('CBC-AES%d.Decrypt IV' % bits, iv, cbc_ct[-16:])
+		kat.check('CBC-AES%d.Decrypt in-place' % bits, aes.bulk_inplace('armAesCbcDecrypt', cbc_ct, SP800_38A_CBC_IV), SP800_38A_PT)
+
+def _build_ccm_lib(tmp):
+	lib = os.path.join(tmp, 'libaesccm.so')
+	cc = os.environ.get('CC', 'cc')
+	subprocess.check_call([cc, '-std=gnu11', '-shared', '-fPIC', '-O2', '-DCALICO_HOST', '-I' + os.path.join(ROOT, 'include'),
+		os.path.join(ROOT, 'source/arm/arm-aes-ccm.c'), os.path.join(ROOT, 'bench/aes_kat_shim.c'), '-o', lib])
+	return ctypes.CDLL(lib)
+
+def test_sp800_38c(kat, aes):
+	lib = _build_ccm_lib(tempfile.mkdtemp(prefix='aes_kat'))
+	vp, sz = ctypes.c_void_p, ctypes.c_size_t
+	emu = aes.emu
+
+	def load_ctx(ctx):
+		emu.write(ADDR_CTX, ctypes.string_at(ctx, CTX_SZ))
+
+	def fwd_encrypt(inp, out, ctx):
+		load_ctx(ctx)
+		emu.write(ADDR_IN, ctypes.string_at(inp, 16))
+		aes.call('armAesEncrypt', ADDR_IN, ADDR_OUT, ADDR_CTX)
+		ctypes.memmove(out, emu.read(ADDR_OUT, 16), 16)
+
+	def fwd_ctr(inp, out, num_blocks, ctr, ctx):
+		load_ctx(ctx)
+		if num_blocks:
+			emu.write(ADDR_IN, ctypes.string_at(inp, 16*num_blocks))
+		emu.write(ADDR_IV, ctypes.string_at(ctr, 16))
+		aes.call('armAesCtrCrypt', ADDR_IN, ADDR_OUT, num_blocks, ADDR_IV, ADDR_CTX)
+		if num_blocks:
+			ctypes.memmove(out, emu.read(ADDR_OUT, 16*num_blocks), 16*num_blocks)
+		ctypes.memmove(ctr, emu.read(ADDR_IV, 16), 16)
+
+	def fwd_cbc_mac(inp, num_blocks, mac, ctx):
+		load_ctx(ctx)
+		if num_blocks:
+			emu.write(ADDR_IN, ctypes.string_at(inp, 16*num_blocks))
+		emu.write(ADDR_IV, ctypes.string_at(mac, 16))
+		aes.call('armAesCbcMac', ADDR_IN, num_blocks, ADDR_IV, ADDR_CTX)
+		ctypes.memmove(mac, emu.read(ADDR_IV, 16), 16)
+
+	# Keep references to the callbacks for as long as the library uses them
+	fwds = (
+		('katAesEncrypt', ctypes.CFUNCTYPE(None, vp, vp, vp)(fwd_encrypt)),
+		('katAesCtrCrypt', ctypes.CFUNCTYPE(None, vp, vp, sz, vp, vp)(fwd_ctr)),
+		('katAesCbcMac', ctypes.CFUNCTYPE(None, vp, sz, vp, vp)(fwd_cbc_mac)),
+	)
+	for name, fn in fwds:
+		vp.in_dll(lib, name).value = ctypes.cast(fn, vp).value
+
+	for f in ('armAesCcmEncrypt', 'armAesCcmDecrypt'):
+		getattr(lib, f).argtypes = [vp, vp, sz, vp, sz, vp, vp, sz, vp, sz]
+		getattr(lib, f).restype = ctypes.c_bool
+
+	aes.set_key(SP800_38C_KEY)
+	ctx = ctypes.create_string_buffer(emu.read(ADDR_CTX, CTX_SZ), CTX_SZ)
+
+	for name, nonce, aad, pt, expected, tag_len in SP800_38C:
+		ct = ctypes.create_string_buffer(len(pt))
+		tag = ctypes.create_string_buffer(tag_len)
+		ok = lib.armAesCcmEncrypt(ctx, nonce, len(nonce), aad, len(aad), pt, ct, len(pt), tag, tag_len)
+		kat.check('CCM %s.Encrypt' % name, bytes([ok]) + ct.raw + tag.raw, b'\1' + expected)
+
+		out = ctypes.create_string_buffer(len(pt))
+		ct_exp, tag_exp = expected[:len(pt)], expected[len(pt):]
+		ok = lib.armAesCcmDecrypt(ctx, nonce, len(nonce), aad, len(aad), ct_exp, out, len(pt), tag_exp, tag_len)
+		kat.check('CCM %s.Decrypt' % name, bytes([ok]) + out.raw, b'\1' + pt)
+
+		bad_tag = bytes([tag_exp[0] ^ 1]) + tag_exp[1:]
+		ok = lib.armAesCcmDecrypt(ctx, nonce, len(nonce), aad, len(aad), ct_exp, out, len(pt), bad_tag, tag_len)
+		kat.check('CCM %s.Decrypt bad tag' % name, bytes([ok]), b'\0')
+
+def main():
+	kat = KatRunner()
+	aes = AesEmu()
+	test_sp800_38a(kat, aes)
+	test_sp800_38c(kat, aes)
+	print('%d/%d known-answer tests passed' % (kat.num_tests - kat.num_fails, kat.num_tests))
+	return 1 if kat.num_fails else 0
+
+if __name__ == '__main__':
+	sys.exit(main())
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+// Host build of the AES-CCM layer for aes_kat.py: the AES primitives it calls
+// are forwarded to the emulated ARM assembly implementation.
+#include <calico/types.h>
+#include <calico/arm/aes.h>
+
+typedef void (* KatAesEncryptFn)(const void* in, void* out, ArmAesContext const* ctx);
+typedef void (* KatAesCtrCryptFn)(const void* in, void* out, size_t num_blocks, void* ctr, ArmAesContext const* ctx);
+typedef void (* KatAesCbcMacFn)(const void* in, size_t num_blocks, void* mac, ArmAesContext const* ctx);
+
+KatAesEncryptFn katAesEncrypt;
+KatAesCtrCryptFn katAesCtrCrypt;
+KatAesCbcMacFn katAesCbcMac;
+
+void armAesEncrypt(const void* in, void* out, ArmAesContext const* ctx)
+{
+	katAesEncrypt(in, out, ctx);
+}
+
+void armAesCtrCrypt(const void* in, void* out, size_t num_blocks, void* ctr, ArmAesContext const* ctx)
+{
+	katAesCtrCrypt(in, out, num_blocks, ctr, ctx);
+}
+
+void armAesCbcMac(const void* in, size_t num_blocks, void* mac, ArmAesContext const* ctx)
+{
+	katAesCbcMac(in, num_blocks, mac, ctx);
+}
@@ -0,0 +1,72 @@
+# SPDX-License-Identifier: ZPL-2.1
+# SPDX-FileCopyrightText: Copyright fincs, devkitPro
+# Instruction counts of calico's hand-written ARM assembly routines, measured on
+# the emulator from armemu.py. The estimated throughput assumes one instruction
+# per cycle on the ARM9 (code and tables in TCM), so it is an upper bound.
+# Requirements: cpp and llvm-mc (or $LLVM_MC).
+# Usage: python3 arm_bench.py [calico source directory]
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from armemu import Emu, load_objects, assemble
+
+ROOT = os.path.abspath(sys.argv[1] if len(sys.argv) > 1 else os.path.join(os.path.dirname(__file__), '..'))
+
+ARM9_NTR_HZ = 67_027_964
+ARM9_TWL_HZ = 2*ARM9_NTR_HZ
+
+ADDR_CTX = 0x02100000
+ADDR_IV  = 0x02180000
+ADDR_IN  = 0x02200000
+ADDR_OUT = 0x02280000
+
+def _load(*srcs):
+	emu = Emu()
+	syms = load_objects(emu, assemble([os.path.join(ROOT, s) for s in srcs], os.path.join(ROOT, 'include')))
+	return emu, syms
+
+def _report(name, num_bytes, steps):
+	ipb = steps / num_bytes
+	print('%-20s %8.1f insns/byte %8.2f MB/s (NTR) %8.2f MB/s (TWL)' % (name, ipb,
+		ARM9_NTR_HZ / ipb / 1e6, ARM9_TWL_HZ / ipb / 1e6))
+
+def _report_op(name, steps):
+	print('%-20s %8d insns/op   %8.0f us (NTR)   %8.0f us (TWL)' % (name, steps,
+		steps * 1e6 / ARM9_NTR_HZ, steps * 1e6 / ARM9_TWL_HZ))
+
+def bench_aes_ctr(num_blocks=64):
+	# Software path of the ARM9 crypto service (aesCtrCrypt in DS mode, or before
+	# the ARM7 side of the service is up), excluding the byte reversal done in C
+	emu, syms = _load('source/arm/arm-aes.32.s')
+	emu.write(ADDR_IN, bytes(16))
+	emu.call(syms['armAesSetEncryptKey'], ADDR_IN, 128, ADDR_CTX)
+	emu.call(syms['armAesCtrCrypt'], ADDR_IN, ADDR_OUT, num_blocks, ADDR_IV, ADDR_CTX)
+	_report('aes128_ctr', 16*num_blocks, emu.steps)
+
+def bench_fugu(secure_area_sz=0x800):
+	# Secure area decryption (2 KiB of Blowfish ECB) and key expansion. The
+	# state contents do not affect the instruction count.
+	emu, syms = _load('source/dev/fugu_bulk.32.s')
+	num_blocks = secure_area_sz // 8
+	emu.call(syms['fuguDecryptBlocks'], ADDR_CTX, ADDR_IN, ADDR_IN, num_blocks)
+	_report('fugu_decrypt_2k', secure_area_sz, emu.steps)
+
+	# Same, one block per call (as done by callers of the single block functions)
+	steps = 0
+	for i in range(num_blocks):
+		emu.call(syms['fuguDecryptBlocks'], ADDR_CTX, ADDR_IN + 8*i, ADDR_IN + 8*i, 1)
+		steps += emu.steps
+	_report('fugu_decrypt_2k_1blk', secure_area_sz, steps)
+
+	emu.call(syms['_fuguKeyExpand'], ADDR_CTX)
+	_report_op('fugu_key_expand', emu.steps)
+
+BENCHES = [
+	bench_aes_ctr,
+	bench_fugu,
+]
+
+if __name__ == '__main__':
+	for bench in BENCHES:
+		bench()
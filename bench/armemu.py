@@ -0,0 +1,431 @@
+# SPDX-License-Identifier: ZPL-2.1
+# SPDX-FileCopyrightText: Copyright fincs, devkitPro
+# Minimal ARM (A32, ARMv5TE subset) interpreter and object loader, used to run
+# calico's hand-written assembly on the build host. Only user-mode integer
+# instructions are implemented; coprocessor and PSR accesses are ignored.
+import os
+import struct
+import subprocess
+import tempfile
+
+M32 = 0xffffffff
+RET_MAGIC = 0xdead0000
+
+def _ror(v, n):
+	n &= 31
+	return ((v >> n) | (v << (32 - n))) & M32 if n else v
+
+def _sext(v, bits):
+	return v - (1 << bits) if v & (1 << (bits - 1)) else v
+
+class EmuError(Exception):
+	pass
+
+class Emu:
+	def __init__(self, mem_size=0x400000, base=0x02000000):
+		self.base = base
+		self.mem = bytearray(mem_size)
+		self.r = [0]*16
+		self.N = self.Z = self.C = self.V = 0
+		self.steps = 0
+
+	# Memory accessors
+
+	def _off(self, addr, size):
+		o = addr - self.base
+		if o < 0 or o + size > len(self.mem):
+			raise EmuError("bad address %08x (pc=%08x)" % (addr, self.r[15]))
+		return o
+
+	def r32(self, a):
+		return struct.unpack_from('<I', self.mem, self._off(a &~ 3, 4))[0]
+
+	def w32(self, a, v):
+		struct.pack_into('<I', self.mem, self._off(a &~ 3, 4), v & M32)
+
+	def r16(self, a):
+		return struct.unpack_from('<H', self.mem, self._off(a &~ 1, 2))[0]
+
+	def w16(self, a, v):
+		struct.pack_into('<H', self.mem, self._off(a &~ 1, 2), v & 0xffff)
+
+	def r8(self, a):
+		return self.mem[self._off(a, 1)]
+
+	def w8(self, a, v):
+		self.mem[self._off(a, 1)] = v & 0xff
+
+	def read(self, a, n):
+		o = self._off(a, n)
+		return bytes(self.mem[o:o+n])
+
+	def write(self, a, data):
+		o = self._off(a, len(data))
+		self.mem[o:o+len(data)] = data
+
+	# Instruction execution
+
+	def _cond(self, c):
+		N, Z, C, V = self.N, self.Z, self.C, self.V
+		return (Z, not Z, C, not C, N, not N, V, not V,
+			C and not Z, (not C) or Z, N == V, N != V,
+			(not Z) and N == V, Z or N != V, True, False)[c]
+
+	def _reg(self, n):
+		return (self.r[15] + 8) & M32 if n == 15 else self.r[n]
+
+	def _shift(self, val, typ, amt, by_reg):
+		carry = self.C
+		if by_reg:
+			amt &= 0xff
+			if amt == 0:
+				return val, carry
+			if typ == 0: # LSL
+				if amt < 32: return (val << amt) & M32, (val >> (32-amt)) & 1
+				return 0, val & 1 if amt == 32 else 0
+			if typ == 1: # LSR
+				if amt < 32: return val >> amt, (val >> (amt-1)) & 1
+				return 0, val >> 31 if amt == 32 else 0
+			if typ == 2: # ASR
+				if amt >= 32: return (M32 if val >> 31 else 0), val >> 31
+				return (_sext(val, 32) >> amt) & M32, (val >> (amt-1)) & 1
+			amt &= 31 # ROR
+			if amt == 0:
+				return val, val >> 31
+			return _ror(val, amt), (val >> (amt-1)) & 1
+
+		if typ == 0: # LSL
+			if amt == 0: return val, carry
+			return (val << amt) & M32, (val >> (32-amt)) & 1
+		if typ == 1: # LSR
+			if amt == 0: return 0, val >> 31
+			return val >> amt, (val >> (amt-1)) & 1
+		if typ == 2: # ASR
+			if amt == 0: return (M32 if val >> 31 else 0), val >> 31
+			return (_sext(val, 32) >> amt) & M32, (val >> (amt-1)) & 1
+		if amt == 0: # RRX
+			return ((carry << 31) | (val >> 1)) & M32, val & 1
+		return _ror(val, amt), (val >> (amt-1)) & 1
+
+	def _op2(self, ins):
+		if ins & (1 << 25):
+			rot = ((ins >> 8) & 0xf) * 2
+			v = _ror(ins & 0xff, rot)
+			return v, (v >> 31) if rot else self.C
+		rm = self._reg(ins & 0xf)
+		typ = (ins >> 5) & 3
+		if ins & 0x10:
+			if (ins & 0xf) == 15:
+				rm = (self.r[15] + 12) & M32
+			return self._shift(rm, typ, self.r[(ins >> 8) & 0xf], True)
+		return self._shift(rm, typ, (ins >> 7) & 0x1f, False)
+
+	def _add(self, a, b, cin):
+		res = a + b + cin
+		r = res & M32
+		return r, int(res > M32), int(((a ^ r) & (b ^ r)) >> 31)
+
+	def _exec_dp(self, ins, nxt):
+		opc = (ins >> 21) & 0xf
+		S = (ins >> 20) & 1
+		rn_idx = (ins >> 16) & 0xf
+		rd = (ins >> 12) & 0xf
+		rn = self._reg(rn_idx)
+		if rn_idx == 15 and not (ins & (1 << 25)) and (ins & 0x10):
+			rn = (self.r[15] + 12) & M32
+		b, sc = self._op2(ins)
+
+		C, V = self.C, self.V
+		write = True
+		if   opc == 0x0: res = rn & b; C = sc                          # AND
+		elif opc == 0x1: res = rn ^ b; C = sc                          # EOR
+		elif opc == 0x2: res, C, V = self._add(rn, ~b & M32, 1)        # SUB
+		elif opc == 0x3: res, C, V = self._add(b, ~rn & M32, 1)        # RSB
+		elif opc == 0x4: res, C, V = self._add(rn, b, 0)               # ADD
+		elif opc == 0x5: res, C, V = self._add(rn, b, self.C)          # ADC
+		elif opc == 0x6: res, C, V = self._add(rn, ~b & M32, self.C)   # SBC
+		elif opc == 0x7: res, C, V = self._add(b, ~rn & M32, self.C)   # RSC
+		elif opc == 0x8: res = rn & b; C = sc; write = False           # TST
+		elif opc == 0x9: res = rn ^ b; C = sc; write = False           # TEQ
+		elif opc == 0xa: res, C, V = self._add(rn, ~b & M32, 1); write = False # CMP
+		elif opc == 0xb: res, C, V = self._add(rn, b, 0); write = False        # CMN
+		elif opc == 0xc: res = rn | b; C = sc                          # ORR
+		elif opc == 0xd: res = b; C = sc                               # MOV
+		elif opc == 0xe: res = rn & ~b & M32; C = sc                   # BIC
+		else:            res = ~b & M32; C = sc                        # MVN
+
+		if S:
+			self.N, self.Z, self.C, self.V = res >> 31, int(res == 0), C, V
+		if write:
+			self.r[rd] = res
+			if rd == 15:
+				self.r[15] = res &~ 3
+				return
+		self.r[15] = nxt
+
+	def _exec_xfer_misc(self, ins, nxt):
+		# Halfword/signed byte transfers, LDRD/STRD
+		P, U, I, W, L = [(ins >> s) & 1 for s in (24, 23, 22, 21, 20)]
+		rn = (ins >> 16) & 0xf
+		rd = (ins >> 12) & 0xf
+		sh = (ins >> 5) & 3
+		off = (((ins >> 8) & 0xf) << 4) | (ins & 0xf) if I else self.r[ins & 0xf]
+		base = self._reg(rn)
+		addr = (base + off if U else base - off) & M32
+		ea = addr if P else base
+
+		if L:
+			if sh == 1:   val = self.r16(ea)
+			elif sh == 2: val = _sext(self.r8(ea), 8) & M32
+			else:         val = _sext(self.r16(ea), 16) & M32
+		elif sh == 1:
+			self.w16(ea, self.r[rd])
+		elif sh == 2: # LDRD
+			self.r[rd], self.r[rd+1] = self.r32(ea), self.r32(ea+4)
+		else: # STRD
+			self.w32(ea, self.r[rd])
+			self.w32(ea+4, self.r[rd+1])
+
+		if not P or W:
+			self.r[rn] = addr
+		if L:
+			self.r[rd] = val
+		self.r[15] = nxt
+
+	def _exec_xfer(self, ins, pc, nxt):
+		P, U, B, W, L = [(ins >> s) & 1 for s in (24, 23, 22, 21, 20)]
+		rn = (ins >> 16) & 0xf
+		rd = (ins >> 12) & 0xf
+		if ins & (1 << 25):
+			off, _ = self._shift(self._reg(ins & 0xf), (ins >> 5) & 3, (ins >> 7) & 0x1f, False)
+		else:
+			off = ins & 0xfff
+		base = self._reg(rn)
+		addr = (base + off if U else base - off) & M32
+		ea = addr if P else base
+
+		if L:
+			val = self.r8(ea) if B else _ror(self.r32(ea), (ea & 3) * 8)
+		else:
+			v = self.r[rd] if rd != 15 else pc + 12
+			if B: self.w8(ea, v)
+			else: self.w32(ea, v)
+
+		if not P or W:
+			self.r[rn] = addr
+		if L:
+			self.r[rd] = val
+			if rd == 15:
+				self.r[15] = val &~ 3
+				return
+		self.r[15] = nxt
+
+	def _exec_block(self, ins, pc, nxt):
+		P, U, W, L = [(ins >> s) & 1 for s in (24, 23, 21, 20)]
+		rn = (ins >> 16) & 0xf
+		regs = [i for i in range(16) if ins & (1 << i)]
+		base = self.r[rn]
+		n = len(regs)
+		if U: a = base + 4 if P else base
+		else: a = base - 4*n if P else base - 4*n + 4
+		a &= M32
+
+		new_pc = None
+		for i in regs:
+			if not L:
+				self.w32(a, self.r[i] if i != 15 else pc + 12)
+			elif i == 15:
+				new_pc = self.r32(a)
+			else:
+				self.r[i] = self.r32(a)
+			a += 4
+
+		if W and not (L and rn in regs):
+			self.r[rn] = (base + 4*n if U else base - 4*n) & M32
+		self.r[15] = new_pc &~ 3 if new_pc is not None else nxt
+
+	def step(self):
+		pc = self.r[15]
+		if pc == RET_MAGIC:
+			return False
+		ins = self.r32(pc)
+		nxt = (pc + 4) & M32
+		self.steps += 1
+
+		if (ins >> 28) != 14 and not self._cond(ins >> 28):
+			self.r[15] = nxt
+		elif (ins & 0x0fffffd0) == 0x012fff10: # BX, BLX (register)
+			t = self._reg(ins & 0xf)
+			if t & 1:
+				raise EmuError("Thumb is not supported (pc=%08x)" % pc)
+			if ins & 0x20:
+				self.r[14] = nxt
+			self.r[15] = t
+		elif (ins & 0x0fff0ff0) == 0x016f0f10: # CLZ
+			self.r[(ins >> 12) & 0xf] = 32 - self._reg(ins & 0xf).bit_length()
+			self.r[15] = nxt
+		elif (ins & 0x0fc000f0) == 0x00000090: # MUL, MLA
+			rd, rn, rs, rm = [(ins >> s) & 0xf for s in (16, 12, 8, 0)]
+			v = self.r[rm] * self.r[rs]
+			if ins & (1 << 21):
+				v += self.r[rn]
+			v &= M32
+			self.r[rd] = v
+			if ins & (1 << 20):
+				self.N, self.Z = v >> 31, int(v == 0)
+			self.r[15] = nxt
+		elif (ins & 0x0f8000f0) == 0x00800090: # UMULL, UMLAL, SMULL, SMLAL
+			rdhi, rdlo, rs, rm = [(ins >> s) & 0xf for s in (16, 12, 8, 0)]
+			a, b = self.r[rm], self.r[rs]
+			if ins & (1 << 22):
+				a, b = _sext(a, 32), _sext(b, 32)
+			v = a * b
+			if ins & (1 << 21):
+				v += (self.r[rdhi] << 32) | self.r[rdlo]
+			v &= (1 << 64) - 1
+			self.r[rdlo], self.r[rdhi] = v & M32, v >> 32
+			if ins & (1 << 20):
+				self.N, self.Z = v >> 63, int(v == 0)
+			self.r[15] = nxt
+		elif (ins & 0x0e000090) == 0x00000090 and (ins & 0x60):
+			self._exec_xfer_misc(ins, nxt)
+		elif (ins & 0x0fb00ff0) == 0x01000000 or (ins & 0x0db0f000) == 0x0120f000: # MRS, MSR
+			if (ins & 0x0fbf0fff) == 0x010f0000:
+				self.r[(ins >> 12) & 0xf] = (self.N << 31) | (self.Z << 30) | (self.C << 29) | (self.V << 28) | 0x1f
+			self.r[15] = nxt
+		elif (ins >> 26) & 3 == 0:
+			self._exec_dp(ins, nxt)
+		elif (ins >> 26) & 3 == 1:
+			self._exec_xfer(ins, pc, nxt)
+		elif (ins >> 25) & 7 == 4:
+			self._exec_block(ins, pc, nxt)
+		elif (ins >> 25) & 7 == 5: # B, BL
+			if ins & (1 << 24):
+				self.r[14] = nxt
+			self.r[15] = (pc + 8 + _sext(ins & 0xffffff, 24)*4) & M32
+		elif (ins & 0x0f000010) == 0x0e000010: # MRC, MCR
+			self.r[15] = nxt
+		else:
+			raise EmuError("unhandled instruction %08x (pc=%08x)" % (ins, pc))
+		return True
+
+	def call(self, addr, *args, max_steps=100_000_000):
+		"""Calls the AAPCS function at addr, and returns r0"""
+		sp = self.base + len(self.mem) - 0x100
+		stack_args = args[4:]
+		sp -= 4*len(stack_args)
+		for i, a in enumerate(stack_args):
+			self.w32(sp + 4*i, a)
+		for i, a in enumerate(args[:4]):
+			self.r[i] = a & M32
+		self.r[13] = sp
+		self.r[14] = RET_MAGIC
+		self.r[15] = addr
+		self.steps = 0
+		while self.step():
+			if self.steps > max_steps:
+				raise EmuError("function at %08x did not return" % addr)
+		return self.r[0]
+
+# ELF relocatable object loading
+
+_SHT_SYMTAB = 2
+_SHT_NOBITS = 8
+_SHT_REL = 9
+_SHF_ALLOC = 2
+
+_R_ARM_PC24 = 1
+_R_ARM_ABS32 = 2
+_R_ARM_CALL = 28
+_R_ARM_JUMP24 = 29
+_R_ARM_V4BX = 40
+
+def _elf_sections(data):
+	shoff, = struct.unpack_from('<I', data, 0x20)
+	shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data, 0x2e)
+	secs = []
+	for i in range(shnum):
+		name, typ, flags, _, off, size, link, info, align, entsize = \
+			struct.unpack_from('<10I', data, shoff + i*shentsize)
+		secs.append(dict(name=name, type=typ, flags=flags, off=off, size=size,
+			link=link, info=info, align=max(align, 1), entsize=entsize))
+	return secs
+
+def _elf_str(data, sec, off):
+	start = sec['off'] + off
+	return data[start:data.index(b'\0', start)].decode()
+
+def load_objects(emu, objs, addr=None):
+	"""Places the allocated sections of the given ELF objects in emulator
+	memory, applies their relocations, and returns the global symbol table"""
+	addr = addr or emu.base
+	globals_ = {}
+	pending = []
+
+	for path in objs:
+		data = open(path, 'rb').read()
+		if data[:4] != b'\x7fELF' or data[4] != 1:
+			raise EmuError("%s: not an ELF32 object" % path)
+		secs = _elf_sections(data)
+
+		# Lay out the allocated sections
+		sec_addr = {}
+		for i, s in enumerate(secs):
+			if not (s['flags'] & _SHF_ALLOC):
+				continue
+			addr = (addr + s['align'] - 1) &~ (s['align'] - 1)
+			sec_addr[i] = addr
+			if s['type'] != _SHT_NOBITS:
+				emu.write(addr, data[s['off']:s['off']+s['size']])
+			addr += s['size']
+
+		# Read the symbol table
+		symtab = next(s for s in secs if s['type'] == _SHT_SYMTAB)
+		strtab = secs[symtab['link']]
+		syms = []
+		for j in range(symtab['size'] // 16):
+			name, value, _, info, _, shndx = struct.unpack_from('<IIIBBH', data, symtab['off'] + j*16)
+			name = _elf_str(data, strtab, name)
+			value = sec_addr[shndx] + value if shndx in sec_addr else None
+			if value is not None and (info >> 4) != 0: # not STB_LOCAL
+				globals_[name] = value
+			syms.append((name, value))
+
+		for s in secs:
+			if s['type'] == _SHT_REL and s['info'] in sec_addr:
+				for j in range(s['size'] // 8):
+					r_off, r_info = struct.unpack_from('<II', data, s['off'] + j*8)
+					pending.append((sec_addr[s['info']] + r_off, r_info & 0xff, syms[r_info >> 8]))
+
+	# Apply relocations once all global symbols are known
+	for P, typ, (name, S) in pending:
+		if S is None:
+			S = globals_.get(name)
+			if S is None:
+				raise EmuError("undefined symbol: %s" % name)
+		ins = emu.r32(P)
+		if typ == _R_ARM_ABS32:
+			emu.w32(P, S + ins)
+		elif typ in (_R_ARM_PC24, _R_ARM_CALL, _R_ARM_JUMP24):
+			off = (S + _sext(ins & 0xffffff, 24)*4 - P) >> 2
+			emu.w32(P, (ins &~ 0xffffff) | (off & 0xffffff))
+		elif typ != _R_ARM_V4BX:
+			raise EmuError("unsupported relocation type %d" % typ)
+
+	return globals_
+
+def assemble(srcs, incdir, arch='armv5te', defines=()):
+	"""Preprocesses and assembles calico .s sources, returning object paths.
+	The assembler can be overridden with the LLVM_MC environment variable."""
+	llvm_mc = os.environ.get('LLVM_MC', 'llvm-mc')
+	archdef = {'armv5te': '__ARM_ARCH_5TE__', 'armv4t': '__ARM_ARCH_4T__'}[arch]
+	tmp = tempfile.mkdtemp(prefix='armemu')
+	objs = []
+	for i, src in enumerate(srcs):
+		pp = os.path.join(tmp, '%d.s' % i)
+		obj = os.path.join(tmp, '%d.o' % i)
+		subprocess.check_call(['cpp', '-P', '-D%s=1' % archdef, '-I' + incdir] +
+			['-D' + d for d in defines] + [src, '-o', pp])
+		subprocess.check_call([llvm_mc, '-triple=%s-none-eabi' % arch, '-filetype=obj', pp, '-o', obj])
+		objs.append(obj)
+	return objs
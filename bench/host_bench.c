@@ -0,0 +1,398 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+// Scheduler and IPC microbenchmarks, running on the host simulator.
+// Usage: calico_bench [iterations]
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <calico.h>
+#include <calico/dev/fugu.h>
+
+#define BENCH_STACK_SZ 0x10000
+
+#define BENCH_CH_ECHO   PxiChannel_User0
+#define BENCH_CH_SINK   PxiChannel_User1
+#define BENCH_CH_CTRL   PxiChannel_User2
+#define BENCH_CH_WAKE   PxiChannel_User3
+#define BENCH_DB_PING   PxiDoorbell_User0
+#define BENCH_DB_PONG   PxiDoorbell_User1
+#define BENCH_DB_DONE   PxiDoorbell_User2
+
+#define BENCH_RING_WORDS   1024
+#define BENCH_RING_BATCH   32
+#define BENCH_STREAM_WORDS 8
+
+#define BENCH_SECURE_AREA_SZ 0x800
+
+static unsigned s_numIters = 100000;
+
+static Thread s_peerThread;
+static alignas(16) u8 s_peerStack[BENCH_STACK_SZ];
+
+static Mailbox s_mbPing, s_mbPong;
+static u32 s_mbPingSlots[1], s_mbPongSlots[1];
+
+static PxiRing s_benchRing;
+static u32 s_benchRingBuf[BENCH_RING_WORDS];
+static vu32 s_sinkWords, s_sinkTarget;
+
+static Mailbox s_mbWake;
+static u32 s_mbWakeSlots[1];
+static volatile u64 s_wakeStamp;
+
+static vu32 s_benchSink;
+
+static u64 _benchGetNsec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void _benchReportNsec(const char* name, unsigned num_ops, u64 elapsed)
+{
+	printf("%-20s %10u ops %12.1f ns/op\n", name, num_ops, (double)elapsed / num_ops);
+}
+
+static void _benchReport(const char* name, unsigned num_ops, u64 start)
+{
+	_benchReportNsec(name, num_ops, _benchGetNsec() - start);
+}
+
+static void _benchReportThroughput(const char* name, unsigned num_msgs, unsigned num_bytes, u64 start)
+{
+	double secs = (_benchGetNsec() - start) / 1e9;
+	printf("%-20s %10u msgs %12.0f msgs/s %12.0f bytes/s\n", name, num_msgs, num_msgs / secs, num_bytes / secs);
+}
+
+static void _benchStartPeer(ThreadFunc fn, void* arg, u8 prio)
+{
+	threadPrepare(&s_peerThread, fn, arg, &s_peerStack[BENCH_STACK_SZ], prio);
+	threadStart(&s_peerThread);
+}
+
+static int _benchYieldPeer(void* arg)
+{
+	for (unsigned i = 0; i < s_numIters; i ++) {
+		threadYield();
+	}
+	return 0;
+}
+
+static void _benchYield(void)
+{
+	// Both threads have the same priority, so every yield is a context switch
+	_benchStartPeer(_benchYieldPeer, NULL, MAIN_THREAD_PRIO);
+
+	u64 start = _benchGetNsec();
+	for (unsigned i = 0; i < s_numIters; i ++) {
+		threadYield();
+	}
+	threadJoin(&s_peerThread);
+	_benchReport("thread_yield", 2*s_numIters, start);
+}
+
+static void _benchMutex(void)
+{
+	Mutex m = {};
+
+	u64 start = _benchGetNsec();
+	for (unsigned i = 0; i < s_numIters; i ++) {
+		mutexLock(&m);
+		mutexUnlock(&m);
+	}
+	_benchReport("mutex_lock_unlock", s_numIters, start);
+}
+
+static int _benchMailboxPeer(void* arg)
+{
+	for (unsigned i = 0; i < s_numIters; i ++) {
+		mailboxTrySend(&s_mbPong, mailboxRecv(&s_mbPing));
+	}
+	return 0;
+}
+
+static void _benchMailbox(void)
+{
+	mailboxPrepare(&s_mbPing, s_mbPingSlots, 1);
+	mailboxPrepare(&s_mbPong, s_mbPongSlots, 1);
+	_benchStartPeer(_benchMailboxPeer, NULL, MAIN_THREAD_PRIO);
+
+	u64 start = _benchGetNsec();
+	for (unsigned i = 0; i < s_numIters; i ++) {
+		mailboxTrySend(&s_mbPing, i);
+		if (mailboxRecv(&s_mbPong) != i) {
+			printf("mailbox_roundtrip: bad reply\n");
+			abort();
+		}
+	}
+	threadJoin(&s_peerThread);
+	_benchReport("mailbox_roundtrip", s_numIters, start);
+}
+
+static void _benchPxiRpc(void)
+{
+	u64 start = _benchGetNsec();
+	for (unsigned i = 0; i < s_numIters; i ++) {
+		u32 imm = i & 0xffff;
+		if (pxiSendAndReceive(BENCH_CH_ECHO, imm) != imm + 1) {
+			printf("pxi_rpc: bad reply\n");
+			abort();
+		}
+	}
+	_benchReport("pxi_rpc", s_numIters, start);
+}
+
+static void _benchPxiDoorbell(void)
+{
+	u64 start = _benchGetNsec();
+	for (unsigned i = 0; i < s_numIters; i ++) {
+		pxiDoorbellRing(BENCH_DB_PING);
+		pxiDoorbellWait(BENCH_DB_PONG);
+	}
+	_benchReport("pxi_doorbell", s_numIters, start);
+}
+
+static void _benchIrqToThread(void)
+{
+	// The ARM7 timestamps each message right before sending it. The message
+	// goes through the PXI receive interrupt and a mailbox to this thread.
+	mailboxPrepare(&s_mbWake, s_mbWakeSlots, 1);
+	pxiSetMailbox(BENCH_CH_WAKE, &s_mbWake);
+
+	u64 total = 0;
+	for (unsigned i = 0; i < s_numIters; i ++) {
+		pxiSend(BENCH_CH_WAKE, 0);
+		mailboxRecv(&s_mbWake);
+		total += _benchGetNsec() - s_wakeStamp;
+	}
+	_benchReportNsec("pxi_irq_to_thread", s_numIters, total);
+}
+
+static void _benchPxiStream(const char* name, PxiRing* r, unsigned num_data_words)
+{
+	// One-way stream of messages to a handler on the ARM7, which rings a
+	// doorbell once it has received every word
+	static const u32 payload[BENCH_STREAM_WORDS] = {};
+	unsigned num_msgs = s_numIters;
+	unsigned num_words = num_msgs * (1 + num_data_words);
+	pxiSendAndReceive(BENCH_CH_CTRL, num_words);
+
+	u64 start = _benchGetNsec();
+	for (unsigned i = 0; i < num_msgs; i ++) {
+		u16 imm = i & 0xffff;
+		if (!r) {
+			if (num_data_words) {
+				pxiSendWithData(BENCH_CH_SINK, imm, payload, num_data_words);
+			} else {
+				pxiSend(BENCH_CH_SINK, imm);
+			}
+		} else {
+			if (num_data_words) {
+				pxiRingSendWithData(r, BENCH_CH_SINK, imm, payload, num_data_words);
+			} else {
+				pxiRingSend(r, BENCH_CH_SINK, imm);
+			}
+			if ((i % BENCH_RING_BATCH) == BENCH_RING_BATCH-1) {
+				pxiRingCommit(r);
+			}
+		}
+	}
+
+	if (r) {
+		pxiRingCommit(r);
+	}
+
+	while (s_sinkWords != num_words) {
+		pxiDoorbellWait(BENCH_DB_DONE);
+	}
+
+	_benchReportThroughput(name, num_msgs, num_words*4, start);
+}
+
+static void _benchPxiThroughput(void)
+{
+	pxiRingInit(&s_benchRing, s_benchRingBuf, BENCH_RING_WORDS);
+
+	_benchPxiStream("pxi_fifo_1w", NULL, 0);
+	_benchPxiStream("pxi_ring_1w", &s_benchRing, 0);
+	_benchPxiStream("pxi_fifo_9w", NULL, BENCH_STREAM_WORDS);
+	_benchPxiStream("pxi_ring_9w", &s_benchRing, BENCH_STREAM_WORDS);
+}
+
+static void _benchFugu(void)
+{
+	// Software baseline for the secure area: per-block C implementation
+	// (the host build has no ARM assembly, see bench/arm_bench.py for that)
+	static FuguState state;
+	static u32 buf[BENCH_SECURE_AREA_SZ/4];
+	srand(1);
+	for (unsigned i = 0; i < sizeof(state)/4; i ++) {
+		((u32*)&state)[i] = rand();
+	}
+
+	unsigned num_iters = s_numIters / 100 + 1;
+	u64 start = _benchGetNsec();
+	for (unsigned i = 0; i < num_iters; i ++) {
+		for (unsigned j = 0; j < BENCH_SECURE_AREA_SZ/4; j += 2) {
+			fuguDecrypt(&state, &buf[j]);
+		}
+	}
+	_benchReport("fugu_decrypt_2k", num_iters, start);
+
+	u32 key[3] = { 1, 2, 3 };
+	start = _benchGetNsec();
+	for (unsigned i = 0; i < num_iters; i ++) {
+		fuguKeySchedule(&state, key, 3);
+	}
+	_benchReport("fugu_key_schedule", num_iters, start);
+}
+
+static u32 _benchSoftSqrt64(u64 x)
+{
+	// Bit-by-bit integer square root, as used when no square root unit is available
+	u64 ret = 0, bit = 1ULL << 62;
+	while (bit > x) {
+		bit >>= 2;
+	}
+
+	while (bit) {
+		if (x >= ret + bit) {
+			x -= ret + bit;
+			ret = (ret >> 1) + bit;
+		} else {
+			ret >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return (u32)ret;
+}
+
+static void _benchDivSqrt(void)
+{
+	// Software baselines for the ARM9 divider and square root units (hwDiv32/64,
+	// hwSqrt32/64 need real hardware). Inputs are volatile so that the compiler
+	// cannot strength-reduce the operations away.
+	static volatile s64 num = 0x123456789abcdefLL, den = 12345;
+	u32 acc = 0;
+
+	u64 start = _benchGetNsec();
+	for (unsigned i = 0; i < s_numIters; i ++) {
+		acc += (s32)num / (s32)den + (s32)num % (s32)den;
+	}
+	_benchReport("soft_div32", s_numIters, start);
+
+	start = _benchGetNsec();
+	for (unsigned i = 0; i < s_numIters; i ++) {
+		acc += num / den + num % den;
+	}
+	_benchReport("soft_div64", s_numIters, start);
+
+	start = _benchGetNsec();
+	for (unsigned i = 0; i < s_numIters; i ++) {
+		acc += _benchSoftSqrt64((u32)num);
+	}
+	_benchReport("soft_sqrt32", s_numIters, start);
+
+	start = _benchGetNsec();
+	for (unsigned i = 0; i < s_numIters; i ++) {
+		acc += _benchSoftSqrt64(num);
+	}
+	_benchReport("soft_sqrt64", s_numIters, start);
+
+	s_benchSink = acc;
+}
+
+static void _benchSleep(void)
+{
+	// Measures the latency of the tick timer, so a few iterations are enough
+	unsigned num_iters = 100;
+
+	u64 start = _benchGetNsec();
+	for (unsigned i = 0; i < num_iters; i ++) {
+		threadSleep(100);
+	}
+	_benchReport("thread_sleep_100us", num_iters, start);
+}
+
+static int _benchArm9Main(void)
+{
+	pxiWaitRemote(BENCH_CH_ECHO);
+	pxiWaitRemote(BENCH_CH_SINK);
+	pxiWaitRemote(BENCH_CH_CTRL);
+	pxiWaitRemote(BENCH_CH_WAKE);
+
+	_benchYield();
+	_benchMutex();
+	_benchMailbox();
+	_benchPxiRpc();
+	_benchPxiDoorbell();
+	_benchIrqToThread();
+	_benchPxiThroughput();
+	_benchFugu();
+	_benchDivSqrt();
+	_benchSleep();
+
+	return 0;
+}
+
+static void _benchEchoHandler(void* user, u32 data)
+{
+	pxiReply(BENCH_CH_ECHO, data + 1);
+}
+
+static void _benchWakeHandler(void* user, u32 data)
+{
+	s_wakeStamp = _benchGetNsec();
+	pxiSend(BENCH_CH_WAKE, data);
+}
+
+static void _benchSinkHandler(void* user, u32 data)
+{
+	// Called once for each word (including the data words of extended messages)
+	if (++s_sinkWords == s_sinkTarget) {
+		pxiDoorbellRing(BENCH_DB_DONE);
+	}
+}
+
+static void _benchCtrlHandler(void* user, u32 data)
+{
+	static bool ring_attached;
+	if (!ring_attached) {
+		// The ARM9 prepares the ring before sending the first control message
+		ring_attached = pxiRingAttach(&s_benchRing);
+	}
+
+	s_sinkWords = 0;
+	s_sinkTarget = data;
+	pxiReply(BENCH_CH_CTRL, 0);
+}
+
+static int _benchArm7Main(void)
+{
+	pxiSetHandler(BENCH_CH_ECHO, _benchEchoHandler, NULL);
+	pxiSetHandler(BENCH_CH_SINK, _benchSinkHandler, NULL);
+	pxiSetHandler(BENCH_CH_CTRL, _benchCtrlHandler, NULL);
+	pxiSetHandler(BENCH_CH_WAKE, _benchWakeHandler, NULL);
+
+	for (;;) {
+		pxiDoorbellWait(BENCH_DB_PING);
+		pxiDoorbellRing(BENCH_DB_PONG);
+	}
+
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1) {
+		s_numIters = strtoul(argv[1], NULL, 0);
+		if (!s_numIters) {
+			fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	return hostRun(_benchArm9Main, _benchArm7Main);
+}
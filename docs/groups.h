@@ -55,9 +55,21 @@
 	/*! @defgroup tick Tick
 		@brief Timed event scheduling
 	*/
+	/*! @defgroup alloc Allocators
+		@brief Memory allocation facilities
+	*/
+	/*! @defgroup decomp Decompression
+		@brief Decoders for BIOS compression formats
+	*/
 
 //! @}
 
+#ifdef CALICO_HOST
+/*! @defgroup host Host simulator
+	@brief Running the system core and PXI on a Linux host
+*/
+#endif
+
 /*! @defgroup hw Hardware
 	@brief Low-level system devices
 	@{
@@ -121,6 +133,11 @@
 	/*! @defgroup blkdev Storage
 		@brief Block device access
 	*/
+#ifdef ARM9
+	/*! @defgroup crypto Crypto
+		@brief DSi AES engine access
+	*/
+#endif
 #ifdef ARM9
 	/*! @defgroup ovl Overlays
 		@brief DS ROM overlay loading and activation
@@ -29,6 +29,8 @@
 #include "calico/nds/mm_env.h"
 #include "calico/nds/io.h"
 #include "calico/dev/dldi_defs.h"
+#elif defined(CALICO_HOST)
+// The host simulator has no memory mapped hardware
 #else
 #error "Unknown/unsupported platform"
 #endif
@@ -36,6 +38,7 @@
 #if !__ASSEMBLER__
 
 #include "calico/arm/common.h"
+#include "calico/arm/aes.h"
 #if __ARM_ARCH >= 5
 #include "calico/arm/cache.h"
 #include "calico/arm/mpu.h"
@@ -47,10 +50,20 @@
 #include "calico/system/mutex.h"
 #include "calico/system/condvar.h"
 #include "calico/system/mailbox.h"
+#include "calico/system/seqlock.h"
+#include "calico/system/mempool.h"
+#include "calico/system/rheap.h"
+#include "calico/system/tlsf.h"
+#include "calico/system/decompress.h"
 #include "calico/system/dietprint.h"
 
 #include "calico/dev/fugu.h"
 
+#if defined(CALICO_HOST)
+#include "calico/host/sim.h"
+#include "calico/nds/pxi.h"
+#endif
+
 #if defined(__GBA__)
 #include "calico/gba/bios.h"
 #include "calico/gba/keypad.h"
@@ -70,6 +83,8 @@
 #include "calico/nds/tlnc.h"
 #include "calico/nds/pxi.h"
 #include "calico/nds/smutex.h"
+#include "calico/nds/shmem.h"
+#include "calico/nds/fastmem.h"
 #include "calico/nds/keypad.h"
 #include "calico/nds/touch.h"
 #include "calico/nds/lcd.h"
@@ -118,10 +133,13 @@
 #include "calico/nds/arm9/arm7_debug.h"
 #include "calico/nds/arm9/sound.h"
 #include "calico/nds/arm9/mic.h"
+#include "calico/nds/arm9/aes.h"
 
+#include "calico/nds/arm9/divsqrt.h"
 #include "calico/nds/arm9/vram.h"
 
 #include "calico/nds/arm9/ovl.h"
+#include "calico/nds/arm9/mpuwin.h"
 #endif
 
 #endif
@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#include "../types.h"
+
+/*! @addtogroup arm
+	@{
+*/
+/*! @name Software AES
+	Table-based AES implementation written in ARM assembly, usable on both
+	CPUs regardless of the availability of the DSi AES engine.
+
+	The bulk mode functions accept buffers of any alignment, and process any
+	number of whole blocks in a single call. In-place operation (`in == out`)
+	is supported.
+	@{
+*/
+
+#define ARM_AES_BLOCK_SZ   16 //!< Size of an AES block in bytes
+#define ARM_AES_MAX_ROUNDS 14 //!< Maximum number of AES rounds (AES-256)
+
+MK_EXTERN_C_START
+
+//! AES key schedule
+typedef struct ArmAesContext {
+	alignas(4) u8 round_keys[1+ARM_AES_MAX_ROUNDS][ARM_AES_BLOCK_SZ]; //!< @private
+	u32 num_rounds; //!< @private
+} ArmAesContext;
+
+//! @brief Expands the @p bits -bit (128, 192 or 256) @p key into encryption key schedule @p ctx
+MK_EXTERN32 void armAesSetEncryptKey(const void* key, unsigned bits, ArmAesContext* ctx);
+
+//! @brief Expands the @p bits -bit (128, 192 or 256) @p key into decryption key schedule @p ctx
+MK_EXTERN32 void armAesSetDecryptKey(const void* key, unsigned bits, ArmAesContext* ctx);
+
+//! @brief Encrypts a single block @p in into @p out using encryption key schedule @p ctx
+MK_EXTERN32 void armAesEncrypt(const void* in, void* out, ArmAesContext const* ctx);
+
+//! @brief Decrypts a single block @p in into @p out using decryption key schedule @p ctx
+MK_EXTERN32 void armAesDecrypt(const void* in, void* out, ArmAesContext const* ctx);
+
+/*! @brief Encrypts or decrypts @p num_blocks blocks in CTR mode
+	@param[inout] ctr 128-bit big-endian counter block, updated to point past the last processed block
+	@param[in] ctx Encryption key schedule (also used for decryption)
+*/
+MK_EXTERN32 void armAesCtrCrypt(const void* in, void* out, size_t num_blocks, void* ctr, ArmAesContext const* ctx);
+
+/*! @brief Encrypts @p num_blocks blocks in CBC mode
+	@param[inout] iv Initialization vector, updated to the last ciphertext block
+	@param[in] ctx Encryption key schedule
+*/
+MK_EXTERN32 void armAesCbcEncrypt(const void* in, void* out, size_t num_blocks, void* iv, ArmAesContext const* ctx);
+
+/*! @brief Decrypts @p num_blocks blocks in CBC mode
+	@param[inout] iv Initialization vector, updated to the last ciphertext block
+	@param[in] ctx Decryption key schedule
+*/
+MK_EXTERN32 void armAesCbcDecrypt(const void* in, void* out, size_t num_blocks, void* iv, ArmAesContext const* ctx);
+
+/*! @brief Updates a CBC-MAC value with @p num_blocks blocks of data
+	@param[inout] mac Current MAC value (all zeroes initially)
+	@param[in] ctx Encryption key schedule
+*/
+MK_EXTERN32 void armAesCbcMac(const void* in, size_t num_blocks, void* mac, ArmAesContext const* ctx);
+
+/*! @brief Encrypts and authenticates data using AES-CCM (as per NIST SP 800-38C)
+	@param[in] ctx Encryption key schedule
+	@param[in] nonce Nonce (7 to 13 bytes long, see @p nonce_len)
+	@param[in] aad Additional authenticated data (not encrypted), can be NULL if @p aad_len is 0
+	@param[in] in Plaintext (any size)
+	@param[out] out Ciphertext (same size as plaintext)
+	@param[out] tag Authentication tag (even size between 4 and 16 bytes, see @p tag_len)
+	@return false if the parameters are invalid, true otherwise
+*/
+bool armAesCcmEncrypt(ArmAesContext const* ctx, const void* nonce, size_t nonce_len,
+	const void* aad, size_t aad_len, const void* in, void* out, size_t len, void* tag, size_t tag_len);
+
+/*! @brief Decrypts and verifies data using AES-CCM (as per NIST SP 800-38C)
+	@param[in] ctx Encryption key schedule (CCM only uses the AES forward function)
+	@return true if the authentication tag is valid, false otherwise
+	@warning On failure, the contents of @p out must be discarded.
+	@see armAesCcmEncrypt
+*/
+bool armAesCcmDecrypt(ArmAesContext const* ctx, const void* nonce, size_t nonce_len,
+	const void* aad, size_t aad_len, const void* in, void* out, size_t len, const void* tag, size_t tag_len);
+
+MK_EXTERN_C_END
+
+//! @}
+
+//! @}
@@ -27,7 +27,9 @@ MK_EXTERN_C_START
 */
 void armDrainWriteBuffer(void);
 
-//! @brief Flushes (cleans and invalidates) the entire data cache
+/*! @brief Flushes (cleans and invalidates) the entire data cache
+	@note Locked down ways (see @ref armDCacheLockRange) are cleaned, but not invalidated.
+*/
 void armDCacheFlushAll(void);
 
 /*! @brief Flushes (cleans and invalidates) the data cache lines pertaining to the specified address range
@@ -36,6 +38,7 @@ void armDCacheFlushAll(void);
 	@note Use this function when sharing a main RAM memory buffer with the ARM7, or with DMA/devices.
 	@note Consider using @ref armDCacheFlushAll when `size` is large.
 	As an example, the 3DS ARM9 kernel uses 16 KiB as the threshold.
+	@warning Lines of the range that belong to a locked down way (see @ref armDCacheLockRange) are discarded from it.
 */
 void armDCacheFlush(const volatile void* addr, size_t size);
 
@@ -48,7 +51,10 @@ void armDCacheFlush(const volatile void* addr, size_t size);
 */
 void armDCacheInvalidate(const volatile void* addr, size_t size);
 
-//! @brief Invalidates the entire instruction cache
+/*! @brief Invalidates the entire instruction cache
+	@warning This also discards the contents of locked down ways (see @ref armICacheLockRange),
+	which need to be unlocked and locked again afterwards.
+*/
 void armICacheInvalidateAll(void);
 
 /*! @brief Invalidates the instruction cache lines pertaining to the specified address range
@@ -59,6 +65,53 @@ void armICacheInvalidateAll(void);
 */
 void armICacheInvalidate(const volatile void* addr, size_t size);
 
+/*! @name Cache lockdown
+	The data and instruction caches are each split into @ref ARM_DCACHE_WAYS ways
+	(of @ref ARM_CACHE_LINE_SZ byte lines), out of which all but one can be locked down.
+	Locked down ways are never evicted, meaning the memory they hold is always accessed
+	at cache speed. This is useful for hot code and lookup tables that are too large for TCM.
+
+	Ways are locked and unlocked in stack order: each call to a LockRange function locks the
+	next available way, whereas unlocking a way also unlocks all ways locked after it.
+	@warning The following operations discard cache lines that belong to a locked down way,
+	which are then not reloaded into it (the memory they hold is no longer locked):
+	- @ref armDCacheFlush (clean and invalidate by address)
+	- @ref armDCacheInvalidate
+	- @ref armICacheInvalidate
+	- @ref armICacheInvalidateAll (discards the contents of all locked down instruction cache ways)
+	- Library functions that flush or invalidate a buffer passed to them (for example, before a DMA transfer)
+
+	Only @ref armDCacheFlushAll preserves locked down ways (their lines are cleaned, but not invalidated).
+	@{
+*/
+
+/*! @brief Preloads the data cache lines of the specified address range, and locks them down
+	@param addr Start address (any pointer type)
+	@param size Size of the address range (at most `ARM_DCACHE_SZ/ARM_DCACHE_WAYS` bytes after alignment)
+	@return Index of the locked down way (to be passed to @ref armDCacheUnlock), or -1 on failure
+	@note The memory must lie within a cacheable MPU region.
+*/
+int armDCacheLockRange(const volatile void* addr, size_t size);
+
+/*! @brief Unlocks data cache way @p way, as well as all ways locked down after it
+	@note The contents of the unlocked ways become regular cache lines, no data is lost.
+*/
+void armDCacheUnlock(unsigned way);
+
+/*! @brief Preloads the instruction cache lines of the specified address range, and locks them down
+	@param addr Start address (any pointer type)
+	@param size Size of the address range (at most `ARM_ICACHE_SZ/ARM_ICACHE_WAYS` bytes after alignment)
+	@return Index of the locked down way (to be passed to @ref armICacheUnlock), or -1 on failure
+	@note The memory must lie within a cacheable MPU region. If the code was just written,
+	use @ref armDCacheFlush on it beforehand.
+*/
+int armICacheLockRange(const volatile void* addr, size_t size);
+
+//! @brief Unlocks instruction cache way @p way, as well as all ways locked down after it
+void armICacheUnlock(unsigned way);
+
+//! @}
+
 MK_EXTERN_C_END
 
 //! @}
@@ -45,7 +45,7 @@ MK_INLINE void armSoftBreakpoint(void)
 	__asm__ __volatile__ ("mov r11, r11");
 }
 
-#if !__thumb__
+#if !__thumb__ && !defined(CALICO_HOST)
 
 //! @brief Retrieves the value of the Current Program Status Register
 MK_EXTINLINE u32 armGetCpsr(void)
@@ -151,12 +151,14 @@ MK_EXTINLINE void armIrqUnlockByPsr(ArmIrqState st)
 
 #else
 
+// THUMB code calls out-of-line ARM versions of the above. The host simulator
+// implements them on top of a simulated CPSR (see source/host/cpu.c).
 MK_EXTERN32 u32 armGetCpsr(void);
 MK_EXTERN32 void armSetCpsrC(u32 value);
 MK_EXTERN32 u32 armGetSpsr(void);
 MK_EXTERN32 void armSetSpsr(u32 value);
-MK_EXTERN32 u32 armSwapWord(u32 value, u32* addr);
-MK_EXTERN32 u8 armSwapByte(u8 value, u8* addr);
+MK_EXTERN32 u32 armSwapWord(u32 value, vu32* addr);
+MK_EXTERN32 u8 armSwapByte(u8 value, vu8* addr);
 
 #if __ARM_ARCH >= 5
 MK_EXTERN32 void armWaitForIrq(void);
@@ -27,6 +27,12 @@
 //! @brief Number of ways on the on the DS/3DS's Arm9 CPU
 #define ARM_DCACHE_WAYS 4
 
+//! @brief Log2(number of ways) on the DS/3DS Arm9 CPU's instruction cache
+#define ARM_ICACHE_WAYS_LOG2 2
+
+//! @brief Number of ways on the DS/3DS Arm9 CPU's instruction cache
+#define ARM_ICACHE_WAYS 4
+
 //! @brief Number of index bits (= log2(number of sets)) on the DS/3DS's Arm9 CPU
 #define ARM_DCACHE_NUM_INDEX_BITS (ARM_DCACHE_LOG2 - ARM_DCACHE_WAYS_LOG2 - ARM_CACHE_LINE_LOG2)
 
@@ -67,6 +67,199 @@ bool blkDevReadSectors(BlkDevice dev, void* buffer, u32 first_sector, u32 num_se
 */
 bool blkDevWriteSectors(BlkDevice dev, const void* buffer, u32 first_sector, u32 num_sectors);
 
+/*! @name Request queue statistics
+	Sector read and write requests sent by the ARM9 are queued by the ARM7. All
+	requests that are pending at the same time are serviced in ascending sector
+	order (reordering is never done across overlapping requests when either of them
+	is a write), and requests that are contiguous both on the device and in memory
+	are merged into a single device command. The statistics below can be used
+	to find out how effective this is for a given workload.
+	@{
+*/
+
+//! Block device request queue statistics
+typedef struct BlkQueueStats {
+	u32 num_requests; //!< Number of sector read/write requests received from the ARM9
+	u32 num_merged;   //!< Number of requests that were merged into another request
+	u16 cur_depth;    //!< Number of requests currently queued or being processed
+	u16 max_depth;    //!< Highest value @ref cur_depth has ever reached
+} BlkQueueStats;
+
+/*! @brief Retrieves request queue statistics of block device @p dev into @p out
+	@return true on success, false if @p dev is not a valid device
+	@note @ref BlkDevice_TwlNand and @ref BlkDevice_TwlNandAes share the same statistics.
+*/
+bool blkDevGetQueueStats(BlkDevice dev, BlkQueueStats* out);
+
+//! @}
+
+#if defined(__NDS__) && defined(ARM9)
+
+/*! @name Asynchronous block device requests
+	Sector reads and writes can be submitted without waiting for them to complete,
+	allowing the calling thread to continue working while the ARM7 carries out
+	the transfer. Several requests can be in flight at the same time (up to
+	@ref PXI_NUM_TAGS, shared with other users of tagged PXI requests), which
+	are queued by the ARM7 and may complete out of submission order (see
+	@ref blkDevGetQueueStats).
+
+	Completion can be detected by polling (@ref blkRequestIsDone), by blocking
+	(@ref blkRequestWait), by posting the request pointer to a @ref Mailbox,
+	and/or by invoking a callback.
+	@{
+*/
+
+// Forward declarations
+struct Mailbox;
+typedef struct BlkRequest BlkRequest;
+
+//! States of an asynchronous block device request
+typedef enum BlkRequestState {
+	BlkRequestState_Pending = 0, //!< The request has not completed yet
+	BlkRequestState_Success = 1, //!< The request completed successfully
+	BlkRequestState_Failure = 2, //!< The request failed
+} BlkRequestState;
+
+/*! @brief Asynchronous block device request completion callback
+	@warning The callback runs in IRQ mode - exercise caution!
+	See @ref IrqHandler for more details on how to write IRQ mode handlers.
+*/
+typedef void (*BlkRequestFn)(BlkRequest* req);
+
+//! Asynchronous block device request object
+struct BlkRequest {
+	BlkRequestFn callback;   //!< Optional callback invoked on completion
+	struct Mailbox* mailbox; //!< Optional mailbox to which the request pointer is posted on completion
+	void* user;              //!< User data
+	volatile u32 state;      //!< Current state (see @ref BlkRequestState)
+};
+
+/*! @brief Starts reading sectors from block device @p dev
+	@param[in] req Request object. Its callback, mailbox and user fields must be set beforehand
+	@return true if the request was submitted, false on failure (in which case no completion is signalled)
+	@note The same rules as @ref blkDevReadSectors apply to the other parameters. The contents
+	of the buffer are undefined until the request has completed. The request object must
+	remain valid until then.
+*/
+bool blkDevReadSectorsAsync(BlkRequest* req, BlkDevice dev, void* buffer, u32 first_sector, u32 num_sectors);
+
+/*! @brief Starts writing sectors to block device @p dev
+	@param[in] req Request object. Its callback, mailbox and user fields must be set beforehand
+	@return true if the request was submitted, false on failure (in which case no completion is signalled)
+	@note The same rules as @ref blkDevWriteSectors apply to the other parameters. The buffer
+	must not be modified until the request has completed, and the request object must remain
+	valid until then.
+*/
+bool blkDevWriteSectorsAsync(BlkRequest* req, BlkDevice dev, const void* buffer, u32 first_sector, u32 num_sectors);
+
+//! Returns true if asynchronous request @p req has completed
+MK_INLINE bool blkRequestIsDone(BlkRequest* req)
+{
+	return req->state != BlkRequestState_Pending;
+}
+
+//! Waits for asynchronous request @p req to complete, returning true on success
+bool blkRequestWait(BlkRequest* req);
+
+//! @}
+
+/*! @name Sector cache
+	An optional write-back cache of recently used sectors can be enabled for each
+	block device. Small reads that hit the cache are served with a memory copy
+	instead of a round trip to the ARM7 and the device, which greatly benefits
+	filesystem metadata (FAT, directory entries) that is accessed repeatedly.
+	Sectors are evicted in least recently used order.
+
+	Small writes are only recorded in the cache, and reach the device when the
+	sector is evicted or when @ref blkCacheFlush is called. Requests larger than
+	a quarter of the cache bypass it (while remaining coherent with its contents),
+	so that bulk transfers do not evict the working set.
+	@warning Cached writes are lost if the device is removed or the system is
+	powered off before they are flushed. Asynchronous requests write back or drop
+	overlapping cached sectors before they are submitted, but are not cached themselves.
+	@{
+*/
+
+//! Minimum number of sectors that can be cached per block device (requests of up to a quarter of this are cached)
+#define BLK_CACHE_MIN_SECTORS 4
+
+//! Maximum number of sectors that can be cached per block device (2 MiB)
+#define BLK_CACHE_MAX_SECTORS 4096
+
+//! Sector cache statistics
+typedef struct BlkCacheStats {
+	u32 num_hits;       //!< Number of sectors served by the cache
+	u32 num_misses;     //!< Number of sectors that had to be read from (or allocated for writing to) the device
+	u32 num_writebacks; //!< Number of dirty sectors written back to the device
+	u32 num_bypassed;   //!< Number of requests that were too large to go through the cache
+	u16 num_sectors;    //!< Capacity of the cache in sectors
+	u16 num_dirty;      //!< Number of sectors currently awaiting write back
+} BlkCacheStats;
+
+/*! @brief Configures the sector cache of block device @p dev
+	@param[in] num_sectors Number of sectors to cache (between @ref BLK_CACHE_MIN_SECTORS and
+	@ref BLK_CACHE_MAX_SECTORS), or 0 to disable the cache
+	@return true on success, false on failure
+	@note Any previously existing cache is flushed and released beforehand.
+	@note @ref BlkDevice_TwlNand and @ref BlkDevice_TwlNandAes refer to the same
+	physical sectors, and only one of them can be cached at a time. Accesses through
+	the other view write back (reads) or drop (writes) the overlapping cached sectors.
+*/
+bool blkCacheSetup(BlkDevice dev, unsigned num_sectors);
+
+//! Writes back all dirty sectors cached for block device @p dev, returning true on success
+bool blkCacheFlush(BlkDevice dev);
+
+/*! @brief Retrieves sector cache statistics of block device @p dev into @p out
+	@return true on success, false if @p dev does not have a sector cache
+*/
+bool blkCacheGetStats(BlkDevice dev, BlkCacheStats* out);
+
+//! @}
+
+/*! @name Sequential readahead
+	Optional per-device readahead, which detects sequential read patterns (such as
+	streaming a file a few sectors at a time) and turns them into fewer, larger
+	device reads. When a read continues where the previous one left off, a window
+	of sectors starting at the request is read into a readahead buffer in a single
+	request, and subsequent sequential reads are served from it with a memory copy.
+	The window starts small and doubles on every refill up to the configured
+	maximum, and is reset whenever a non-sequential read is detected.
+
+	Readahead sits below the @ref blkCacheSetup "sector cache" (misses of which are
+	also subject to readahead), and is kept coherent with all writes to the device.
+	Only one sequential stream is tracked per device.
+	@{
+*/
+
+#define BLK_READAHEAD_MIN_SECTORS 8    //!< Minimum (and initial) readahead window in sectors
+#define BLK_READAHEAD_MAX_SECTORS 1024 //!< Maximum readahead window in sectors (512 KiB)
+
+//! Sequential readahead statistics
+typedef struct BlkReadaheadStats {
+	u32 num_hits;       //!< Number of sectors served from the readahead buffer
+	u32 num_fills;      //!< Number of readahead device reads
+	u32 num_prefetched; //!< Number of sectors read ahead of the requests that triggered a refill
+	u32 cur_window;     //!< Current readahead window in sectors (0 if no sequential pattern is detected)
+	u32 max_sectors;    //!< Maximum readahead window in sectors
+} BlkReadaheadStats;
+
+/*! @brief Configures sequential readahead for block device @p dev
+	@param[in] max_sectors Maximum readahead window in sectors (up to @ref BLK_READAHEAD_MAX_SECTORS),
+	or 0 to disable readahead. A buffer of this size is allocated from the heap.
+	@return true on success, false on failure
+*/
+bool blkReadaheadSetup(BlkDevice dev, unsigned max_sectors);
+
+/*! @brief Retrieves readahead statistics of block device @p dev into @p out
+	@return true on success, false if readahead is not enabled for @p dev
+*/
+bool blkReadaheadGetStats(BlkDevice dev, BlkReadaheadStats* out);
+
+//! @}
+
+#endif
+
 MK_EXTERN_C_END
 
 //! @}
@@ -24,6 +24,10 @@ MK_EXTERN32 void fuguKeySchedule(FuguState* state, const u32* key, unsigned key_
 MK_EXTERN32 void fuguEncrypt(FuguState const* state, u32 buf[2]);
 MK_EXTERN32 void fuguDecrypt(FuguState const* state, u32 buf[2]);
 
+// Bulk ECB versions of the above, processing num_blocks 8-byte blocks (in-place operation is allowed)
+MK_EXTERN32 void fuguEncryptBlocks(FuguState const* state, const u32* in, u32* out, size_t num_blocks);
+MK_EXTERN32 void fuguDecryptBlocks(FuguState const* state, const u32* in, u32* out, size_t num_blocks);
+
 MK_INLINE void fuguNtrInit(FuguNtr* ctx, const void* initial_state, u32 key)
 {
 	armCopyMem32(&ctx->state, initial_state, sizeof(ctx->state));
@@ -10,9 +10,11 @@
 #define SDMMC_CMD_MMC_SET_RELATIVE_ADDR (TMIO_CMD_INDEX(3)  | TMIO_CMD_RESP_48)
 #define SDMMC_CMD_SD_GET_RELATIVE_ADDR  (TMIO_CMD_INDEX(3)  | TMIO_CMD_RESP_48)
 #define SDMMC_CMD_MMC_SWITCH            (TMIO_CMD_INDEX(6)  | TMIO_CMD_RESP_48_BUSY)
+#define SDMMC_CMD_SD_SWITCH_FUNC        (TMIO_CMD_INDEX(6)  | TMIO_CMD_RESP_48 | TMIO_CMD_TX | TMIO_CMD_TX_READ)
 #define SDMMC_CMD_SELECT_CARD           (TMIO_CMD_INDEX(7)  | TMIO_CMD_RESP_48_BUSY)
 #define SDMMC_CMD_SET_IF_COND           (TMIO_CMD_INDEX(8)  | TMIO_CMD_RESP_48)
 #define SDMMC_CMD_GET_CSD               (TMIO_CMD_INDEX(9)  | TMIO_CMD_RESP_136)
+#define SDMMC_CMD_STOP_TRANSMISSION     (TMIO_CMD_INDEX(12) | TMIO_CMD_RESP_48_BUSY)
 #define SDMMC_CMD_GET_STATUS            (TMIO_CMD_INDEX(13) | TMIO_CMD_RESP_48)
 #define SDMMC_CMD_SET_BLOCKLEN          (TMIO_CMD_INDEX(16) | TMIO_CMD_RESP_48)
 #define SDMMC_CMD_READ_MULTIPLE_BLOCK   (TMIO_CMD_INDEX(18) | TMIO_CMD_RESP_48 | TMIO_CMD_TX | TMIO_CMD_TX_READ  | TMIO_CMD_TX_MULTI)
@@ -27,6 +29,14 @@
 #define SDMMC_CMD_MMC_SWITCH_ARG(_access,_index,_value) \
 	((((_value)&0xff)<<8) | (((_index)&0xff)<<16) | (((_access)&3)<<24))
 
+// Only function group 1 (access mode) is switched, the remaining groups are left unchanged
+#define SDMMC_CMD_SD_SWITCH_FUNC_ARG(_set,_fn) \
+	((((_set)&1)<<31) | 0x00fffff0 | ((_fn)&0xf))
+
+#define SDMMC_SD_FUNC_DEFAULT_SPEED 0
+#define SDMMC_SD_FUNC_HIGH_SPEED    1
+#define SDMMC_SD_HIGH_SPEED_CLOCK   50000000
+
 #define SDMMC_SECTOR_SZ 512
 
 MK_EXTERN_C_START
@@ -45,6 +55,7 @@ typedef struct SdmmcCard {
 
 	u16 rca;
 	SdmmcType type;
+	bool is_high_speed;
 
 	TmioResp cid;
 	TmioResp csd;
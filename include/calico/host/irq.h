@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#if !defined(CALICO_HOST)
+#error "This header file is only for the host simulator"
+#endif
+
+#include "../types.h"
+#include "../arm/common.h"
+
+/*! @addtogroup irq
+	@{
+*/
+
+/*! @name Simulated interrupt controller
+	Each simulated CPU has its own copy of these registers. Interrupts raised
+	by the other CPU or by the tick timer are latched into `REG_IF`, and
+	delivered the next time the receiving CPU unmasks interrupts or goes idle.
+	Unlike on hardware, writing to `REG_IF` does not acknowledge interrupts.
+	@{
+*/
+
+//! @private
+typedef struct HostIrqRegs {
+	vu32 ime;
+	vu32 ie;
+	vu32 iflags;
+} HostIrqRegs;
+
+//! @private
+extern MK_CPU_LOCAL HostIrqRegs* __host_irq_regs;
+
+#define REG_IME (__host_irq_regs->ime)
+#define REG_IE  (__host_irq_regs->ie)
+#define REG_IF  (__host_irq_regs->iflags)
+
+//! @}
+
+/*! @name Interrupt bits
+	Only the interrupts modeled by the simulator are defined. They use the same
+	bit positions as on the NDS.
+	@{
+*/
+
+#define IRQ_TIMER0       (1U << 3)  //!< @ref timer channel 0 interrupt
+#define IRQ_TIMER1       (1U << 4)  //!< @ref timer channel 1 interrupt
+#define IRQ_TIMER2       (1U << 5)  //!< @ref timer channel 2 interrupt
+#define IRQ_TIMER3       (1U << 6)  //!< @ref timer channel 3 interrupt (used by @ref tick)
+#define IRQ_PXI_SYNC     (1U << 16) //!< @ref pxi synchronization (ping) interrupt
+#define IRQ_PXI_SEND     (1U << 17) //!< @ref pxi send interrupt
+#define IRQ_PXI_RECV     (1U << 18) //!< @ref pxi receive interrupt
+
+#define IRQ_TIMER(_x)    (1U << ( 3+(_x))) //!< @ref timer channel @p _x interrupt
+
+#define MK_IRQ_NUM_HANDLERS 32
+
+//! @}
+
+MK_EXTERN_C_START
+
+//! Saved state of `REG_IME`
+typedef unsigned IrqState;
+
+//! Interrupt mask datatype
+typedef u32 IrqMask;
+
+//! @brief Temporarily disables interrupts on the simulated interrupt controller (using `REG_IME`).
+IrqState irqLock(void);
+
+//! @brief Restores the previous interrupt @p state locked by @ref irqLock, delivering pending interrupts
+void irqUnlock(IrqState state);
+
+MK_EXTERN_C_END
+
+//! @}
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#if !defined(CALICO_HOST)
+#error "This header file is only for the host simulator"
+#endif
+
+#include "../types.h"
+
+/*! @addtogroup host
+
+	The host simulator runs calico's scheduler, synchronization primitives and
+	PXI on an ordinary Linux machine, so that they can be tested and benchmarked
+	without hardware. Each of the two CPUs is simulated by a host thread, which
+	multiplexes the calico threads of that CPU using ucontext. Both CPUs share
+	the address space (much like main RAM), and communicate through a simulated
+	PXI FIFO and IPCSYNC register.
+
+	Interrupts are not asynchronous: they are delivered when the receiving CPU
+	unmasks interrupts (including when it returns from a blocking call), or when
+	it becomes idle. Interrupt handlers run on the stack of the interrupted
+	thread. The host C library keeps its own state for each simulated CPU, so
+	thread-local storage does not need to be attached to calico threads.
+	Thread stacks must be sized for host code, as the host C library and
+	interrupt handlers use them too. The host execution context of a thread is
+	stored at the top of its stack.
+
+	@{
+*/
+
+MK_EXTERN_C_START
+
+//! Simulated CPUs
+typedef enum HostCpu {
+	HostCpu_Arm9 = 0, //!< Simulated ARM9
+	HostCpu_Arm7 = 1, //!< Simulated ARM7
+
+	HostCpu_Count, //!< @private
+} HostCpu;
+
+//! Entrypoint of a simulated CPU (equivalent to `main` on hardware)
+typedef int (* HostCpuMainFn)(void);
+
+/*! @brief Runs the simulator until the ARM9 entrypoint returns
+	@param[in] arm9_main Entrypoint of the ARM9
+	@param[in] arm7_main Entrypoint of the ARM7
+	@return Result code returned by @p arm9_main
+	@note Like on hardware, each CPU sets up its interrupt controller, threading
+	system and PXI before calling its entrypoint on the main thread. Once
+	@p arm9_main returns, the ARM7 is halted at its next interrupt delivery point.
+	The ARM7 is also halted if @p arm7_main returns.
+*/
+int hostRun(HostCpuMainFn arm9_main, HostCpuMainFn arm7_main);
+
+//! Returns the simulated CPU the caller is running on
+HostCpu hostCpuGetId(void);
+
+//! Sets the 4-bit value presented to the other CPU through the simulated IPCSYNC register
+void hostPxiSyncSend(unsigned value);
+
+//! Returns the 4-bit value presented by the other CPU through the simulated IPCSYNC register
+unsigned hostPxiSyncRecv(void);
+
+MK_EXTERN_C_END
+
+//! @}
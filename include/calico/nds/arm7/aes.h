@@ -132,4 +132,11 @@ MK_INLINE void aesSelectKeySlot(AesKeySlot slot)
 	while (REG_AES_CNT & AES_KEY_SCHEDULE_BUSY);
 }
 
+// The AES engine (along with NDMA channel 2) is shared between the DSi eMMC
+// driver and the ARM9 crypto service, and must be locked before being used
+void aesLock(void);
+void aesUnlock(void);
+
+void aesStartServer(u8 thread_prio);
+
 MK_EXTERN_C_END
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#if !defined(__NDS__) || !defined(ARM9)
+#error "This header file is only for NDS ARM9"
+#endif
+
+#include "../../types.h"
+
+/*! @addtogroup crypto
+
+	On the DSi, AES jobs are queued to the ARM7, which runs them on the hardware
+	AES engine using NDMA. In DS mode, jobs are instead processed synchronously
+	on the ARM9 using the software implementation (see @ref armAesCtrCrypt).
+
+	Keys, counters and data follow the native conventions of the DSi AES engine
+	(as used for example by eMMC and modcrypt encryption): compared to standard
+	AES-CTR, the key and counter are byte-reversed (the counter is incremented
+	as a 128-bit little endian integer), and so is each block of data.
+
+	@{
+*/
+
+#define AES_JOB_BLOCK_SZ 16 //!< Size of an AES block in bytes
+
+MK_EXTERN_C_START
+
+//! AES job states
+typedef enum AesJobState {
+	AesJobState_Idle    = 0, //!< Job has not been submitted
+	AesJobState_Pending = 1, //!< Job is queued or being processed
+	AesJobState_Done    = 2, //!< Job completed successfully
+	AesJobState_Failed  = 3, //!< Job failed
+} AesJobState;
+
+//! AES job descriptor
+typedef struct AesJob {
+	u32 key[4];              //!< @private
+	u32 ctr[4];              //!< @private
+	const void* in;          //!< @private
+	void* out;               //!< @private
+	size_t len;              //!< @private
+	struct AesJob* next;     //!< @private
+	vu8 state;               //!< @private
+} AesJob;
+
+/*! @brief Initializes the AES crypto service
+	@note On the DSi, jobs are queued to the ARM7 once its side of the service is
+	running (it is started by @ref blkInit). Until then, jobs are processed in
+	software, and so they are if this function is not called.
+*/
+void aesInit(void);
+
+/*! @brief Prepares an AES-CTR @p job
+	@param[in] key 128-bit key
+	@param[in] ctr 128-bit initial counter
+	@param[in] in Input buffer (must be word aligned)
+	@param[out] out Output buffer (must be cache line (32-<b>byte</b>) aligned, can be the same as @p in).
+	If @p len is not a multiple of the cache line size, the remainder of the last line must not hold other data
+	@param[in] len Size of the data in bytes (must be a multiple of @ref AES_JOB_BLOCK_SZ)
+	@note The key and counter are copied into the job. Since AES-CTR is symmetric,
+	this job type is used for both encryption and decryption.
+*/
+void aesJobPrepareCtr(AesJob* job, const void* key, const void* ctr, const void* in, void* out, size_t len);
+
+/*! @brief Submits a prepared @p job
+	@return true on success, false if the job is invalid
+	@note The job descriptor, as well as the input and output buffers, <b>must</b>
+	be visible to the ARM7 (i.e. located in main RAM, as opposed to DTCM), and must not
+	be accessed until the job completes. If too many jobs are in flight, this function
+	blocks until one of them completes.
+*/
+bool aesJobSubmit(AesJob* job);
+
+//! @brief Returns true if @p job is no longer pending
+MK_INLINE bool aesJobIsDone(AesJob const* job)
+{
+	return job->state != AesJobState_Pending;
+}
+
+/*! @brief Waits for a submitted @p job to complete
+	@return true if the job completed successfully, false otherwise
+*/
+bool aesJobWait(AesJob* job);
+
+/*! @brief Synchronously encrypts or decrypts data in AES-CTR mode
+	@return true on success, false on failure
+	@see aesJobPrepareCtr
+*/
+bool aesCtrCrypt(const void* key, const void* ctr, const void* in, void* out, size_t len);
+
+MK_EXTERN_C_END
+
+//! @}
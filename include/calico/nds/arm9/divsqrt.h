@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#if !defined(__NDS__) || !defined(ARM9)
+#error "This header file is only for NDS ARM9"
+#endif
+
+#include "../../types.h"
+#include "../../arm/common.h"
+#include "../io.h"
+
+/*! @addtogroup hw
+	@{
+*/
+
+/*! @name Math coprocessor (divider and square root units)
+
+	The helper functions below perform a complete operation (write the inputs,
+	wait for the result and read it back) with interrupts disabled. This means
+	that they can be safely used from any thread or interrupt handler: no other
+	context is able to observe or modify the state of the unit mid-operation,
+	and there is no need to save or restore the unit's state on context switches.
+	The interrupt-disabled window lasts for the duration of a single operation
+	(at most 34 cycles for 64-bit divisions).
+
+	@warning Code that accesses the registers directly must follow the same rule,
+	or otherwise its results (and those of the helpers) may be corrupted.
+	@{
+*/
+
+#define REG_DIVCNT    MK_REG(u32, IO_DIVCNT)
+#define REG_DIV_NUMER MK_REG(s64, IO_DIV_NUMER)
+#define REG_DIV_DENOM MK_REG(s64, IO_DIV_DENOM)
+#define REG_DIV_QUOT  MK_REG(s64, IO_DIV_QUOT)
+#define REG_DIV_REM   MK_REG(s64, IO_DIV_REM)
+
+#define REG_DIV_NUMER_L MK_REG(s32, IO_DIV_NUMER)
+#define REG_DIV_DENOM_L MK_REG(s32, IO_DIV_DENOM)
+#define REG_DIV_QUOT_L  MK_REG(s32, IO_DIV_QUOT)
+#define REG_DIV_REM_L   MK_REG(s32, IO_DIV_REM)
+
+#define REG_SQRTCNT   MK_REG(u32, IO_SQRTCNT)
+#define REG_SQRT_OUT  MK_REG(u32, IO_SQRT_OUT)
+#define REG_SQRT_IN   MK_REG(u64, IO_SQRT_IN)
+#define REG_SQRT_IN_L MK_REG(u32, IO_SQRT_IN)
+
+#define DIVCNT_MODE(_x)   ((_x)&3)
+#define DIVCNT_DIV_BY_0   (1U<<14)
+#define DIVCNT_BUSY       (1U<<15)
+
+#define SQRTCNT_MODE(_x)  ((_x)&1)
+#define SQRTCNT_BUSY      (1U<<15)
+
+MK_EXTERN_C_START
+
+//! Divider operation modes
+typedef enum DivMode {
+	DivMode_32_32 = 0, //!< 32-bit numerator, 32-bit denominator
+	DivMode_64_32 = 1, //!< 64-bit numerator, 32-bit denominator
+	DivMode_64_64 = 2, //!< 64-bit numerator, 64-bit denominator
+} DivMode;
+
+//! Square root operation modes
+typedef enum SqrtMode {
+	SqrtMode_32 = 0, //!< 32-bit input
+	SqrtMode_64 = 1, //!< 64-bit input
+} SqrtMode;
+
+//! @private
+MK_INLINE void _hwDivStart32(s32 num, s32 den)
+{
+	REG_DIVCNT = DIVCNT_MODE(DivMode_32_32);
+	REG_DIV_NUMER_L = num;
+	REG_DIV_DENOM_L = den;
+	while (REG_DIVCNT & DIVCNT_BUSY);
+}
+
+//! @private
+MK_INLINE void _hwDivStart64(s64 num, s64 den)
+{
+	REG_DIVCNT = DIVCNT_MODE(DivMode_64_64);
+	REG_DIV_NUMER = num;
+	REG_DIV_DENOM = den;
+	while (REG_DIVCNT & DIVCNT_BUSY);
+}
+
+//! Returns the quotient of the 32-bit division @p num / @p den
+MK_INLINE s32 hwDiv32(s32 num, s32 den)
+{
+	ArmIrqState st = armIrqLockByPsr();
+	_hwDivStart32(num, den);
+	s32 ret = REG_DIV_QUOT_L;
+	armIrqUnlockByPsr(st);
+	return ret;
+}
+
+//! Returns the remainder of the 32-bit division @p num / @p den
+MK_INLINE s32 hwMod32(s32 num, s32 den)
+{
+	ArmIrqState st = armIrqLockByPsr();
+	_hwDivStart32(num, den);
+	s32 ret = REG_DIV_REM_L;
+	armIrqUnlockByPsr(st);
+	return ret;
+}
+
+//! Returns the quotient of the 64-bit division @p num / @p den
+MK_INLINE s64 hwDiv64(s64 num, s64 den)
+{
+	ArmIrqState st = armIrqLockByPsr();
+	_hwDivStart64(num, den);
+	s64 ret = REG_DIV_QUOT;
+	armIrqUnlockByPsr(st);
+	return ret;
+}
+
+//! Returns the remainder of the 64-bit division @p num / @p den
+MK_INLINE s64 hwMod64(s64 num, s64 den)
+{
+	ArmIrqState st = armIrqLockByPsr();
+	_hwDivStart64(num, den);
+	s64 ret = REG_DIV_REM;
+	armIrqUnlockByPsr(st);
+	return ret;
+}
+
+//! Returns the integer square root of the 32-bit value @p x
+MK_INLINE u32 hwSqrt32(u32 x)
+{
+	ArmIrqState st = armIrqLockByPsr();
+	REG_SQRTCNT = SQRTCNT_MODE(SqrtMode_32);
+	REG_SQRT_IN_L = x;
+	while (REG_SQRTCNT & SQRTCNT_BUSY);
+	u32 ret = REG_SQRT_OUT;
+	armIrqUnlockByPsr(st);
+	return ret;
+}
+
+//! Returns the integer square root of the 64-bit value @p x
+MK_INLINE u32 hwSqrt64(u64 x)
+{
+	ArmIrqState st = armIrqLockByPsr();
+	REG_SQRTCNT = SQRTCNT_MODE(SqrtMode_64);
+	REG_SQRT_IN = x;
+	while (REG_SQRTCNT & SQRTCNT_BUSY);
+	u32 ret = REG_SQRT_OUT;
+	armIrqUnlockByPsr(st);
+	return ret;
+}
+
+MK_EXTERN_C_END
+
+//! @}
+
+//! @}
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#if !defined(__NDS__) || !defined(ARM9)
+#error "This header file is only for NDS ARM9"
+#endif
+
+#include "../../types.h"
+
+/*! @addtogroup cp15
+	@{
+*/
+/*! @name MPU windows
+	Calico's boot-time MPU layout leaves one region unused (another one is
+	reserved for the GBA slot, see @ref gbacartOpen). It can be allocated at
+	runtime in order to override the memory attributes of a given address range
+	(window), for example to make it uncached or write-through. Windows have
+	higher priority than the main RAM, I/O and GBA slot regions, but lower
+	priority than the TCM, BIOS and exception vector regions.
+	@note The @ref uncachedAlloc "uncached memory" pool occupies the window
+	once it is set up.
+
+	Windows follow the usual MPU rules: their size must be a power of two between
+	4 KiB and 2 GiB, and their address must be aligned to their size.
+	@{
+*/
+
+//! Number of MPU regions available for windows
+#define MPUWIN_NUM_REGIONS 1
+
+//! Minimum size of a MPU window
+#define MPUWIN_MIN_SZ 0x1000
+
+//! MPU window types
+typedef enum MpuWinType {
+	MpuWinType_Uncached     = 0, //!< Uncached and unbuffered (coherent with DMA and the ARM7)
+	MpuWinType_WriteThrough = 1, //!< Cached for reads, writes always reach memory
+	MpuWinType_NoAccess     = 2, //!< All accesses raise an exception (e.g. for guard pages)
+} MpuWinType;
+
+MK_EXTERN_C_START
+
+/*! @brief Maps a MPU window of type @p type
+	@param[in] addr Start address of the window (aligned to @p size)
+	@param[in] size Size of the window (power of two, at least @ref MPUWIN_MIN_SZ)
+	@return MPU region ID used by the window, or -1 on failure
+	@note The data cache is flushed for the given address range before changing its attributes.
+*/
+int mpuWinMap(MpuWinType type, uptr addr, size_t size);
+
+//! @brief Unmaps the MPU window @p id previously returned by @ref mpuWinMap
+void mpuWinUnmap(int id);
+
+//! @}
+
+/*! @name Uncached memory
+	Allocator for buffers that are accessed by the ARM7 or DMA, and which
+	thus would otherwise require explicit cache maintenance. The memory is
+	taken from the newlib heap and mapped through a @ref MpuWinType_Uncached
+	MPU window, which is set up on first use.
+	@{
+*/
+
+//! Default size of the uncached memory pool
+#define UNCACHED_POOL_DEFAULT_SZ 0x10000
+
+/*! @brief Sets up the uncached memory pool with the given @p size
+	@param[in] size Size of the pool (power of two, at least @ref MPUWIN_MIN_SZ)
+	@return true on success, false on failure
+	@note Calling this function is optional: the pool is automatically set up with
+	@ref UNCACHED_POOL_DEFAULT_SZ bytes on first use. It is not possible to resize
+	the pool once it has been set up.
+*/
+bool uncachedPoolInit(size_t size);
+
+/*! @brief Allocates @p size bytes of uncached memory
+	@param[in] align Alignment of the block in bytes (power of two, 0 for default)
+	@return Pointer to the allocated block, or NULL on failure
+*/
+void* uncachedAlloc(size_t size, size_t align);
+
+//! @brief Releases a block @p ptr previously allocated by @ref uncachedAlloc
+void uncachedFree(void* ptr);
+
+//! @brief Returns the number of free bytes in the uncached memory pool
+size_t uncachedGetFreeSize(void);
+
+MK_EXTERN_C_END
+
+//! @}
+
+//! @}
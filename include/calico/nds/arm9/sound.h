@@ -43,6 +43,20 @@ void soundInit(void);
 */
 void soundSynchronize(void);
 
+/*! @brief Starts collecting sound commands issued by the current thread into a batch
+
+	Commands issued after calling this function are not sent to the sound driver
+	until @ref soundBatchCommit is called, at which point they are all sent at once.
+	This reduces the PXI overhead of issuing many commands in a row (for example,
+	updating the volume and pan of all channels once per frame).
+	Commands issued by other threads are not affected, and only one thread can
+	collect a batch at a time (other threads calling this function will block).
+*/
+void soundBatchBegin(void);
+
+//! Sends all sound commands collected since the call to @ref soundBatchBegin
+void soundBatchCommit(void);
+
 //! Sets the power state of the sound hardware
 void soundSetPower(bool enable);
 
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#include "../types.h"
+
+/*! @addtogroup alloc
+	@{
+*/
+/*! @name Fast memory heaps
+	Runtime allocators for the fastest memories of the system, managing the
+	space left over by the linker in each of them:
+
+	- ARM9 ITCM: everything after the `.itcm` section.
+	- ARM9 DTCM: everything between the `.dtcm.bss` section and the main thread
+	  stack. Since the main thread stack grows downwards from the top of DTCM,
+	  DTCM memory is only made available if a stack size limit has been set
+	  (through `__stacksize__` or the NDS header), or if the stack was moved
+	  to main RAM due to it not fitting in DTCM.
+	- ARM7 WRAM: everything after the `.wram.bss` section (except the space
+	  used by the DLDI driver, if any), and in DSi mode also everything after the
+	  `.twl.bss` section in the DSi exclusive ARM7 WRAM.
+	- Additional regions (such as DSi NWRAM banks mapped by the application)
+	  can be added with @ref wramAddRegion.
+
+	All functions are thread safe. The heaps are lazily set up on first use.
+	@warning DTCM is not accessible by DMA. Do not place DMA source/destination
+	buffers in memory obtained from @ref tcmAlloc with @ref TcmType_Data.
+	@{
+*/
+
+MK_EXTERN_C_START
+
+#if defined(ARM9)
+
+//! Tightly coupled memory types
+typedef enum TcmType {
+	TcmType_Data        = 0, //!< Data TCM (DTCM)
+	TcmType_Instruction = 1, //!< Instruction TCM (ITCM)
+} TcmType;
+
+/*! @brief Allocates @p size bytes of tightly coupled memory of type @p type
+	@param[in] align Alignment of the block in bytes (power of two, 0 for default)
+	@return Pointer to the allocated block, or NULL on failure
+	@note ARM9 only
+*/
+void* tcmAlloc(TcmType type, size_t size, size_t align);
+
+/*! @brief Releases a block @p ptr previously allocated by @ref tcmAlloc
+	@note ARM9 only
+*/
+void tcmFree(void* ptr);
+
+/*! @brief Returns the number of free bytes of tightly coupled memory of type @p type
+	@note ARM9 only
+*/
+size_t tcmGetFreeSize(TcmType type);
+
+#endif
+
+/*! @brief Allocates @p size bytes of fast work RAM
+	@param[in] align Alignment of the block in bytes (power of two, 0 for default)
+	@return Pointer to the allocated block, or NULL on failure
+	@note On the ARM9 there is no WRAM available by default: regions must be
+	explicitly added using @ref wramAddRegion.
+*/
+void* wramAlloc(size_t size, size_t align);
+
+//! @brief Releases a block @p ptr previously allocated by @ref wramAlloc
+void wramFree(void* ptr);
+
+//! @brief Returns the number of free bytes of fast work RAM
+size_t wramGetFreeSize(void);
+
+/*! @brief Adds a region of work RAM to the pool used by @ref wramAlloc
+	@param[in] start Start address of the region
+	@param[in] size Size of the region in bytes
+	@return true on success, false if the region is too small to be usable
+	@note The region must remain mapped to the current CPU for as long as any
+	block allocated from it is in use.
+*/
+bool wramAddRegion(void* start, size_t size);
+
+MK_EXTERN_C_END
+
+//! @}
+
+//! @}
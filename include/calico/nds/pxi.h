@@ -1,25 +1,31 @@
 // SPDX-License-Identifier: ZPL-2.1
 // SPDX-FileCopyrightText: Copyright fincs, devkitPro
 #pragma once
-#if !defined(__NDS__)
+#if !defined(__NDS__) && !defined(CALICO_HOST)
 #error "This header file is only for NDS"
 #endif
 
 #include "../types.h"
+#if defined(__NDS__)
 #include "io.h"
+#endif
 
 /*! @addtogroup pxi
 	@{
 */
 
 /*! @name PXI memory mapped I/O
+	@note The host simulator has no memory mapped PXI registers. The IPCSYNC
+	value can be accessed with @ref hostPxiSyncSend and @ref hostPxiSyncRecv.
 	@{
 */
 
+#if defined(__NDS__)
 #define REG_PXI_SYNC MK_REG(u16, IO_PXI_SYNC)
 #define REG_PXI_CNT  MK_REG(u32, IO_PXI_CNT)
 #define REG_PXI_SEND MK_REG(u32, IO_PXI_SEND)
 #define REG_PXI_RECV MK_REG(u32, IO_PXI_RECV)
+#endif
 
 #define PXI_SYNC_RECV(_n)   ((_n) & 0xF)
 #define PXI_SYNC_SEND(_n)   (((_n) & 0xF) << 8)
@@ -72,7 +78,7 @@ typedef enum PxiChannel {
 	PxiChannel_Sound    = 6,  //!< Reserved for sound hardware access
 	PxiChannel_Mic      = 7,  //!< Reserved for microphone access
 	PxiChannel_Camera   = 8,  //!< Reserved for DSi camera access
-	PxiChannel_Rsvd9    = 9,  //!< Reserved for future use
+	PxiChannel_Crypto   = 9,  //!< Reserved for DSi AES engine access
 	PxiChannel_Rsvd10   = 10, //!< Reserved for future use
 	PxiChannel_Rsvd11   = 11, //!< Reserved for future use
 	PxiChannel_Reset    = 12, //!< Special channel used for ret2hbmenu
@@ -166,10 +172,14 @@ typedef void (* PxiHandlerFn)(void* user, u32 data);
 struct Mailbox; // forward declare
 
 //! Sends a ping to the other CPU. This function is similar to AArch64's `sev` instruction.
+#if defined(__NDS__)
 MK_INLINE void pxiPing(void)
 {
 	REG_PXI_SYNC |= PXI_SYNC_IRQ_SEND;
 }
+#else
+void pxiPing(void);
+#endif
 
 //! Wait for the other CPU to ping this CPU. This function is similar to AArch64's `wfe` instruction.
 void pxiWaitForPing(void);
@@ -180,9 +190,39 @@ void pxiSetHandler(PxiChannel ch, PxiHandlerFn fn, void* user);
 //! Configures PXI channel @p ch to route its messages to the specified Mailbox @p mb
 void pxiSetMailbox(PxiChannel ch, struct Mailbox* mb);
 
+//! Returns true if the other CPU has set a handler callback or mailbox on PXI channel @p ch
+bool pxiIsRemoteReady(PxiChannel ch);
+
 //! Waits for the other CPU to set a handler callback or mailbox on PXI channel @p ch
 void pxiWaitRemote(PxiChannel ch);
 
+/*! @brief Size in words of each PXI software send queue
+
+	Outgoing messages are placed in a software queue, which is drained into the
+	hardware send FIFO by the "send FIFO empty" interrupt. Senders therefore only
+	wait if the queue corresponding to the priority of the channel is full.
+	There is a separate queue for each @ref PxiSendPrio, and higher priority
+	queues are always drained first. Messages sent over the same channel are
+	always delivered in order, however no ordering is guaranteed between
+	channels with different priorities.
+*/
+#define PXI_SEND_QUEUE_WORDS 64
+
+//! PXI send priorities
+typedef enum PxiSendPrio {
+	PxiSendPrio_High   = 0, //!< Latency sensitive traffic (power, touch, sound, microphone)
+	PxiSendPrio_Normal = 1, //!< Default priority
+	PxiSendPrio_Low    = 2, //!< Bulk traffic (wireless)
+
+	PxiSendPrio_Count, //!< @private
+} PxiSendPrio;
+
+/*! @brief Sets the send priority of PXI channel @p ch to @p prio
+	@note This should be done before any messages are sent over the channel,
+	otherwise messages queued with the previous priority may be delivered out of order.
+*/
+void pxiSetChannelPriority(PxiChannel ch, PxiSendPrio prio);
+
 //! @private
 void pxiSendPacket(u32 packet);
 
@@ -241,6 +281,330 @@ MK_INLINE u32 pxiSendWithDataAndReceive(PxiChannel ch, u32 imm, const u32* data,
 	return pxiEndReceive(ch);
 }
 
+/*! @name Tagged PXI requests
+	The functions above allow a single request to be outstanding on each channel,
+	as the reply is matched to the request by channel alone. Tagged requests
+	instead identify each outstanding request with a small integer (tag), which
+	is included by the sender in the request message (in a channel specific way),
+	and echoed back by the other CPU in the reply (see @ref pxiReplyTagged).
+	This allows several threads to have requests in flight on the same channel.
+	@note A given channel should use either tagged requests or the regular
+	@ref pxiSendAndReceive family of functions, but not both.
+	@{
+*/
+
+//! Number of tagged requests that can be outstanding at the same time (across all channels)
+#define PXI_NUM_TAGS 8
+
+//! Position of the tag within the immediate value of a tagged reply
+#define PXI_TAG_SHIFT 23
+
+//! Builds the immediate value of a tagged reply from @p tag and 23-bit value @p imm
+MK_CONSTEXPR u32 pxiMakeTaggedReply(unsigned tag, u32 imm)
+{
+	return (tag << PXI_TAG_SHIFT) | (imm & ((1U << PXI_TAG_SHIFT) - 1));
+}
+
+//! @private
+MK_CONSTEXPR unsigned pxiTaggedReplyGetTag(u32 imm)
+{
+	return (imm >> PXI_TAG_SHIFT) & (PXI_NUM_TAGS - 1);
+}
+
+//! @private
+MK_CONSTEXPR u32 pxiTaggedReplyGetImmediate(u32 imm)
+{
+	return imm & ((1U << PXI_TAG_SHIFT) - 1);
+}
+
+/*! @brief Allocates a tag for a request to be sent over PXI channel @p ch
+	@return Tag (0..@ref PXI_NUM_TAGS - 1)
+	@note If all tags are in use, this function waits for one to be released.
+	The tag must be released afterwards by calling @ref pxiTagWait.
+*/
+unsigned pxiTagAlloc(PxiChannel ch);
+
+/*! @brief Tagged request completion callback
+	@param[in] user User data passed to @ref pxiTagAllocAsync
+	@param[in] reply 23-bit reply value sent by the other CPU
+	@warning The callback runs in IRQ mode - exercise caution!
+	See @ref IrqHandler for more details on how to write IRQ mode handlers.
+*/
+typedef void (* PxiTagCallbackFn)(void* user, u32 reply);
+
+/*! @brief Allocates a tag for an asynchronous request to be sent over PXI channel @p ch
+	@param[in] fn Callback to invoke when the reply is received
+	@param[in] user User data to pass to the callback
+	@return Tag (0..@ref PXI_NUM_TAGS - 1)
+	@note The tag is automatically released before the callback is invoked,
+	and must not be passed to @ref pxiTagWait. This function must be called
+	from a thread, as it waits for a tag to be released if all are in use.
+*/
+unsigned pxiTagAllocAsync(PxiChannel ch, PxiTagCallbackFn fn, void* user);
+
+/*! @brief Waits for the reply to the request identified by @p tag, and releases the tag
+	@return 23-bit reply value sent by the other CPU using @ref pxiReplyTagged
+*/
+u32 pxiTagWait(unsigned tag);
+
+//! Replies to a tagged message on PXI channel @p ch with @p tag and 23-bit value @p imm
+MK_INLINE void pxiReplyTagged(PxiChannel ch, unsigned tag, u32 imm)
+{
+	pxiReply(ch, pxiMakeTaggedReply(tag, imm));
+}
+
+//! @}
+
+/*! @name PXI doorbells
+	@ref pxiPing raises an interrupt on the other CPU, which wakes up every thread
+	waiting for a ping regardless of what it is waiting for. Doorbells multiplex
+	the ping interrupt: ringing a doorbell sets a per-doorbell flag in shared memory
+	and pings the other CPU, which then only wakes up the threads waiting on the
+	doorbells whose flag was set. Additionally, a doorbell that is still pending on
+	the other CPU does not need to be pinged again, which avoids redundant interrupts
+	when the same doorbell is rung repeatedly (for example, a contended @ref SMutex).
+
+	Like pings, doorbells are "sticky": if a doorbell was rung while no thread was
+	waiting on it, the next call to @ref pxiDoorbellWait returns immediately.
+	Callers are expected to check their wake-up condition before and after waiting.
+	@{
+*/
+
+//! Number of doorbells available to each CPU
+#define PXI_NUM_DOORBELLS 16
+
+//! List of PXI doorbells
+typedef enum PxiDoorbell {
+	PxiDoorbell_PxiMask   = 0,  //!< Rung when the set of PXI channels with a handler changes
+	PxiDoorbell_Ring      = 1,  //!< Rung when messages are committed to a PXI ring buffer
+	PxiDoorbell_RingSpace = 2,  //!< Rung when a PXI ring buffer has been drained
+	PxiDoorbell_Debug     = 3,  //!< Rung when the ARM7 debug buffer changes state
+	PxiDoorbell_SMutex0   = 4,  //!< Rung when a @ref SMutex is released (4 doorbells, selected by address)
+	PxiDoorbell_Rsvd8     = 8,  //!< Reserved for future use
+	PxiDoorbell_Rsvd9     = 9,  //!< Reserved for future use
+	PxiDoorbell_Rsvd10    = 10, //!< Reserved for future use
+	PxiDoorbell_Rsvd11    = 11, //!< Reserved for future use
+	PxiDoorbell_User0     = 12, //!< Doorbell available for users
+	PxiDoorbell_User1     = 13, //!< Doorbell available for users
+	PxiDoorbell_User2     = 14, //!< Doorbell available for users
+	PxiDoorbell_User3     = 15, //!< Doorbell available for users
+} PxiDoorbell;
+
+//! Number of doorbells used by @ref SMutex objects
+#define PXI_NUM_SMUTEX_DOORBELLS 4
+
+//! Rings doorbell @p db on the other CPU
+void pxiDoorbellRing(PxiDoorbell db);
+
+/*! @brief Waits for the other CPU to ring doorbell @p db on this CPU
+	@note This function can be called with interrupts disabled, in which case
+	checking the wake-up condition and waiting happen atomically.
+*/
+void pxiDoorbellWait(PxiDoorbell db);
+
+//! @}
+
+/*! @name PXI ring buffers
+	Shared memory ring buffers can be used as an alternative transport for PXI
+	messages. A ring carries the same messages as the hardware FIFO (which are
+	delivered to the same handler callbacks or mailboxes on the other CPU), but
+	messages are written to memory without any per-word FIFO accesses. Messages
+	accumulate in the ring until @ref pxiRingCommit is called, which publishes
+	them all at once and notifies the other CPU with a single doorbell (see @ref pxiDoorbellRing).
+	This is useful for submitting large amounts of small messages, or large
+	payloads.
+
+	Each ring transfers messages in a single direction. The ring object and its
+	buffer are prepared by the sending CPU using @ref pxiRingInit, and its address
+	is then passed to the receiving CPU (for example through a regular PXI message),
+	which calls @ref pxiRingAttach in order to start processing it.
+	@warning The ring object and its buffer must be located in main RAM, and the
+	ARM9 must access them uncached (see @ref uncachedAlloc).
+	@note Sending to a ring is not thread safe. Callers are responsible for
+	serializing accesses to a given ring (for example, using a @ref Mutex).
+	@{
+*/
+
+//! Maximum number of rings that can be attached to a CPU for receiving
+#define PXI_RING_MAX_ATTACHED 4
+
+//! Minimum size of a ring buffer in words (enough to hold the largest extended message)
+#define PXI_RING_MIN_WORDS 64
+
+//! PXI ring buffer object
+typedef struct PxiRing {
+	vu32 head;       //!< @private
+	vu32 tail;       //!< @private
+	vu32 tx_waiting; //!< @private
+	u32 wr;          //!< @private
+	u32 mask;        //!< @private
+	vu32* buf;       //!< @private
+} PxiRing;
+
+/*! @brief Prepares PXI ring @p r for use by the sending CPU
+	@param[in] buf Buffer holding the messages
+	@param[in] num_words Size of the buffer in words, must be a power of two
+	and at least @ref PXI_RING_MIN_WORDS
+	@return true on success, false on invalid parameters
+*/
+bool pxiRingInit(PxiRing* r, u32* buf, size_t num_words);
+
+/*! @brief Starts processing messages received through PXI ring @p r on this CPU
+	@return true on success, false if there are already @ref PXI_RING_MAX_ATTACHED rings attached
+*/
+bool pxiRingAttach(PxiRing* r);
+
+//! Stops processing messages received through PXI ring @p r on this CPU
+void pxiRingDetach(PxiRing* r);
+
+//! @private
+void pxiRingSendPacket(PxiRing* r, u32 packet, const u32* data);
+
+/*! @brief Publishes all messages written to PXI ring @p r, and notifies the other CPU
+	@note Nothing is done if no messages were written since the last commit.
+*/
+void pxiRingCommit(PxiRing* r);
+
+/*! @brief Writes a simple 26-bit value @p imm for PXI channel @p ch to ring @p r
+	@note If the ring is full, pending messages are committed and this function
+	waits for the other CPU to free up enough space.
+*/
+MK_INLINE void pxiRingSend(PxiRing* r, PxiChannel ch, u32 imm)
+{
+	pxiRingSendPacket(r, pxiMakePacket(ch, false, imm), NULL);
+}
+
+/*! @brief Writes an extended message for PXI channel @p ch to ring @p r
+	@param[in] imm 16-bit immediate data
+	@param[in] data Data buffer to send
+	@param[in] num_words Size of the data buffer in words (1..32)
+*/
+MK_INLINE void pxiRingSendWithData(PxiRing* r, PxiChannel ch, u16 imm, const u32* data, u32 num_words)
+{
+	pxiRingSendPacket(r, pxiMakeExtPacket(ch, false, num_words, imm), data);
+}
+
+//! Writes a reply to a message on PXI channel @p ch using 26-bit value @p imm to ring @p r
+MK_INLINE void pxiRingReply(PxiRing* r, PxiChannel ch, u32 imm)
+{
+	pxiRingSendPacket(r, pxiMakePacket(ch, true, imm), NULL);
+}
+
+//! @}
+
+/*! @name PXI message batches
+	A batch collects PXI messages (for any channel) in a local buffer, which is
+	then sent in a single burst by @ref pxiBatchFlush. This amortizes the cost
+	of queueing messages for transmission over all messages in the batch, and allows the
+	other CPU to process the entire batch in as few interrupts as possible.
+	Messages retain their order within a batch, and are delivered normally.
+	@note Batches are not thread safe. Messages sent outside of the batch (including
+	those sent by @ref pxiSendAndReceive) may be delivered before batched messages
+	that have not yet been flushed.
+	@{
+*/
+
+//! Maximum number of words held by a PXI batch before it is automatically flushed
+#define PXI_BATCH_MAX_WORDS 64
+
+//! PXI message batch object
+typedef struct PxiBatch {
+	u32 num_words;                  //!< @private
+	u32 words[PXI_BATCH_MAX_WORDS]; //!< @private
+} PxiBatch;
+
+//! Prepares an empty PXI batch @p b for use
+MK_INLINE void pxiBatchInit(PxiBatch* b)
+{
+	b->num_words = 0;
+}
+
+//! Returns true if PXI batch @p b contains messages pending to be sent
+MK_INLINE bool pxiBatchIsPending(PxiBatch* b)
+{
+	return b->num_words != 0;
+}
+
+//! @private
+void pxiBatchAddPacket(PxiBatch* b, u32 packet, const u32* data);
+
+//! Sends all messages contained in PXI batch @p b, and empties it
+void pxiBatchFlush(PxiBatch* b);
+
+//! Adds a simple 26-bit value @p imm for PXI channel @p ch to batch @p b
+MK_INLINE void pxiBatchSend(PxiBatch* b, PxiChannel ch, u32 imm)
+{
+	pxiBatchAddPacket(b, pxiMakePacket(ch, false, imm), NULL);
+}
+
+/*! @brief Adds an extended message for PXI channel @p ch to batch @p b
+	@param[in] imm 16-bit immediate data
+	@param[in] data Data buffer to send
+	@param[in] num_words Size of the data buffer in words (1..32)
+*/
+MK_INLINE void pxiBatchSendWithData(PxiBatch* b, PxiChannel ch, u16 imm, const u32* data, u32 num_words)
+{
+	pxiBatchAddPacket(b, pxiMakeExtPacket(ch, false, num_words, imm), data);
+}
+
+//! Adds a reply to a message on PXI channel @p ch using 26-bit value @p imm to batch @p b
+MK_INLINE void pxiBatchReply(PxiBatch* b, PxiChannel ch, u32 imm)
+{
+	pxiBatchAddPacket(b, pxiMakePacket(ch, true, imm), NULL);
+}
+
+//! @}
+
+/*! @name PXI statistics
+	When calico is built with the `CALICO_PXI_STATS` option, the PXI driver keeps
+	per-channel traffic counters and round-trip latency histograms for requests
+	made with @ref pxiSendAndReceive (and its variants) or tagged requests.
+	Statistics are local to each CPU: the ARM9 and ARM7 each keep track of the
+	traffic they send and receive, and can query it independently.
+	@note Messages sent through PXI ring buffers are only counted by the receiver.
+	@{
+*/
+
+//! Number of buckets in a PXI round-trip latency histogram
+#define PXI_STATS_NUM_BUCKETS 16
+
+//! Per-channel PXI traffic statistics
+typedef struct PxiChannelStats {
+	u32 num_sent_msgs;    //!< Number of messages sent
+	u32 num_sent_words;   //!< Number of words sent (including message headers)
+	u32 num_recv_msgs;    //!< Number of messages received (including replies)
+	u32 num_recv_words;   //!< Number of words received (including message headers)
+	u32 num_send_stalls;  //!< Number of times a sender had to wait for space in the send queue
+	u32 send_wait_ticks;  //!< Total time (in system ticks) spent waiting for space in the send queue
+} PxiChannelStats;
+
+/*! @brief PXI round-trip latency histogram
+	Bucket 0 counts requests that completed in less than 2 system ticks, and
+	each bucket N>0 counts requests that took between 2^N and 2^(N+1)-1 ticks.
+	The last bucket also counts all slower requests.
+*/
+typedef struct PxiRpcStats {
+	u32 num_requests;                    //!< Number of completed requests
+	u32 max_ticks;                       //!< Longest round-trip time in system ticks
+	u64 total_ticks;                     //!< Sum of all round-trip times in system ticks
+	u32 buckets[PXI_STATS_NUM_BUCKETS];  //!< Histogram of round-trip times
+} PxiRpcStats;
+
+/*! @brief Retrieves the traffic statistics of PXI channel @p ch into @p out
+	@return true on success, false if calico was built without PXI statistics support
+*/
+bool pxiGetChannelStats(PxiChannel ch, PxiChannelStats* out);
+
+/*! @brief Retrieves the round-trip latency histogram of PXI channel @p ch into @p out
+	@return true on success, false if calico was built without PXI statistics support
+*/
+bool pxiGetRpcStats(PxiChannel ch, PxiRpcStats* out);
+
+//! Resets all PXI statistics to zero
+void pxiResetStats(void);
+
+//! @}
+
 MK_EXTERN_C_END
 
 //! @}
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#if !defined(__NDS__)
+#error "This header file is only for NDS"
+#endif
+
+#include "../types.h"
+#include "../system/rheap.h"
+
+/*! @addtogroup alloc
+	@{
+*/
+/*! @name Shared memory heap
+	Heap located in main RAM that can be used by both the ARM9 and the ARM7 to
+	allocate buffers that are shared between the two processors, instead of
+	placing them at fixed addresses. Blocks can be allocated by one CPU and
+	released by the other. The heap is protected by a @ref SMutex, and all
+	allocations are aligned to (and padded to a multiple of) the size of a
+	cache line, so that cache maintenance on one block never affects another.
+
+	The heap must be set up once by calling @ref shmemInit on either CPU
+	(usually the ARM9, with memory obtained from @ref uncachedAlloc). Until
+	then, allocations fail on both CPUs.
+	@warning The memory managed by the heap (including its bookkeeping) must be
+	accessed uncached by the ARM9, as it is concurrently modified by the ARM7.
+	@{
+*/
+
+//! Minimum alignment (and granularity) of shared memory heap allocations
+#define SHMEM_ALIGN 32
+
+MK_EXTERN_C_START
+
+/*! @brief Sets up the shared memory heap
+	@param[in] start Start address of the memory region (in main RAM)
+	@param[in] size Size of the memory region in bytes
+	@return true on success, false if the heap is already set up or the region is too small
+*/
+bool shmemInit(void* start, size_t size);
+
+//! Returns true if the shared memory heap has been set up
+bool shmemIsReady(void);
+
+/*! @brief Allocates a block of memory from the shared memory heap
+	@param[in] size Size of the block in bytes
+	@param[in] align Alignment of the block in bytes (power of two, 0 for default)
+	@return Pointer to the allocated block, or NULL on failure
+*/
+void* shmemAlloc(size_t size, size_t align);
+
+/*! @brief Releases a block @p ptr previously allocated from the shared memory heap
+	@note Passing NULL is allowed and does nothing. The block may have been
+	allocated by either CPU.
+*/
+void shmemFree(void* ptr);
+
+/*! @brief Retrieves usage statistics of the shared memory heap into @p out
+	@return true on success, false if the heap has not been set up
+*/
+bool shmemGetStats(RHeapStats* out);
+
+MK_EXTERN_C_END
+
+//! @}
+
+//! @}
@@ -185,6 +185,18 @@ void wlmgrSetRawRxHandler(WlMgrRawRxFn cb, void* user);
 //! Transmits a raw network @p pPacket
 void wlmgrRawTx(NetBuf* pPacket);
 
+/*! @brief Starts collecting commands and packet transmissions issued by the current thread into a batch
+
+	Requests issued after calling this function (including @ref wlmgrRawTx) are
+	not sent to the ARM7 until @ref wlmgrBatchCommit is called, at which point
+	they are all sent at once. This reduces the PXI overhead of transmitting many
+	packets in a row. Only one thread can collect a batch at a time.
+*/
+void wlmgrBatchBegin(void);
+
+//! Sends all requests collected since the call to @ref wlmgrBatchBegin
+void wlmgrBatchCommit(void);
+
 #elif defined(ARM7)
 
 /*! @brief Starts the ARM7 side wireless manager server
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#include "../types.h"
+
+/*! @addtogroup decomp
+	@{
+*/
+/*! @name Decompression
+	Decoders for the compression formats supported by the GBA/DS BIOS (LZ10,
+	Huffman and RLE), as well as the LZ11 format introduced by the DSi BIOS.
+	Compressed data starts with the usual 32-bit BIOS header, which specifies
+	the format and the decompressed size. Large LZ11 files that use a zero
+	size in the header followed by an extended 32-bit size are also supported.
+
+	The decoders are compiled in ARM mode and run from ITCM (DS) or IWRAM (GBA).
+	Unlike BIOS routines, they can also pull compressed data in chunks from a
+	callback (@ref decompStream), such as a wrapper around @ref nitroromReadFile
+	or @ref blkDevReadSectors, without needing to load the entire file first.
+
+	Output is written byte by byte, and as such cannot be directly sent to VRAM.
+	@{
+*/
+
+//! Compression formats
+typedef enum DecompType {
+	DecompType_Lz10  = 0x10, //!< LZ77 (BIOS format)
+	DecompType_Lz11  = 0x11, //!< LZ77 with extended lengths (DSi BIOS format)
+	DecompType_Huff4 = 0x24, //!< Huffman with 4-bit data units
+	DecompType_Huff8 = 0x28, //!< Huffman with 8-bit data units
+	DecompType_Rle   = 0x30, //!< Run-length encoding
+} DecompType;
+
+/*! @brief Input callback used in streaming mode
+	@param[in] user User-provided data passed to @ref decompStream
+	@param[out] buf Buffer which receives the compressed data
+	@param[in] size Maximum number of bytes to read
+	@return Number of bytes read, or 0 on error or end of file
+*/
+typedef size_t (*DecompReadFn)(void* user, void* buf, size_t size);
+
+MK_EXTERN_C_START
+
+//! Returns the compression format specified in the given @p header
+MK_CONSTEXPR DecompType decompHeaderGetType(u32 header)
+{
+	return (DecompType)(header & 0xff);
+}
+
+//! Returns the decompressed size specified in the given @p header (0 means an extended size follows)
+MK_CONSTEXPR size_t decompHeaderGetSize(u32 header)
+{
+	return header >> 8;
+}
+
+/*! @brief Decompresses data from memory
+	@param[in] src Compressed data (any alignment)
+	@param[out] dst Output buffer
+	@param[in] dst_sz Size of the output buffer
+	@return Decompressed size, or 0 on failure (e.g. invalid data or output buffer too small)
+*/
+MK_EXTERN32 size_t decompMem(const void* src, void* dst, size_t dst_sz);
+
+/*! @brief Decompresses data pulled from a callback
+	@param[in] fn Input callback (see @ref DecompReadFn)
+	@param[in] user User data passed to the callback
+	@param[in] buf Buffer used to hold chunks of compressed data, passed to the callback
+	@param[in] buf_sz Size of @p buf (i.e. chunk size)
+	@param[out] dst Output buffer
+	@param[in] dst_sz Size of the output buffer
+	@return Decompressed size, or 0 on failure
+	@note @p buf is allocated by the caller so that it can satisfy the requirements
+	of the underlying data source (for example, sector aligned in main RAM).
+*/
+MK_EXTERN32 size_t decompStream(DecompReadFn fn, void* user, void* buf, size_t buf_sz, void* dst, size_t dst_sz);
+
+MK_EXTERN_C_END
+
+//! @}
+
+//! @}
@@ -7,6 +7,8 @@
 #include "../gba/irq.h"
 #elif defined(__NDS__)
 #include "../nds/irq.h"
+#elif defined(CALICO_HOST)
+#include "../host/irq.h"
 #else
 #error "Unsupported platform."
 #endif
@@ -31,7 +33,7 @@ MK_EXTERN_C_START
 typedef void (*IrqHandler)(void);
 
 //! @private
-extern volatile IrqMask __irq_flags;
+extern MK_CPU_LOCAL volatile IrqMask __irq_flags;
 
 /*! @brief Assigns an interrupt service routine (ISR) to one or more interrupts
 	@param[in] mask Bitmask of interrupts to which assign the ISR
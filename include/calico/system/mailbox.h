@@ -42,13 +42,13 @@ MK_INLINE void mailboxPrepare(Mailbox* mb, u32* slots, unsigned num_slots)
 
 //! @brief Asynchronously sends a @p message to Mailbox @p mb.
 //! Returns true on success, false when the mailbox is full.
-bool mailboxTrySend(Mailbox* mb, u32 message);
+MK_EXTERN_HOT bool mailboxTrySend(Mailbox* mb, u32 message);
 
 //! @brief Asynchronously receives a message from Mailbox @p mb.
-bool mailboxTryRecv(Mailbox* mb, u32* out);
+MK_EXTERN_HOT bool mailboxTryRecv(Mailbox* mb, u32* out);
 
 //! @brief Receives a message from Mailbox @p mb, blocking the current thread if empty.
-u32 mailboxRecv(Mailbox* mb);
+MK_EXTERN_HOT u32 mailboxRecv(Mailbox* mb);
 
 MK_EXTERN_C_END
 
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#include "../types.h"
+
+/*! @addtogroup alloc
+	@{
+*/
+/*! @name Fixed-block memory pool
+	Allocator that carves a caller-supplied buffer into blocks of a fixed size.
+	Allocating and freeing blocks are constant time (O(1)) operations, and the
+	pool never suffers from fragmentation. This makes it a good fit for small
+	objects that are frequently created and destroyed, such as messages,
+	@ref TickTask objects or packet descriptors.
+	@{
+*/
+
+//! Protects the pool against concurrent access (from threads and ISRs)
+#define MEMPOOL_THREAD_SAFE (1U<<0)
+//! Validates frees, counting double frees and frees of foreign pointers
+#define MEMPOOL_DEBUG       (1U<<1)
+
+MK_EXTERN_C_START
+
+//! @private
+typedef struct MemPoolBlock MemPoolBlock;
+
+//! Memory pool object
+typedef struct MemPool {
+	MemPoolBlock* free_list; //!< @private
+	u8* next_unused;         //!< @private
+	u8* start;               //!< @private
+	u8* end;                 //!< @private
+	u32 block_sz;            //!< @private
+	u16 flags;               //!< @private
+	u16 num_used;            //!< @private
+	u16 peak_used;           //!< @private
+	u16 num_double_frees;    //!< @private
+	u16 num_bad_frees;       //!< @private
+} MemPool;
+
+//! Memory pool usage statistics
+typedef struct MemPoolStats {
+	u32 block_sz;         //!< Size of each block in bytes
+	u32 num_blocks;       //!< Total number of blocks in the pool
+	u32 num_used;         //!< Number of currently allocated blocks
+	u32 peak_used;        //!< Highest number of simultaneously allocated blocks
+	u32 num_double_frees; //!< Number of detected double frees (@ref MEMPOOL_DEBUG only)
+	u32 num_bad_frees;    //!< Number of frees of pointers not belonging to the pool (@ref MEMPOOL_DEBUG only)
+} MemPoolStats;
+
+/*! @brief Prepares a MemPool object @p p for use
+	@param[in] buffer Storage space for the blocks (pointer aligned, i.e. 32-bit aligned on hardware)
+	@param[in] buffer_sz Size of the storage space in bytes
+	@param[in] block_sz Size of each block in bytes (rounded up to a multiple of the pointer size, i.e. 4 on hardware)
+	@param[in] flags Combination of @ref MEMPOOL_THREAD_SAFE and @ref MEMPOOL_DEBUG
+	@note The storage space must remain valid throughout the lifetime of the MemPool object.
+	@note Preparing the pool is a constant time operation: blocks are lazily
+	carved out of the buffer as they are allocated for the first time.
+*/
+void mempoolPrepare(MemPool* p, void* buffer, size_t buffer_sz, size_t block_sz, unsigned flags);
+
+//! @brief Allocates a block from MemPool @p p, returning NULL if the pool is exhausted
+void* mempoolAlloc(MemPool* p);
+
+/*! @brief Returns a @p block previously allocated with @ref mempoolAlloc to MemPool @p p
+	@note Passing NULL is allowed and does nothing.
+	@note In @ref MEMPOOL_DEBUG mode, invalid pointers and double frees are detected,
+	counted and otherwise ignored.
+*/
+void mempoolFree(MemPool* p, void* block);
+
+//! @brief Retrieves usage statistics of MemPool @p p into @p out
+void mempoolGetStats(MemPool* p, MemPoolStats* out);
+
+/*! @brief Returns the number of blocks currently allocated from MemPool @p p
+	@note When called after all users of the pool are expected to have released
+	their blocks, a nonzero value indicates the number of leaked blocks.
+*/
+MK_INLINE unsigned mempoolGetNumUsed(MemPool* p)
+{
+	return p->num_used;
+}
+
+//! @brief Returns true if @p block lies within the storage space of MemPool @p p
+MK_INLINE bool mempoolContains(MemPool* p, const void* block)
+{
+	return (const u8*)block >= p->start && (const u8*)block < p->end;
+}
+
+MK_EXTERN_C_END
+
+//! @}
+
+//! @}
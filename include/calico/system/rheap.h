@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#include "../types.h"
+
+/*! @addtogroup alloc
+	@{
+*/
+/*! @name Region heap
+	General purpose allocator managing one or more discontiguous memory regions.
+	Free space is kept in an address-ordered list, allocations are satisfied
+	using a first-fit strategy, and adjacent free blocks are coalesced on release.
+	The heap is intended for small special-purpose memories (such as TCM or WRAM)
+	where the newlib heap cannot be used.
+	@note RHeap objects do not perform any locking. Callers are responsible for
+	serializing accesses (for example, using a @ref Mutex).
+	@{
+*/
+
+//! Allocation granularity (and minimum alignment) of the region heap (8 bytes on 32-bit targets)
+#define RHEAP_GRANULARITY (2*sizeof(void*))
+
+MK_EXTERN_C_START
+
+//! @private
+typedef struct RHeapBlock RHeapBlock;
+
+//! Region heap object
+typedef struct RHeap {
+	RHeapBlock* free_list; //!< @private
+	u32 total_sz;          //!< @private
+	u32 used_sz;           //!< @private
+	u32 peak_used_sz;      //!< @private
+} RHeap;
+
+//! Region heap usage statistics
+typedef struct RHeapStats {
+	u32 total_sz;        //!< Total size of all regions managed by the heap
+	u32 used_sz;         //!< Number of bytes currently allocated (including bookkeeping)
+	u32 peak_used_sz;    //!< Highest value @ref used_sz has ever reached
+	u32 largest_free_sz; //!< Size of the largest free block (including bookkeeping)
+	u32 num_free_blocks; //!< Number of free blocks (a measure of fragmentation)
+} RHeapStats;
+
+//! @brief Prepares an empty RHeap object @p h for use
+MK_INLINE void rheapPrepare(RHeap* h)
+{
+	h->free_list = NULL;
+	h->total_sz = 0;
+	h->used_sz = 0;
+	h->peak_used_sz = 0;
+}
+
+/*! @brief Adds a memory region to RHeap @p h
+	@param[in] start Start address of the region
+	@param[in] size Size of the region in bytes
+	@return true on success, false if the region is too small to be usable
+	@note The region is trimmed to @ref RHEAP_GRANULARITY boundaries.
+	It must not overlap any other region already managed by the heap.
+*/
+bool rheapAddRegion(RHeap* h, void* start, size_t size);
+
+/*! @brief Allocates a block of memory from RHeap @p h
+	@param[in] size Size of the block in bytes
+	@param[in] align Alignment of the block in bytes (power of two, 0 for default)
+	@return Pointer to the allocated block, or NULL on failure
+*/
+void* rheapAlloc(RHeap* h, size_t size, size_t align);
+
+/*! @brief Releases a block @p ptr previously allocated from RHeap @p h
+	@note Passing NULL is allowed and does nothing.
+*/
+void rheapFree(RHeap* h, void* ptr);
+
+//! @brief Retrieves usage statistics of RHeap @p h into @p out
+void rheapGetStats(RHeap* h, RHeapStats* out);
+
+//! @brief Returns the number of free bytes in RHeap @p h (this may be fragmented)
+MK_INLINE size_t rheapGetFreeSize(RHeap* h)
+{
+	return h->total_sz - h->used_sz;
+}
+
+MK_EXTERN_C_END
+
+//! @}
+
+//! @}
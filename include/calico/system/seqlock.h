@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#include "../types.h"
+#include "../arm/common.h"
+
+/*! @addtogroup sync
+	@{
+*/
+/*! @name Sequence lock
+	Synchronization primitive that allows a single writer to publish a data
+	structure to any number of readers, without the readers ever having to block
+	or write to shared memory. The writer increments a sequence counter before
+	and after updating the data, and readers copy the data and retry if the
+	counter changed in the meantime (or was odd, indicating an update in progress).
+	Reads only need to be retried if they overlap an update, which is rare for
+	data that is updated periodically.
+
+	Sequence locks are suitable for publishing state from the ARM7 to the ARM9
+	(or vice versa) through uncached shared memory, as well as between threads
+	and interrupt handlers of the same CPU.
+	@note Only one writer may update a given SeqLock at a time. If data can be
+	updated from several contexts, the writer is responsible for serializing
+	them (for example, by disabling interrupts).
+	@warning Readers must not dereference pointers contained in the protected data
+	before the read has been validated with @ref seqlockReadRetry.
+	@{
+*/
+
+MK_EXTERN_C_START
+
+//! Sequence lock object
+typedef struct SeqLock {
+	vu32 seq; //!< @private
+} SeqLock;
+
+//! Prepares a SeqLock object @p l for use
+MK_INLINE void seqlockPrepare(SeqLock* l)
+{
+	l->seq = 0;
+}
+
+//! Begins an update of the data protected by SeqLock @p l
+MK_INLINE void seqlockWriteBegin(SeqLock* l)
+{
+	l->seq = l->seq + 1;
+	armCompilerBarrier();
+}
+
+//! Finishes an update of the data protected by SeqLock @p l
+MK_INLINE void seqlockWriteEnd(SeqLock* l)
+{
+	armCompilerBarrier();
+	l->seq = l->seq + 1;
+}
+
+/*! @brief Begins reading the data protected by SeqLock @p l
+	@return Sequence value to be passed to @ref seqlockReadRetry
+*/
+MK_INLINE u32 seqlockReadBegin(SeqLock* l)
+{
+	u32 seq = l->seq;
+	armCompilerBarrier();
+	return seq;
+}
+
+/*! @brief Checks whether a read of the data protected by SeqLock @p l needs to be retried
+	@param[in] seq Sequence value returned by @ref seqlockReadBegin
+	@return true if the data read since @ref seqlockReadBegin may be inconsistent, false otherwise
+*/
+MK_INLINE bool seqlockReadRetry(SeqLock* l, u32 seq)
+{
+	armCompilerBarrier();
+	return (seq & 1) || l->seq != seq;
+}
+
+//! Publishes @p size bytes of @p in into @p data, which is protected by SeqLock @p l
+MK_INLINE void seqlockWrite(SeqLock* l, void* data, const void* in, size_t size)
+{
+	seqlockWriteBegin(l);
+	__builtin_memcpy(data, in, size);
+	seqlockWriteEnd(l);
+}
+
+//! Reads a consistent copy of @p size bytes of @p data (protected by SeqLock @p l) into @p out
+MK_INLINE void seqlockRead(SeqLock* l, void* out, const void* data, size_t size)
+{
+	u32 seq;
+	do {
+		seq = seqlockReadBegin(l);
+		__builtin_memcpy(out, data, size);
+	} while (seqlockReadRetry(l, seq));
+}
+
+MK_EXTERN_C_END
+
+//! @}
+
+//! @}
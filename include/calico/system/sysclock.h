@@ -10,8 +10,10 @@
 #define SYSTEM_CLOCK 0x1000000 //!< GBA system bus speed: exactly 2^24 Hz ~= 16.78 MHz
 #elif defined(__NDS__)
 #define SYSTEM_CLOCK 0x1FF61FE //!< NDS system bus speed: approximately 33.51 MHz
+#elif defined(CALICO_HOST)
+#define SYSTEM_CLOCK 0x1FF61FE //!< Host simulator: same as NDS, so that tick conversions match
 #else
-#error "This header file is only for GBA and NDS"
+#error "This header file is only for GBA, NDS and the host simulator"
 #endif
 
 //! @}
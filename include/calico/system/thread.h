@@ -30,6 +30,10 @@ MK_EXTERN_C_START
 
 typedef struct Thread Thread;
 
+#if defined(CALICO_HOST)
+typedef struct HostContext HostContext; //!< @private
+#endif
+
 //! List of blocked threads, used as a building block for synchronization primitives
 typedef struct ThrListNode {
 	Thread* next; //!< @private
@@ -55,7 +59,11 @@ typedef int (* ThreadFunc)(void* arg);
 
 //! Data structure containing all management information for a thread
 struct Thread {
+#if defined(CALICO_HOST)
+	HostContext* ctx;    //!< Host execution context (see @ref host)
+#else
 	ArmContext ctx;      //!< CPU context structure
+#endif
 
 	void* tp;            //!< Virtual thread-local segment register
 	void* impure;        //!< Pointer to per-thread C standard library state
@@ -73,7 +81,7 @@ struct Thread {
 		struct {
 			ThrListNode link;
 			ThrListNode* queue;
-			u32 token;
+			uptr token;
 		};
 		// Data for finished threads
 		struct {
@@ -167,7 +175,7 @@ int threadJoin(Thread* t);
 //! @brief Returns the pointer to the currently running thread
 MK_INLINE Thread* threadGetSelf(void)
 {
-	extern ThrSchedState __sched_state;
+	extern MK_CPU_LOCAL ThrSchedState __sched_state;
 	return __sched_state.cur;
 }
 
@@ -227,18 +235,20 @@ void threadExit(int rc) MK_NORETURN;
 	- **By mask**: unblocks threads whose @p token has one or more bits in common with the reference mask (`&` bitwise-and operator)
 		@see threadUnblockOneByMask, threadUnblockAllByMask
 
+	Tokens are pointer-sized, which allows using the address of an object as the token.
+
 	@return 0 if threadBlockCancel was called, 1 if the thread was unblocked by value, the matched bits if the thread was unblocked by mask.
 */
-MK_EXTERN32 u32 threadBlock(ThrListNode* queue, u32 token);
+MK_EXTERN32 u32 threadBlock(ThrListNode* queue, uptr token);
 
 //! @brief Unblocks at most one thread in the @p queue matching the specified @p ref value @see threadBlock
-MK_EXTERN32 void threadUnblockOneByValue(ThrListNode* queue, u32 ref);
+MK_EXTERN32 void threadUnblockOneByValue(ThrListNode* queue, uptr ref);
 //! @brief Unblocks at most one thread in the @p queue matching the specified @p ref mask @see threadBlock
-MK_EXTERN32 void threadUnblockOneByMask(ThrListNode* queue, u32 ref);
+MK_EXTERN32 void threadUnblockOneByMask(ThrListNode* queue, uptr ref);
 //! @brief Unblocks all threads in the @p queue matching the specified @p ref value @see threadBlock
-MK_EXTERN32 void threadUnblockAllByValue(ThrListNode* queue, u32 ref);
+MK_EXTERN32 void threadUnblockAllByValue(ThrListNode* queue, uptr ref);
 //! @brief Unblocks all threads in the @p queue matching the specified @p ref mask @see threadBlock
-MK_EXTERN32 void threadUnblockAllByMask(ThrListNode* queue, u32 ref);
+MK_EXTERN32 void threadUnblockAllByMask(ThrListNode* queue, uptr ref);
 
 //! @brief Removes thread @p t from the specified @p queue
 MK_EXTERN32 void threadBlockCancel(ThrListNode* queue, Thread* t);
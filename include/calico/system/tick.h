@@ -47,7 +47,7 @@ MK_CONSTEXPR u32 ticksFromHz(u32 hz)
 void tickInit(void);
 
 //! Returns the current value of the system tick counter
-u64 tickGetCount(void);
+MK_EXTERN_HOT u64 tickGetCount(void);
 
 /*! @brief Configures and starts a tick task @p t
 	@param[in] fn Event callback to invoke when the tick task needs to run.
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#include "../types.h"
+
+/*! @addtogroup alloc
+	@{
+*/
+/*! @name TLSF heap
+	Two-Level Segregated Fit allocator, providing allocation and release in
+	constant time regardless of the number or size of blocks in the heap.
+	Free blocks are indexed by size class in a two-level bitmap: the first level
+	selects a power of two range, and the second level subdivides it into
+	@ref TLSF_SL_COUNT linear classes. Adjacent free blocks are immediately
+	coalesced on release, which keeps fragmentation low over long sessions.
+
+	A heap can manage several discontiguous regions (for example main RAM and
+	Slot-2 expansion RAM), and independent heaps can be created for memories
+	that should not be mixed with general purpose allocations.
+	@note TlsfHeap objects do not perform any locking. Callers are responsible for
+	serializing accesses (for example, using a @ref Mutex).
+	@{
+*/
+
+#define TLSF_GRANULARITY_LOG2 3  //!< Log2 of @ref TLSF_GRANULARITY
+#define TLSF_GRANULARITY      (1U<<TLSF_GRANULARITY_LOG2) //!< Allocation granularity (and minimum alignment)
+#define TLSF_SL_COUNT_LOG2    4  //!< Log2 of @ref TLSF_SL_COUNT
+#define TLSF_SL_COUNT         (1U<<TLSF_SL_COUNT_LOG2) //!< Number of second level size classes per first level class
+#define TLSF_FL_MAX           25 //!< Log2 of the size limit of a single block (32 MiB)
+#define TLSF_FL_SHIFT         (TLSF_SL_COUNT_LOG2+TLSF_GRANULARITY_LOG2) //!< @private
+#define TLSF_FL_COUNT         (TLSF_FL_MAX-TLSF_FL_SHIFT+1) //!< Number of first level size classes
+
+MK_EXTERN_C_START
+
+//! @private
+typedef struct TlsfBlock TlsfBlock;
+
+//! TLSF heap object
+typedef struct TlsfHeap {
+	u32 fl_bitmap;                                       //!< @private
+	u32 sl_bitmap[TLSF_FL_COUNT];                        //!< @private
+	TlsfBlock* free_lists[TLSF_FL_COUNT][TLSF_SL_COUNT]; //!< @private
+	u32 total_sz;                                        //!< @private
+	u32 used_sz;                                         //!< @private
+	u32 peak_used_sz;                                    //!< @private
+	u32 num_free_blocks;                                 //!< @private
+} TlsfHeap;
+
+//! TLSF heap usage statistics
+typedef struct TlsfStats {
+	u32 total_sz;        //!< Total size of all regions managed by the heap (excluding bookkeeping)
+	u32 used_sz;         //!< Number of bytes currently allocated (including bookkeeping)
+	u32 peak_used_sz;    //!< Highest value @ref used_sz has ever reached
+	u32 largest_free_sz; //!< Size of the largest free block (including bookkeeping)
+	u32 num_free_blocks; //!< Number of free blocks (a measure of fragmentation)
+} TlsfStats;
+
+//! @brief Prepares an empty TlsfHeap object @p h for use
+void tlsfPrepare(TlsfHeap* h);
+
+/*! @brief Adds a memory region to TlsfHeap @p h
+	@param[in] start Start address of the region
+	@param[in] size Size of the region in bytes
+	@return true on success, false if the region is too small or too large to be usable
+	@note The region is trimmed to @ref TLSF_GRANULARITY boundaries.
+	It must not overlap any other region already managed by the heap.
+	Regions larger than 2^@ref TLSF_FL_MAX bytes must be split by the caller.
+*/
+bool tlsfAddRegion(TlsfHeap* h, void* start, size_t size);
+
+/*! @brief Allocates a block of memory from TlsfHeap @p h
+	@param[in] size Size of the block in bytes
+	@param[in] align Alignment of the block in bytes (power of two, 0 for default)
+	@return Pointer to the allocated block, or NULL on failure
+*/
+void* tlsfAlloc(TlsfHeap* h, size_t size, size_t align);
+
+/*! @brief Resizes a block @p ptr previously allocated from TlsfHeap @p h
+	@param[in] size New size of the block in bytes
+	@return Pointer to the resized block (which may have moved), or NULL on failure
+	(in which case the original block is left untouched)
+	@note If @p ptr is NULL, this behaves like @ref tlsfAlloc.
+	If @p size is 0, the block is released and NULL is returned.
+*/
+void* tlsfRealloc(TlsfHeap* h, void* ptr, size_t size);
+
+/*! @brief Releases a block @p ptr previously allocated from TlsfHeap @p h
+	@note Passing NULL is allowed and does nothing.
+*/
+void tlsfFree(TlsfHeap* h, void* ptr);
+
+//! @brief Returns the usable size of block @p ptr (which may be larger than requested)
+size_t tlsfGetUsableSize(void* ptr);
+
+//! @brief Retrieves usage statistics of TlsfHeap @p h into @p out
+void tlsfGetStats(TlsfHeap* h, TlsfStats* out);
+
+//! @brief Returns the number of free bytes in TlsfHeap @p h (this may be fragmented)
+MK_INLINE size_t tlsfGetFreeSize(TlsfHeap* h)
+{
+	return h->total_sz - h->used_sz;
+}
+
+//! @}
+
+/*! @name TLSF malloc
+	When calico is built with the `CALICO_TLSF_MALLOC` option, the newlib
+	allocator (malloc, free, realloc, memalign, etc) is replaced by a TLSF heap
+	protected by a @ref Mutex. The heap initially claims all memory available
+	to sbrk, which includes the extended main RAM of the DSi in DSi mode.
+	Additional regions (such as Slot-2 expansion RAM) can be added at runtime.
+	@note The functions below are only available in builds with this option.
+	@{
+*/
+
+/*! @brief Adds a memory region to the global malloc heap
+	@return true on success, false on failure
+	@warning Only add memory that supports 8-bit writes, such as main RAM or WRAM.
+	Some Slot-2 RAM expansions do not support them, in which case a separate
+	@ref TlsfHeap should be used instead.
+*/
+bool tlsfMallocAddRegion(void* start, size_t size);
+
+//! @brief Retrieves usage statistics of the global malloc heap into @p out
+void tlsfMallocGetStats(TlsfStats* out);
+
+//! @}
+
+MK_EXTERN_C_END
+
+//! @}
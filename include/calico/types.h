@@ -107,6 +107,29 @@ typedef volatile sptr vsptr; //!< Pointer-sized volatile signed integer.
 #define MK_EXTERN32
 #endif
 
+/*! @brief Marks an external library function that is placed in TCM/IWRAM
+	when calico is built with the `CALICO_HOT_TCM` option
+	@note This is equivalent to @ref MK_EXTERN32 in that case, and does nothing otherwise.
+*/
+#if defined(CALICO_HOT_TCM)
+#define MK_EXTERN_HOT MK_EXTERN32
+#else
+#define MK_EXTERN_HOT
+#endif
+
+/*! @brief Marks a variable as belonging to the CPU that owns it
+	@note Each CPU runs its own copy of the library on hardware, so this does
+	nothing there. The host simulator runs both CPUs as threads of the same
+	process, so it makes the variable thread-local.
+*/
+#if !defined(CALICO_HOST)
+#define MK_CPU_LOCAL
+#elif defined(__cplusplus)
+#define MK_CPU_LOCAL  thread_local
+#else
+#define MK_CPU_LOCAL  _Thread_local
+#endif
+
 /*! @brief Similar to @ref MK_INLINE, but also marking the function as eligible
 	for compile-time evaluation.
 	@note When compiling as C++, this macro adds the `constexpr` specifier,
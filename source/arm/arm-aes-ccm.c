@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <string.h>
+#include <calico/types.h>
+#include <calico/arm/aes.h>
+
+typedef struct AesCcmState {
+	u8 mac[ARM_AES_BLOCK_SZ];
+	u8 ctr[ARM_AES_BLOCK_SZ];
+	u8 s0[ARM_AES_BLOCK_SZ];
+} AesCcmState;
+
+static void _aesCcmMacTail(ArmAesContext const* ctx, AesCcmState* st, const u8* data, size_t len)
+{
+	// Authenticate all full blocks in one go
+	size_t num_blocks = len / ARM_AES_BLOCK_SZ;
+	armAesCbcMac(data, num_blocks, st->mac, ctx);
+
+	// Authenticate remaining bytes (zero padded)
+	size_t rem = len % ARM_AES_BLOCK_SZ;
+	if (rem) {
+		u8 block[ARM_AES_BLOCK_SZ] = {0};
+		memcpy(block, data + num_blocks*ARM_AES_BLOCK_SZ, rem);
+		armAesCbcMac(block, 1, st->mac, ctx);
+	}
+}
+
+static void _aesCcmCrypt(ArmAesContext const* ctx, AesCcmState* st, const u8* in, u8* out, size_t len)
+{
+	// Process all full blocks in one go
+	size_t num_blocks = len / ARM_AES_BLOCK_SZ;
+	armAesCtrCrypt(in, out, num_blocks, st->ctr, ctx);
+
+	// Process remaining bytes
+	size_t rem = len % ARM_AES_BLOCK_SZ;
+	if (rem) {
+		u8 block[ARM_AES_BLOCK_SZ] = {0};
+		memcpy(block, in + num_blocks*ARM_AES_BLOCK_SZ, rem);
+		armAesCtrCrypt(block, block, 1, st->ctr, ctx);
+		memcpy(out + num_blocks*ARM_AES_BLOCK_SZ, block, rem);
+	}
+}
+
+static bool _aesCcmInit(ArmAesContext const* ctx, AesCcmState* st, const void* nonce, size_t nonce_len,
+	const void* aad, size_t aad_len, size_t len, size_t tag_len)
+{
+	// Validate parameters
+	if (nonce_len < 7 || nonce_len > 13 || tag_len < 4 || tag_len > 16 || (tag_len & 1)) {
+		return false;
+	}
+
+	// Ensure the payload length fits in the length field
+	unsigned L = 15 - nonce_len;
+	if (L < sizeof(size_t) && (len >> (8*L))) {
+		return false;
+	}
+
+	// Build and authenticate B0: flags | nonce | payload length
+	u8 block[ARM_AES_BLOCK_SZ] = {0};
+	block[0] = (aad_len ? 0x40 : 0) | (((tag_len-2)/2) << 3) | (L-1);
+	memcpy(&block[1], nonce, nonce_len);
+	for (unsigned i = 0; i < L && i < sizeof(size_t); i ++) {
+		block[15-i] = len >> (8*i);
+	}
+
+	memset(st->mac, 0, sizeof(st->mac));
+	armAesCbcMac(block, 1, st->mac, ctx);
+
+	// Authenticate additional data (prefixed by its encoded length)
+	if (aad_len) {
+		const u8* aad8 = (const u8*)aad;
+		unsigned pos;
+
+		memset(block, 0, sizeof(block));
+		if (aad_len < 0xff00) {
+			block[0] = aad_len >> 8;
+			block[1] = aad_len;
+			pos = 2;
+		} else {
+			block[0] = 0xff;
+			block[1] = 0xfe;
+			block[2] = aad_len >> 24;
+			block[3] = aad_len >> 16;
+			block[4] = aad_len >> 8;
+			block[5] = aad_len;
+			pos = 6;
+		}
+
+		size_t first_sz = ARM_AES_BLOCK_SZ - pos;
+		if (first_sz > aad_len) {
+			first_sz = aad_len;
+		}
+
+		memcpy(&block[pos], aad8, first_sz);
+		armAesCbcMac(block, 1, st->mac, ctx);
+		_aesCcmMacTail(ctx, st, aad8 + first_sz, aad_len - first_sz);
+	}
+
+	// Build counter block A0: flags | nonce | 0
+	memset(st->ctr, 0, sizeof(st->ctr));
+	st->ctr[0] = L-1;
+	memcpy(&st->ctr[1], nonce, nonce_len);
+
+	// Calculate S0 (used to encrypt the tag), and move the counter to A1
+	armAesEncrypt(st->ctr, st->s0, ctx);
+	st->ctr[15] = 1;
+
+	return true;
+}
+
+bool armAesCcmEncrypt(ArmAesContext const* ctx, const void* nonce, size_t nonce_len,
+	const void* aad, size_t aad_len, const void* in, void* out, size_t len, void* tag, size_t tag_len)
+{
+	AesCcmState st;
+	if (!_aesCcmInit(ctx, &st, nonce, nonce_len, aad, aad_len, len, tag_len)) {
+		return false;
+	}
+
+	// Authenticate the plaintext before it is (potentially) overwritten
+	_aesCcmMacTail(ctx, &st, (const u8*)in, len);
+	_aesCcmCrypt(ctx, &st, (const u8*)in, (u8*)out, len);
+
+	// Output encrypted tag
+	u8* tag8 = (u8*)tag;
+	for (size_t i = 0; i < tag_len; i ++) {
+		tag8[i] = st.mac[i] ^ st.s0[i];
+	}
+
+	return true;
+}
+
+bool armAesCcmDecrypt(ArmAesContext const* ctx, const void* nonce, size_t nonce_len,
+	const void* aad, size_t aad_len, const void* in, void* out, size_t len, const void* tag, size_t tag_len)
+{
+	AesCcmState st;
+	if (!_aesCcmInit(ctx, &st, nonce, nonce_len, aad, aad_len, len, tag_len)) {
+		return false;
+	}
+
+	// Decrypt, then authenticate the resulting plaintext
+	_aesCcmCrypt(ctx, &st, (const u8*)in, (u8*)out, len);
+	_aesCcmMacTail(ctx, &st, (const u8*)out, len);
+
+	// Compare tags (without exiting early)
+	const u8* tag8 = (const u8*)tag;
+	u8 diff = 0;
+	for (size_t i = 0; i < tag_len; i ++) {
+		diff |= tag8[i] ^ st.mac[i] ^ st.s0[i];
+	}
+
+	return diff == 0;
+}
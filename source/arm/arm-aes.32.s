@@ -1016,3 +1016,258 @@ FUNC_START32 _armAesDecryptImpl, text, local
 	sub	r10,r10,#1024
 	ldr	pc,[sp],#4		@ pop and return
 FUNC_END
+
+@ Bulk cipher modes (calico addition)
+@
+@ These keep the state and chaining values in registers/on the stack across blocks,
+@ calling the single block cores directly in order to avoid the per-block overhead of
+@ the public entrypoints. Note that the round keys themselves cannot be kept in
+@ registers (a 128-bit key schedule alone takes up 176 bytes).
+
+@ Loads the 16-byte block at \p (any alignment) as big-endian words into \o0-\o3
+.macro AES_LOAD_BE p, o0, o1, o2, o3, t0, t1, t2
+	AES_LOAD_BE_WORD \p, 0,  \o0, \t0, \t1, \t2
+	AES_LOAD_BE_WORD \p, 4,  \o1, \t0, \t1, \t2
+	AES_LOAD_BE_WORD \p, 8,  \o2, \t0, \t1, \t2
+	AES_LOAD_BE_WORD \p, 12, \o3, \t0, \t1, \t2
+.endm
+
+.macro AES_LOAD_BE_WORD p, off, o, t0, t1, t2
+	ldrb	\o,[\p,#\off+3]
+	ldrb	\t0,[\p,#\off+2]
+	ldrb	\t1,[\p,#\off+1]
+	ldrb	\t2,[\p,#\off+0]
+	orr	\o,\o,\t0,lsl#8
+	orr	\o,\o,\t1,lsl#16
+	orr	\o,\o,\t2,lsl#24
+.endm
+
+@ Stores big-endian words \i0-\i3 as a 16-byte block at \p (any alignment)
+.macro AES_STORE_BE p, i0, i1, i2, i3, t0
+	AES_STORE_BE_WORD \p, 0,  \i0, \t0
+	AES_STORE_BE_WORD \p, 4,  \i1, \t0
+	AES_STORE_BE_WORD \p, 8,  \i2, \t0
+	AES_STORE_BE_WORD \p, 12, \i3, \t0
+.endm
+
+.macro AES_STORE_BE_WORD p, off, i, t0
+	mov	\t0,\i,lsr#24
+	strb	\t0,[\p,#\off+0]
+	mov	\t0,\i,lsr#16
+	strb	\t0,[\p,#\off+1]
+	mov	\t0,\i,lsr#8
+	strb	\t0,[\p,#\off+2]
+	strb	\i,[\p,#\off+3]
+.endm
+
+@ Stack frame used by the bulk routines (on top of the 9 pushed registers)
+#define AES_FRM_CHAIN 0   // Chaining value (counter/IV/MAC) as big-endian words
+#define AES_FRM_IN    16  // Input pointer
+#define AES_FRM_OUT   20  // Output pointer
+#define AES_FRM_NUM   24  // Number of remaining blocks
+#define AES_FRM_KEY   28  // Key schedule
+#define AES_FRM_CPTR  32  // Pointer to caller's chaining value
+#define AES_FRM_NEXT  36  // Saved ciphertext block (CBC decryption)
+#define AES_FRM_SZ    60
+#define AES_FRM_ARG4  (AES_FRM_SZ+36)
+
+// void armAesCtrCrypt(const void* in, void* out, size_t num_blocks,
+@ 		void* ctr, const ArmAesKey* key);
+FUNC_START32 armAesCtrCrypt
+	stmdb	sp!,{r4-r11,lr}
+	sub	sp,sp,#AES_FRM_SZ
+	teq	r2,#0
+	beq	.Lctr_done
+
+	ldr	r4,[sp,#AES_FRM_ARG4]
+	str	r0,[sp,#AES_FRM_IN]
+	str	r1,[sp,#AES_FRM_OUT]
+	str	r2,[sp,#AES_FRM_NUM]
+	str	r4,[sp,#AES_FRM_KEY]
+	str	r3,[sp,#AES_FRM_CPTR]
+	AES_LOAD_BE r3, r4,r5,r6,r7, r8,r9,r12
+	stmia	sp,{r4-r7}
+	ldr	r10,=_armAesTableEncode
+
+.Lctr_loop:
+	@ Generate keystream block
+	ldmia	sp,{r0-r3}
+	ldr	r11,[sp,#AES_FRM_KEY]
+	bl	_armAesEncryptImpl
+
+	@ Increment 128-bit big-endian counter
+	ldmia	sp,{r4-r7}
+	adds	r7,r7,#1
+	adcs	r6,r6,#0
+	adcs	r5,r5,#0
+	adc	r4,r4,#0
+	stmia	sp,{r4-r7}
+
+	@ Combine keystream with input
+	ldr	r12,[sp,#AES_FRM_IN]
+	AES_LOAD_BE r12, r4,r5,r6,r7, r8,r9,r11
+	eor	r0,r0,r4
+	eor	r1,r1,r5
+	eor	r2,r2,r6
+	eor	r3,r3,r7
+	add	r12,r12,#16
+	str	r12,[sp,#AES_FRM_IN]
+
+	ldr	r12,[sp,#AES_FRM_OUT]
+	AES_STORE_BE r12, r0,r1,r2,r3, r4
+	add	r12,r12,#16
+	str	r12,[sp,#AES_FRM_OUT]
+
+	ldr	r4,[sp,#AES_FRM_NUM]
+	subs	r4,r4,#1
+	str	r4,[sp,#AES_FRM_NUM]
+	bne	.Lctr_loop
+
+	@ Write back updated counter
+	ldmia	sp,{r0-r3}
+	ldr	r12,[sp,#AES_FRM_CPTR]
+	AES_STORE_BE r12, r0,r1,r2,r3, r4
+
+.Lctr_done:
+	add	sp,sp,#AES_FRM_SZ
+	ldmia	sp!,{r4-r11,lr}
+	bx	lr
+FUNC_END
+
+@ void armAesCbcEncrypt(const void* in, void* out, size_t num_blocks,
+@ 		void* iv, const ArmAesKey* key);
+FUNC_START32 armAesCbcEncrypt
+	stmdb	sp!,{r4-r11,lr}
+	ldr	r4,[sp,#36]
+	b	_armAesCbcEncryptImpl
+FUNC_END
+
+@ void armAesCbcMac(const void* in, size_t num_blocks, void* mac,
+@ 		const ArmAesKey* key);
+FUNC_START32 armAesCbcMac
+	stmdb	sp!,{r4-r11,lr}
+	mov	r4,r3			@ key
+	mov	r3,r2			@ mac (used as IV)
+	mov	r2,r1			@ num_blocks
+	mov	r1,#0			@ no output
+	b	_armAesCbcEncryptImpl
+FUNC_END
+
+@ r0=in r1=out (or NULL) r2=num_blocks r3=iv r4=key, r4-r11,lr already pushed
+FUNC_START32 _armAesCbcEncryptImpl, text, local
+	sub	sp,sp,#AES_FRM_SZ
+	teq	r2,#0
+	beq	.Lcbce_done
+
+	str	r0,[sp,#AES_FRM_IN]
+	str	r1,[sp,#AES_FRM_OUT]
+	str	r2,[sp,#AES_FRM_NUM]
+	str	r4,[sp,#AES_FRM_KEY]
+	str	r3,[sp,#AES_FRM_CPTR]
+	AES_LOAD_BE r3, r4,r5,r6,r7, r8,r9,r12
+	stmia	sp,{r4-r7}
+	ldr	r10,=_armAesTableEncode
+
+.Lcbce_loop:
+	@ Load plaintext block and combine it with the chaining value
+	ldr	r12,[sp,#AES_FRM_IN]
+	AES_LOAD_BE r12, r0,r1,r2,r3, r4,r5,r6
+	add	r12,r12,#16
+	str	r12,[sp,#AES_FRM_IN]
+	ldmia	sp,{r4-r7}
+	eor	r0,r0,r4
+	eor	r1,r1,r5
+	eor	r2,r2,r6
+	eor	r3,r3,r7
+
+	@ Encrypt, and use the result as the next chaining value
+	ldr	r11,[sp,#AES_FRM_KEY]
+	bl	_armAesEncryptImpl
+	stmia	sp,{r0-r3}
+
+	@ Store ciphertext block if needed
+	ldr	r12,[sp,#AES_FRM_OUT]
+	teq	r12,#0
+	beq	1f
+	AES_STORE_BE r12, r0,r1,r2,r3, r4
+	add	r12,r12,#16
+	str	r12,[sp,#AES_FRM_OUT]
+
+1:	ldr	r4,[sp,#AES_FRM_NUM]
+	subs	r4,r4,#1
+	str	r4,[sp,#AES_FRM_NUM]
+	bne	.Lcbce_loop
+
+	@ Write back final chaining value
+	ldmia	sp,{r0-r3}
+	ldr	r12,[sp,#AES_FRM_CPTR]
+	AES_STORE_BE r12, r0,r1,r2,r3, r4
+
+.Lcbce_done:
+	add	sp,sp,#AES_FRM_SZ
+	ldmia	sp!,{r4-r11,lr}
+	bx	lr
+FUNC_END
+
+@ void armAesCbcDecrypt(const void* in, void* out, size_t num_blocks,
+@ 		void* iv, const ArmAesKey* key);
+FUNC_START32 armAesCbcDecrypt
+	stmdb	sp!,{r4-r11,lr}
+	sub	sp,sp,#AES_FRM_SZ
+	teq	r2,#0
+	beq	.Lcbcd_done
+
+	ldr	r4,[sp,#AES_FRM_ARG4]
+	str	r0,[sp,#AES_FRM_IN]
+	str	r1,[sp,#AES_FRM_OUT]
+	str	r2,[sp,#AES_FRM_NUM]
+	str	r4,[sp,#AES_FRM_KEY]
+	str	r3,[sp,#AES_FRM_CPTR]
+	AES_LOAD_BE r3, r4,r5,r6,r7, r8,r9,r12
+	stmia	sp,{r4-r7}
+	ldr	r10,=_armAesTableDecode
+
+.Lcbcd_loop:
+	@ Load ciphertext block, and keep a copy (it is the next chaining value)
+	ldr	r12,[sp,#AES_FRM_IN]
+	AES_LOAD_BE r12, r0,r1,r2,r3, r4,r5,r6
+	add	r12,r12,#16
+	str	r12,[sp,#AES_FRM_IN]
+	add	r12,sp,#AES_FRM_NEXT
+	stmia	r12,{r0-r3}
+
+	@ Decrypt, and combine the result with the chaining value
+	ldr	r11,[sp,#AES_FRM_KEY]
+	bl	_armAesDecryptImpl
+	ldmia	sp,{r4-r7}
+	eor	r0,r0,r4
+	eor	r1,r1,r5
+	eor	r2,r2,r6
+	eor	r3,r3,r7
+
+	@ Store plaintext block
+	ldr	r12,[sp,#AES_FRM_OUT]
+	AES_STORE_BE r12, r0,r1,r2,r3, r4
+	add	r12,r12,#16
+	str	r12,[sp,#AES_FRM_OUT]
+
+	@ Update chaining value
+	add	r12,sp,#AES_FRM_NEXT
+	ldmia	r12,{r4-r7}
+	stmia	sp,{r4-r7}
+
+	ldr	r4,[sp,#AES_FRM_NUM]
+	subs	r4,r4,#1
+	str	r4,[sp,#AES_FRM_NUM]
+	bne	.Lcbcd_loop
+
+	@ Write back final chaining value
+	ldmia	sp,{r0-r3}
+	ldr	r12,[sp,#AES_FRM_CPTR]
+	AES_STORE_BE r12, r0,r1,r2,r3, r4
+
+.Lcbcd_done:
+	add	sp,sp,#AES_FRM_SZ
+	ldmia	sp!,{r4-r11,lr}
+	bx	lr
+FUNC_END
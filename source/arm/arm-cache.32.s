@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: ZPL-2.1
 // SPDX-FileCopyrightText: Copyright fincs, devkitPro
 #include <calico/asm.inc>
+#include <calico/arm/psr.h>
 #include <calico/arm/cp15.h>
 
 FUNC_START32 armDrainWriteBuffer
@@ -13,13 +14,21 @@ FUNC_END
 
 FUNC_START32 armDCacheFlushAll
 
+	@ Retrieve the lockdown base: ways below it are locked down, and
+	@ must only be cleaned (invalidating them would discard the lock)
+	mrc  p15, 0, r3, c9, c0, 0
+	and  r3, r3, #(ARM_DCACHE_WAYS-1)
+	mov  r3, r3, lsl #(32 - ARM_DCACHE_WAYS_LOG2)
+
 	@ Flush all cache lines
 	mov  r1, #0
 .Ldfa_clean_way:
 	mov  r0, #0
 .Ldfa_clean_line:
 	orr  r2, r1, r0
-	mcr  p15, 0, r2, c7, c14, 2 @ Clean+Invalidate DCache entry by Set/Way
+	cmp  r1, r3
+	mcrlo p15, 0, r2, c7, c10, 2 @ Clean DCache entry by Set/Way
+	mcrhs p15, 0, r2, c7, c14, 2 @ Clean+Invalidate DCache entry by Set/Way
 	add  r0, r0, #ARM_CACHE_LINE_SZ
 	cmp  r0, #ARM_DCACHE_SZ/ARM_DCACHE_WAYS
 	bne  .Ldfa_clean_line
@@ -77,3 +86,140 @@ FUNC_START32 armICacheInvalidate
 	bx   lr
 
 FUNC_END
+
+FUNC_START32 armDCacheLockRange
+
+	@ Calculate cache line aligned range, and check it fits in a single way
+	add  r1, r0, r1
+	bic  r0, r0, #(ARM_CACHE_LINE_SZ-1)
+	add  r1, r1, #(ARM_CACHE_LINE_SZ-1)
+	bic  r1, r1, #(ARM_CACHE_LINE_SZ-1)
+	sub  r2, r1, r0
+	cmp  r2, #(ARM_DCACHE_SZ/ARM_DCACHE_WAYS)
+	mvnhi r0, #0
+	bxhi lr
+
+	@ Disable interrupts (so that nothing else is loaded into the way)
+	mrs  r12, cpsr
+	orr  r2, r12, #ARM_PSR_I
+	msr  cpsr_c, r2
+
+	@ Retrieve the lockdown base, and check there is still an unlocked way left
+	mrc  p15, 0, r3, c9, c0, 0
+	and  r3, r3, #(ARM_DCACHE_WAYS-1)
+	cmp  r3, #(ARM_DCACHE_WAYS-1)
+	mvnhs r0, #0
+	bhs  .Ldcl_done
+
+	@ Flush the range, so that all lines are guaranteed to miss
+	mov  r2, r0
+0:	mcr  p15, 0, r2, c7, c14, 1 @ Clean+Invalidate DCache entry by MVA
+	add  r2, r2, #ARM_CACHE_LINE_SZ
+	cmp  r2, r1
+	blo  0b
+	mov  r2, #0
+	mcr  p15, 0, r2, c7, c10, 4 @ Drain write buffer
+
+	@ Enter load mode: linefills will now go to the lockdown base way
+	orr  r2, r3, #(1<<31)
+	mcr  p15, 0, r2, c9, c0, 0
+
+	@ Load the range into the cache
+0:	ldr  r2, [r0], #ARM_CACHE_LINE_SZ
+	cmp  r0, r1
+	blo  0b
+
+	@ Leave load mode, and lock down the way by moving the lockdown base past it
+	add  r2, r3, #1
+	mcr  p15, 0, r2, c9, c0, 0
+	mov  r0, r3
+
+.Ldcl_done:
+	msr  cpsr_c, r12
+	bx   lr
+
+FUNC_END
+
+FUNC_START32 armDCacheUnlock
+
+	@ Move the lockdown base back: unlocked ways keep their contents as regular cache lines
+	and  r0, r0, #(ARM_DCACHE_WAYS-1)
+	mrs  r12, cpsr
+	orr  r2, r12, #ARM_PSR_I
+	msr  cpsr_c, r2
+	mrc  p15, 0, r3, c9, c0, 0
+	and  r3, r3, #(ARM_DCACHE_WAYS-1)
+	cmp  r0, r3
+	mcrlo p15, 0, r0, c9, c0, 0
+	msr  cpsr_c, r12
+	bx   lr
+
+FUNC_END
+
+FUNC_START32 armICacheLockRange
+
+	@ Calculate cache line aligned range, and check it fits in a single way
+	add  r1, r0, r1
+	bic  r0, r0, #(ARM_CACHE_LINE_SZ-1)
+	add  r1, r1, #(ARM_CACHE_LINE_SZ-1)
+	bic  r1, r1, #(ARM_CACHE_LINE_SZ-1)
+	sub  r2, r1, r0
+	cmp  r2, #(ARM_ICACHE_SZ/ARM_ICACHE_WAYS)
+	mvnhi r0, #0
+	bxhi lr
+
+	@ Disable interrupts (so that nothing else is loaded into the way)
+	mrs  r12, cpsr
+	orr  r2, r12, #ARM_PSR_I
+	msr  cpsr_c, r2
+
+	@ Retrieve the lockdown base, and check there is still an unlocked way left
+	mrc  p15, 0, r3, c9, c0, 1
+	and  r3, r3, #(ARM_ICACHE_WAYS-1)
+	cmp  r3, #(ARM_ICACHE_WAYS-1)
+	mvnhs r0, #0
+	bhs  .Licl_done
+
+	@ Invalidate the range, so that all lines are guaranteed to miss
+	mov  r2, r0
+0:	mcr  p15, 0, r2, c7, c5, 1 @ Invalidate ICache entry by MVA
+	add  r2, r2, #ARM_CACHE_LINE_SZ
+	cmp  r2, r1
+	blo  0b
+
+	@ Enter load mode: linefills will now go to the lockdown base way
+	orr  r2, r3, #(1<<31)
+	mcr  p15, 0, r2, c9, c0, 1
+
+	@ Prefetch the range into the cache
+0:	mcr  p15, 0, r0, c7, c13, 1 @ Prefetch ICache line by MVA
+	add  r0, r0, #ARM_CACHE_LINE_SZ
+	cmp  r0, r1
+	blo  0b
+
+	@ Leave load mode, and lock down the way by moving the lockdown base past it
+	add  r2, r3, #1
+	mcr  p15, 0, r2, c9, c0, 1
+	mov  r0, r3
+
+.Licl_done:
+	msr  cpsr_c, r12
+	bx   lr
+
+FUNC_END
+
+FUNC_START32 armICacheUnlock
+
+	@ Move the lockdown base back: unlocked ways keep their contents as regular cache lines
+	and  r0, r0, #(ARM_ICACHE_WAYS-1)
+	mrs  r12, cpsr
+	orr  r2, r12, #ARM_PSR_I
+	msr  cpsr_c, r2
+	mrc  p15, 0, r3, c9, c0, 1
+	and  r3, r3, #(ARM_ICACHE_WAYS-1)
+	cmp  r0, r3
+	mcrlo p15, 0, r0, c9, c0, 1
+	msr  cpsr_c, r12
+	bx   lr
+
+FUNC_END
@@ -15,6 +15,9 @@ MK_INLINE void _fuguSwap(u32* L, u32* R)
 	*R = temp;
 }
 
+// Implemented in fugu_bulk.32.s
+MK_EXTERN32 void _fuguKeyExpand(FuguState* state);
+
 void fuguKeySchedule(FuguState* state, const u32* key, unsigned key_num_words)
 {
 	for (unsigned i = 0, p = 0; i < FUGU_NUM_ROUNDS+2; i ++) {
@@ -22,14 +25,7 @@ void fuguKeySchedule(FuguState* state, const u32* key, unsigned key_num_words)
 		if (p>=key_num_words) p = 0;
 	}
 
-	u32 pad[2] = { 0, 0 };
-	u32* out = (u32*)state;
-	for (unsigned i = 0; i < sizeof(*state)/8; i ++) {
-		fuguEncrypt(state, pad);
-		out[0] = pad[1];
-		out[1] = pad[0];
-		out += 2;
-	}
+	_fuguKeyExpand(state);
 }
 
 void fuguEncrypt(FuguState const* state, u32 buf[2])
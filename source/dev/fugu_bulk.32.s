@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <calico/asm.inc>
+
+@ Register usage for all routines below:
+@   r4-r7: Pointers to S-boxes 0-3 (r4 also used to access the P-array)
+@   r8:    S-box index mask (0xff<<2)
+@   r9-r11,lr: Scratch
+@ The P-array is accessed through negative offsets from the first S-box.
+#define FUGU_S_OFFSET (18*4)
+
+@ One Feistel round: l ^= P[pidx]; r ^= F(l)
+.macro FUGU_ROUND l, r, pidx
+	ldr   r9, [r4, #((\pidx)*4 - FUGU_S_OFFSET)]
+	eor   \l, \l, r9
+	and   r9, r8, \l, lsr #22
+	and   r10, r8, \l, lsr #14
+	and   r11, r8, \l, lsr #6
+	and   lr, r8, \l, lsl #2
+	ldr   r9, [r4, r9]
+	ldr   r10, [r5, r10]
+	ldr   r11, [r6, r11]
+	ldr   lr, [r7, lr]
+	add   r9, r9, r10
+	eor   r9, r9, r11
+	add   r9, r9, lr
+	eor   \r, \r, r9
+.endm
+
+@ Sets up S-box pointers from the FuguState pointer in r0
+.macro FUGU_SETUP
+	add   r4, r0, #FUGU_S_OFFSET
+	add   r5, r4, #0x400
+	add   r6, r4, #0x800
+	add   r7, r4, #0xc00
+	mov   r8, #0x3fc
+.endm
+
+@ Encrypts the block held in r12 (L) and r3 (R), leaving the results in r12 (L) and r3 (R)
+.macro FUGU_ENCRYPT_BLOCK
+	FUGU_ROUND r12, r3, 0
+	FUGU_ROUND r3, r12, 1
+	FUGU_ROUND r12, r3, 2
+	FUGU_ROUND r3, r12, 3
+	FUGU_ROUND r12, r3, 4
+	FUGU_ROUND r3, r12, 5
+	FUGU_ROUND r12, r3, 6
+	FUGU_ROUND r3, r12, 7
+	FUGU_ROUND r12, r3, 8
+	FUGU_ROUND r3, r12, 9
+	FUGU_ROUND r12, r3, 10
+	FUGU_ROUND r3, r12, 11
+	FUGU_ROUND r12, r3, 12
+	FUGU_ROUND r3, r12, 13
+	FUGU_ROUND r12, r3, 14
+	FUGU_ROUND r3, r12, 15
+.endm
+
+@ void fuguEncryptBlocks(FuguState const* state, const u32* in, u32* out, size_t num_blocks)
+FUNC_START32 fuguEncryptBlocks
+	cmp   r3, #0
+	bxeq  lr
+	push  {r4-r11,lr}
+	FUGU_SETUP
+	mov   r0, r1
+	mov   r1, r2
+	mov   r2, r3
+
+1:	ldmia r0!, {r3, r12}       @ r3 = buf[0] (R), r12 = buf[1] (L)
+	FUGU_ENCRYPT_BLOCK
+	ldr   r9, [r4, #(16*4 - FUGU_S_OFFSET)]
+	ldr   r10, [r4, #(17*4 - FUGU_S_OFFSET)]
+	eor   r9, r9, r12
+	eor   r10, r10, r3
+	stmia r1!, {r9, r10}
+	subs  r2, r2, #1
+	bne   1b
+
+	pop   {r4-r11,lr}
+	bx    lr
+FUNC_END
+
+@ void fuguDecryptBlocks(FuguState const* state, const u32* in, u32* out, size_t num_blocks)
+FUNC_START32 fuguDecryptBlocks
+	cmp   r3, #0
+	bxeq  lr
+	push  {r4-r11,lr}
+	FUGU_SETUP
+	mov   r0, r1
+	mov   r1, r2
+	mov   r2, r3
+
+1:	ldmia r0!, {r3, r12}       @ r3 = buf[0] (R), r12 = buf[1] (L)
+	FUGU_ROUND r12, r3, 17
+	FUGU_ROUND r3, r12, 16
+	FUGU_ROUND r12, r3, 15
+	FUGU_ROUND r3, r12, 14
+	FUGU_ROUND r12, r3, 13
+	FUGU_ROUND r3, r12, 12
+	FUGU_ROUND r12, r3, 11
+	FUGU_ROUND r3, r12, 10
+	FUGU_ROUND r12, r3, 9
+	FUGU_ROUND r3, r12, 8
+	FUGU_ROUND r12, r3, 7
+	FUGU_ROUND r3, r12, 6
+	FUGU_ROUND r12, r3, 5
+	FUGU_ROUND r3, r12, 4
+	FUGU_ROUND r12, r3, 3
+	FUGU_ROUND r3, r12, 2
+	ldr   r9, [r4, #(1*4 - FUGU_S_OFFSET)]
+	ldr   r10, [r4, #(0*4 - FUGU_S_OFFSET)]
+	eor   r9, r9, r12
+	eor   r10, r10, r3
+	stmia r1!, {r9, r10}
+	subs  r2, r2, #1
+	bne   1b
+
+	pop   {r4-r11,lr}
+	bx    lr
+FUNC_END
+
+@ void _fuguKeyExpand(FuguState* state)
+@ Regenerates the whole state by repeatedly encrypting a zero block, after the
+@ P-array has been mixed with the key. Each round reads the P-array and S-boxes
+@ from memory, so that previously written values are taken into account.
+FUNC_START32 _fuguKeyExpand
+	push  {r4-r11,lr}
+	FUGU_SETUP
+	mov   r1, r0
+	ldr   r2, =((18*4 + 4*256*4) / 8)
+	mov   r3, #0
+	mov   r12, #0
+
+1:	FUGU_ENCRYPT_BLOCK
+	ldr   r9, [r4, #(17*4 - FUGU_S_OFFSET)]
+	ldr   r10, [r4, #(16*4 - FUGU_S_OFFSET)]
+	eor   r9, r9, r3           @ buf[1]
+	eor   r10, r10, r12        @ buf[0]
+	stmia r1!, {r9, r10}       @ stored swapped
+	mov   r3, r10
+	mov   r12, r9
+	subs  r2, r2, #1
+	bne   1b
+
+	pop   {r4-r11,lr}
+	bx    lr
+FUNC_END
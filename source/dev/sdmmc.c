@@ -70,6 +70,69 @@ static bool _sdmmcCardReadCsr(SdmmcCard* card, u32* out_csr)
 	return true;
 }
 
+static bool _sdmmcCardSwitchFuncTransact(SdmmcCard* card, TmioTx* tx, u32* status, u32 arg)
+{
+	// The CPU transfer handler advances tx->user, so it needs to be reset on every transaction
+	tx->xfer_isr = tmioXferRecvByCpu;
+	tx->user = status;
+	tx->block_size = 64;
+	tx->num_blocks = 1;
+	return _sdmmcTransact(card, tx, SDMMC_CMD_SD_SWITCH_FUNC, arg);
+}
+
+static bool _sdmmcCardSwitchFunc(SdmmcCard* card, TmioTx* tx, unsigned fn)
+{
+	u32 status[64/sizeof(u32)];
+	u8* status_bytes = (u8*)status;
+
+	// Query whether the function is supported (bits 415:400) and can be selected (bits 379:376)
+	if (!_sdmmcCardSwitchFuncTransact(card, tx, status, SDMMC_CMD_SD_SWITCH_FUNC_ARG(0, fn))) {
+		return false;
+	}
+
+	if (!(status_bytes[13] & (1U<<fn)) || (status_bytes[16] & 0xf) != fn) {
+		dietPrint("SWITCH_FUNC %u unsupported\n", fn);
+		return false;
+	}
+
+	// Actually switch, and check that the card did so
+	if (!_sdmmcCardSwitchFuncTransact(card, tx, status, SDMMC_CMD_SD_SWITCH_FUNC_ARG(1, fn))) {
+		return false;
+	}
+
+	return (status_bytes[16] & 0xf) == fn;
+}
+
+static bool _sdmmcCardLowerSpeed(SdmmcCard* card)
+{
+	TmioTx tx;
+	tx.callback = NULL;
+	tx.xfer_isr = NULL;
+
+	// The failed transfer may have left the card in data state
+	_sdmmcTransact(card, &tx, SDMMC_CMD_STOP_TRANSMISSION, 0);
+
+	if (card->is_high_speed) {
+		// Go back to default speed mode first
+		card->is_high_speed = false;
+		card->port.clock = TMIO_CLKCTL_AUTO | tmioSelectClock(tmioDecodeTranSpeed(card->csd.value[3] & 0xff));
+		if (!_sdmmcCardSwitchFunc(card, &tx, SDMMC_SD_FUNC_DEFAULT_SPEED)) {
+			dietPrint("Could not leave high speed mode\n");
+		}
+	} else {
+		// Halve the clock rate instead
+		unsigned div = TMIO_CLKCTL_DIV(card->port.clock);
+		if (div >= 0x80) {
+			return false;
+		}
+
+		card->port.clock = (card->port.clock &~ TMIO_CLKCTL_DIV(0xff)) | (div ? div<<1 : 1);
+	}
+
+	dietPrint("CRC error, clock now 0x%.2x\n", card->port.clock & 0xff);
+	return true;
+}
+
 bool sdmmcCardInit(SdmmcCard* card, TmioCtl* ctl, unsigned port, bool ismmc)
 {
 	*card = (SdmmcCard){0};
@@ -228,6 +291,20 @@ bool sdmmcCardInit(SdmmcCard* card, TmioCtl* ctl, unsigned port, bool ismmc)
 		dietPrint("Switched to 4-bit width\n");
 	}
 
+	// Switch SD cards to high speed mode if supported (SD spec 1.10+ with command class 10).
+	// Note that this only changes the mode on the card side: the default speed clock
+	// (25 MHz) already selects the fastest TMIO divider (HCLK/2, ~16.76 MHz), so the bus
+	// rate stays the same and no throughput gain is to be expected on DSi.
+	const u32 scr_sd_spec = (card->scr_hi >> (56-32)) & 0xf;
+	const u32 csd_has_switch = 1U<<(84-64+10);
+	if (!ismmc && scr_sd_spec >= 1 && (card->csd.value[2] & csd_has_switch)) {
+		if (_sdmmcCardSwitchFunc(card, &tx, SDMMC_SD_FUNC_HIGH_SPEED)) {
+			card->is_high_speed = true;
+			card->port.clock = TMIO_CLKCTL_AUTO | tmioSelectClock(SDMMC_SD_HIGH_SPEED_CLOCK);
+			dietPrint("Switched to high speed (0x%.2x)\n", card->port.clock & 0xff);
+		}
+	}
+
 	return true;
 
 _error:
@@ -341,9 +418,21 @@ static bool _sdmmcCardReadWriteSectors(SdmmcCard* card, TmioTx* tx, u32 sector_i
 		sector_id *= SDMMC_SECTOR_SZ;
 	}
 
+	void* user = tx->user;
 	tx->block_size = SDMMC_SECTOR_SZ;
 	tx->num_blocks = num_sectors;
-	return _sdmmcTransact(card, tx, type, sector_id);
+	if_likely (_sdmmcTransact(card, tx, type, sector_id)) {
+		return true;
+	}
+
+	// Retry once at a lower speed if the transfer was corrupted
+	// (CPU transfer handlers advance tx->user, so it needs to be restored)
+	if ((tx->status & TMIO_STAT_BAD_CRC) && _sdmmcCardLowerSpeed(card)) {
+		tx->user = user;
+		return _sdmmcTransact(card, tx, type, sector_id);
+	}
+
+	return false;
 }
 
 bool sdmmcCardReadSectors(SdmmcCard* card, TmioTx* tx, u32 sector_id, u32 num_sectors)
@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include "host-priv.h"
+#include "../system/thread-priv.h"
+
+#define HOST_IDLE_STACK_SZ 0x10000
+
+// Nominal size given to makecontext for stacks supplied to threadPrepare.
+// Their actual size is unknown, but makecontext only uses the top address.
+#define HOST_THREAD_STACK_SZ 0x1000
+
+static alignas(16) u8 s_hostIdleStacks[HostCpu_Count][HOST_IDLE_STACK_SZ];
+
+MK_CPU_LOCAL static HostContext s_hostMainCtx, s_hostIdleCtx;
+
+static void _hostContextEntry(void)
+{
+	HostContext* ctx = s_curThread->ctx;
+	_hostIrqDeliver();
+	threadExit(ctx->entrypoint(ctx->arg));
+}
+
+static void _hostIdleEntry(void)
+{
+	for (;;) {
+		_hostCpuWaitForIrq();
+		_hostIrqDeliver();
+	}
+}
+
+void _hostContextInit(Thread* main, Thread* idle)
+{
+	// The main thread runs on the stack of the host thread. Its context is
+	// filled in the first time it is switched out.
+	main->ctx = &s_hostMainCtx;
+	s_hostMainCtx.psr = ARM_PSR_MODE_SYS;
+
+	idle->ctx = &s_hostIdleCtx;
+	s_hostIdleCtx.psr = ARM_PSR_MODE_SYS;
+	getcontext(&s_hostIdleCtx.uc);
+	s_hostIdleCtx.uc.uc_stack.ss_sp = s_hostIdleStacks[__host_cpu_id];
+	s_hostIdleCtx.uc.uc_stack.ss_size = HOST_IDLE_STACK_SZ;
+	s_hostIdleCtx.uc.uc_link = NULL;
+	makecontext(&s_hostIdleCtx.uc, _hostIdleEntry, 0);
+}
+
+void _hostContextPrepare(Thread* t, ThreadFunc entrypoint, void* arg, void* stack_top)
+{
+	// The context is stored at the top of the thread's stack
+	uptr top = ((uptr)stack_top - sizeof(HostContext)) &~ 15;
+	HostContext* ctx = (HostContext*)top;
+
+	t->ctx = ctx;
+	ctx->psr = ARM_PSR_MODE_SYS;
+	ctx->entrypoint = entrypoint;
+	ctx->arg = arg;
+	getcontext(&ctx->uc);
+	ctx->uc.uc_stack.ss_sp = (void*)(top - HOST_THREAD_STACK_SZ);
+	ctx->uc.uc_stack.ss_size = HOST_THREAD_STACK_SZ;
+	ctx->uc.uc_link = NULL;
+	makecontext(&ctx->uc, _hostContextEntry, 0);
+}
+
+void _hostContextSwitch(Thread* t, u32 psr)
+{
+	HostContext* self = s_curThread->ctx;
+	self->psr = psr;
+	s_curThread = t;
+	__host_cpsr = t->ctx->psr;
+	swapcontext(&self->uc, &t->ctx->uc);
+}
+
+void _hostContextLoad(Thread* t)
+{
+	__host_cpsr = t->ctx->psr;
+	setcontext(&t->ctx->uc);
+	__builtin_unreachable();
+}
+
+void threadSwitchTo(Thread* t, ArmIrqState st)
+{
+	if_likely ((armGetCpsr() & ARM_PSR_MODE_MASK) == ARM_PSR_MODE_IRQ) {
+		if (!s_deferredThread || t->prio < s_deferredThread->prio)
+			s_deferredThread = t;
+		armIrqUnlockByPsr(st);
+		return;
+	}
+
+	_hostContextSwitch(t, (__host_cpsr &~ (ARM_PSR_I | ARM_PSR_F)) | st);
+
+	// Deliver interrupts that became pending while this thread was switched out
+	_hostIrqDeliver();
+}
+
+size_t threadGetLocalStorageSize(void)
+{
+	// The host C library keeps its own per-thread state, and calico threads
+	// of the same simulated CPU share it
+	return 0;
+}
+
+void threadAttachLocalStorage(Thread* t, void* storage)
+{
+}
@@ -0,0 +1,255 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <string.h>
+#include <pthread.h>
+#include "host-priv.h"
+#include "../system/thread-priv.h"
+
+typedef struct HostCpuState {
+	HostIrqRegs regs;
+	HostCpuMainFn main;
+	int rc;
+
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	bool sleeping;
+	bool halt_req;
+	ucontext_t halt_uc;
+} HostCpuState;
+
+static HostCpuState s_hostCpus[HostCpu_Count];
+
+MK_CPU_LOCAL HostCpu __host_cpu_id;
+MK_CPU_LOCAL u32 __host_cpsr;
+MK_CPU_LOCAL HostIrqRegs* __host_irq_regs;
+MK_CPU_LOCAL volatile IrqMask __irq_flags;
+
+extern MK_CPU_LOCAL IrqHandler __irq_table[MK_IRQ_NUM_HANDLERS];
+
+void _threadInit(void);
+void _pxiInit(void);
+
+MK_INLINE HostCpuState* _hostCpuGetSelf(void)
+{
+	return &s_hostCpus[__host_cpu_id];
+}
+
+static void _hostCpuWake(HostCpuState* cpu)
+{
+	// The sleeping flag is set with the lock held, before the CPU rechecks its
+	// pending interrupts (see _hostCpuWaitForIrq)
+	if (__atomic_load_n(&cpu->sleeping, __ATOMIC_SEQ_CST)) {
+		pthread_mutex_lock(&cpu->lock);
+		pthread_cond_signal(&cpu->cond);
+		pthread_mutex_unlock(&cpu->lock);
+	}
+}
+
+void _hostCpuRaiseIrq(HostCpu id, IrqMask mask)
+{
+	HostCpuState* cpu = &s_hostCpus[id];
+	__atomic_fetch_or(&cpu->regs.iflags, mask, __ATOMIC_SEQ_CST);
+	_hostCpuWake(cpu);
+}
+
+void _hostCpuWaitForIrq(void)
+{
+	HostCpuState* cpu = _hostCpuGetSelf();
+
+	pthread_mutex_lock(&cpu->lock);
+	__atomic_store_n(&cpu->sleeping, true, __ATOMIC_SEQ_CST);
+
+	// Like armWaitForIrq, this ignores REG_IME
+	while (!(cpu->regs.ie & __atomic_load_n(&cpu->regs.iflags, __ATOMIC_SEQ_CST)) && !cpu->halt_req) {
+		pthread_cond_wait(&cpu->cond, &cpu->lock);
+	}
+
+	__atomic_store_n(&cpu->sleeping, false, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&cpu->lock);
+
+	if_unlikely (__atomic_load_n(&cpu->halt_req, __ATOMIC_RELAXED)) {
+		setcontext(&cpu->halt_uc);
+	}
+}
+
+void _hostIrqDeliver(void)
+{
+	HostCpuState* cpu = _hostCpuGetSelf();
+
+	for (;;) {
+		u32 psr = __host_cpsr;
+		if ((psr & ARM_PSR_I) || !cpu->regs.ime) {
+			return;
+		}
+
+		if_unlikely (__atomic_load_n(&cpu->halt_req, __ATOMIC_RELAXED)) {
+			setcontext(&cpu->halt_uc);
+		}
+
+		IrqMask pending = cpu->regs.ie & __atomic_load_n(&cpu->regs.iflags, __ATOMIC_ACQUIRE);
+		if_likely (!pending) {
+			return;
+		}
+
+		// Select an interrupt (LSB has priority) and acknowledge it
+		unsigned id = __builtin_ctz(pending);
+		IrqMask mask = 1U << id;
+		__atomic_fetch_and(&cpu->regs.iflags, ~mask, __ATOMIC_ACQ_REL);
+		__irq_flags |= mask;
+
+		// Call the handler in IRQ mode
+		__host_cpsr = ARM_PSR_MODE_IRQ | ARM_PSR_I;
+		IrqHandler handler = __irq_table[id];
+		if (handler) {
+			handler();
+		}
+
+		// Wake up threads waiting on this interrupt
+		mask &= s_irqWaitMask;
+		if (mask) {
+			s_irqWaitMask &= ~mask;
+			__irq_flags &= ~mask;
+			threadUnblockAllByMask(&s_irqWaitList, mask);
+		}
+
+		// Switch to the thread selected by the handler, if any. We resume here
+		// once another thread switches back to the interrupted thread.
+		__host_cpsr = psr;
+		Thread* t = s_deferredThread;
+		if (t) {
+			s_deferredThread = NULL;
+			_hostContextSwitch(t, psr);
+		}
+	}
+}
+
+u32 armGetCpsr(void)
+{
+	return __host_cpsr;
+}
+
+void armSetCpsrC(u32 value)
+{
+	__host_cpsr = value & (ARM_PSR_MODE_MASK | ARM_PSR_I | ARM_PSR_F);
+	_hostIrqDeliver();
+}
+
+ArmIrqState armIrqLockByPsr(void)
+{
+	u32 psr = __host_cpsr;
+	__host_cpsr = psr | ARM_PSR_I | ARM_PSR_F;
+	return psr & (ARM_PSR_I | ARM_PSR_F);
+}
+
+void armIrqUnlockByPsr(ArmIrqState st)
+{
+	__host_cpsr = (__host_cpsr &~ (ARM_PSR_I | ARM_PSR_F)) | st;
+	_hostIrqDeliver();
+}
+
+u32 armSwapWord(u32 value, vu32* addr)
+{
+	return __atomic_exchange_n(addr, value, __ATOMIC_SEQ_CST);
+}
+
+u8 armSwapByte(u8 value, vu8* addr)
+{
+	return __atomic_exchange_n(addr, value, __ATOMIC_SEQ_CST);
+}
+
+void armCopyMem32(void* dst, const void* src, size_t size)
+{
+	memcpy(dst, src, size);
+}
+
+void armFillMem32(void* dst, u32 value, size_t size)
+{
+	u32* p = (u32*)dst;
+	for (size_t i = 0; i < size/4; i ++) {
+		p[i] = value;
+	}
+}
+
+IrqState irqLock(void)
+{
+	IrqState saved = REG_IME;
+	REG_IME = 0;
+	return saved;
+}
+
+void irqUnlock(IrqState state)
+{
+	REG_IME = state;
+	_hostIrqDeliver();
+}
+
+HostCpu hostCpuGetId(void)
+{
+	return __host_cpu_id;
+}
+
+static void* _hostCpuThread(void* arg)
+{
+	HostCpuState* cpu = (HostCpuState*)arg;
+	volatile bool started = false;
+
+	__host_cpu_id = (HostCpu)(cpu - s_hostCpus);
+	__host_cpsr = ARM_PSR_MODE_SYS;
+	__host_irq_regs = &cpu->regs;
+
+	// Halt requests return here, abandoning all threads of this CPU
+	getcontext(&cpu->halt_uc);
+	if (started) {
+		return NULL;
+	}
+
+	started = true;
+	REG_IME = 1;
+	_threadInit();
+	_pxiInit();
+
+	cpu->rc = cpu->main();
+	return NULL;
+}
+
+static void _hostCpuHalt(HostCpuState* cpu)
+{
+	pthread_mutex_lock(&cpu->lock);
+	__atomic_store_n(&cpu->halt_req, true, __ATOMIC_SEQ_CST);
+	pthread_cond_signal(&cpu->cond);
+	pthread_mutex_unlock(&cpu->lock);
+}
+
+int hostRun(HostCpuMainFn arm9_main, HostCpuMainFn arm7_main)
+{
+	_hostPxiReset();
+
+	for (unsigned i = 0; i < HostCpu_Count; i ++) {
+		HostCpuState* cpu = &s_hostCpus[i];
+		memset(cpu, 0, sizeof(*cpu));
+		pthread_mutex_init(&cpu->lock, NULL);
+		pthread_cond_init(&cpu->cond, NULL);
+	}
+
+	s_hostCpus[HostCpu_Arm9].main = arm9_main;
+	s_hostCpus[HostCpu_Arm7].main = arm7_main;
+
+	_hostTimerThreadStart();
+	for (unsigned i = 0; i < HostCpu_Count; i ++) {
+		pthread_create(&s_hostCpus[i].thread, NULL, _hostCpuThread, &s_hostCpus[i]);
+	}
+
+	pthread_join(s_hostCpus[HostCpu_Arm9].thread, NULL);
+	_hostCpuHalt(&s_hostCpus[HostCpu_Arm7]);
+	pthread_join(s_hostCpus[HostCpu_Arm7].thread, NULL);
+	_hostTimerThreadStop();
+
+	for (unsigned i = 0; i < HostCpu_Count; i ++) {
+		HostCpuState* cpu = &s_hostCpus[i];
+		pthread_mutex_destroy(&cpu->lock);
+		pthread_cond_destroy(&cpu->cond);
+	}
+
+	return s_hostCpus[HostCpu_Arm9].rc;
+}
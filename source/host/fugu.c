@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <calico/dev/fugu.h>
+
+// Portable versions of the routines in source/dev/fugu_bulk.32.s
+
+void _fuguKeyExpand(FuguState* state)
+{
+	u32 pad[2] = { 0, 0 };
+	u32* out = (u32*)state;
+	for (unsigned i = 0; i < sizeof(*state)/8; i ++) {
+		fuguEncrypt(state, pad);
+		out[0] = pad[1];
+		out[1] = pad[0];
+		out += 2;
+	}
+}
+
+void fuguEncryptBlocks(FuguState const* state, const u32* in, u32* out, size_t num_blocks)
+{
+	for (size_t i = 0; i < num_blocks; i ++, in += 2, out += 2) {
+		u32 buf[2] = { in[0], in[1] };
+		fuguEncrypt(state, buf);
+		out[0] = buf[0];
+		out[1] = buf[1];
+	}
+}
+
+void fuguDecryptBlocks(FuguState const* state, const u32* in, u32* out, size_t num_blocks)
+{
+	for (size_t i = 0; i < num_blocks; i ++, in += 2, out += 2) {
+		u32 buf[2] = { in[0], in[1] };
+		fuguDecrypt(state, buf);
+		out[0] = buf[0];
+		out[1] = buf[1];
+	}
+}
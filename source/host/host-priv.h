@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#include <ucontext.h>
+#include <calico/types.h>
+#include <calico/arm/common.h>
+#include <calico/system/irq.h>
+#include <calico/system/thread.h>
+#include <calico/host/sim.h>
+
+struct HostContext {
+	ucontext_t uc;
+	u32 psr;
+	ThreadFunc entrypoint;
+	void* arg;
+};
+
+// Simulated CPU the calling host thread is running
+extern MK_CPU_LOCAL HostCpu __host_cpu_id;
+
+// Simulated CPSR of the current CPU (mode and I/F bits only)
+extern MK_CPU_LOCAL u32 __host_cpsr;
+
+// Interrupt controller
+void _hostIrqDeliver(void);
+void _hostCpuRaiseIrq(HostCpu cpu, IrqMask mask);
+void _hostCpuWaitForIrq(void);
+
+// Thread contexts
+void _hostContextInit(Thread* main, Thread* idle);
+void _hostContextPrepare(Thread* t, ThreadFunc entrypoint, void* arg, void* stack_top);
+void _hostContextSwitch(Thread* t, u32 psr);
+void _hostContextLoad(Thread* t) MK_NORETURN;
+
+// Tick timer (measured in TICK_FREQ units)
+void _hostTimerThreadStart(void);
+void _hostTimerThreadStop(void);
+void _hostTimerStart(u32 delay_ticks);
+void _hostTimerStop(void);
+u64 _hostTimerGetTicks(void);
+
+// PXI
+void _hostPxiReset(void);
@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <string.h>
+#include "pxi_hw.h"
+
+HostPxiPort __host_pxi[HostCpu_Count];
+HostTransferRegion __host_transfer;
+
+void _hostPxiReset(void)
+{
+	memset(__host_pxi, 0, sizeof(__host_pxi));
+	memset(&__host_transfer, 0, sizeof(__host_transfer));
+}
+
+void _pxiHwInit(void)
+{
+	// Pings sent before this point are lost, like on hardware
+	__atomic_store_n(&__host_pxi[__host_cpu_id].sync_irq, true, __ATOMIC_SEQ_CST);
+}
+
+void pxiPing(void)
+{
+	HostCpu remote = (HostCpu)(__host_cpu_id^1);
+	if (__atomic_load_n(&__host_pxi[remote].sync_irq, __ATOMIC_SEQ_CST)) {
+		_hostCpuRaiseIrq(remote, IRQ_PXI_SYNC);
+	}
+}
+
+void hostPxiSyncSend(unsigned value)
+{
+	__atomic_store_n(&__host_pxi[__host_cpu_id].sync_value, value & 0xF, __ATOMIC_RELEASE);
+}
+
+unsigned hostPxiSyncRecv(void)
+{
+	return __atomic_load_n(&__host_pxi[__host_cpu_id^1].sync_value, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#include <calico/types.h>
+#include <calico/nds/pxi.h>
+#include "host-priv.h"
+
+// Simulated PXI hardware, as seen by source/nds/pxi.c.
+// The FIFOs have the same depth as on hardware. Like on hardware, the receive
+// interrupt is raised when a FIFO stops being empty, and the send interrupt
+// is raised when it becomes empty. The accesses that decide whether to raise
+// an interrupt are sequentially consistent, so that either the receiver sees
+// the new word or the sender sees the FIFO as empty (and vice versa).
+
+#define HOST_PXI_FIFO_WORDS 16
+
+typedef struct HostPxiPort {
+	// Send FIFO (written by the owner, read by the other CPU)
+	u32 rd, wr;
+	u32 words[HOST_PXI_FIFO_WORDS];
+
+	u32 sync_value;
+	bool sync_irq;
+} HostPxiPort;
+
+// Stand-in for the NDS transfer region (see source/nds/transfer.h)
+typedef struct HostTransferRegion {
+	u32 pxi_mask[HostCpu_Count];
+	vu8 doorbells[HostCpu_Count][PXI_NUM_DOORBELLS];
+} HostTransferRegion;
+
+extern HostPxiPort __host_pxi[HostCpu_Count];
+extern HostTransferRegion __host_transfer;
+
+#define s_pxiLocalPxiMask    __host_transfer.pxi_mask[__host_cpu_id]
+#define s_pxiRemotePxiMask   __host_transfer.pxi_mask[__host_cpu_id^1]
+#define s_pxiLocalDoorbells  __host_transfer.doorbells[__host_cpu_id]
+#define s_pxiRemoteDoorbells __host_transfer.doorbells[__host_cpu_id^1]
+
+MK_INLINE bool _pxiHwIsRecvEmpty(void)
+{
+	HostPxiPort* p = &__host_pxi[__host_cpu_id^1];
+	return __atomic_load_n(&p->wr, __ATOMIC_SEQ_CST) == p->rd;
+}
+
+MK_INLINE bool _pxiHwIsSendFull(void)
+{
+	HostPxiPort* p = &__host_pxi[__host_cpu_id];
+	return (p->wr - __atomic_load_n(&p->rd, __ATOMIC_ACQUIRE)) >= HOST_PXI_FIFO_WORDS;
+}
+
+MK_INLINE u32 _pxiHwRecv(void)
+{
+	HostPxiPort* p = &__host_pxi[__host_cpu_id^1];
+	u32 rd = p->rd;
+	u32 data = p->words[rd % HOST_PXI_FIFO_WORDS];
+
+	__atomic_store_n(&p->rd, ++rd, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&p->wr, __ATOMIC_SEQ_CST) == rd) {
+		_hostCpuRaiseIrq((HostCpu)(__host_cpu_id^1), IRQ_PXI_SEND);
+	}
+
+	return data;
+}
+
+MK_INLINE void _pxiHwSend(u32 data)
+{
+	HostPxiPort* p = &__host_pxi[__host_cpu_id];
+	u32 wr = p->wr;
+	p->words[wr % HOST_PXI_FIFO_WORDS] = data;
+
+	__atomic_store_n(&p->wr, wr + 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&p->rd, __ATOMIC_SEQ_CST) == wr) {
+		_hostCpuRaiseIrq((HostCpu)(__host_cpu_id^1), IRQ_PXI_RECV);
+	}
+}
+
+void _pxiHwInit(void);
@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <time.h>
+#include <pthread.h>
+#include <calico/system/tick.h>
+#include "host-priv.h"
+
+#define NSEC_PER_SEC 1000000000ULL
+
+typedef struct HostTimer {
+	bool active;
+	u64 deadline; // nanoseconds since simulation start
+} HostTimer;
+
+static pthread_t s_hostTimerThread;
+static pthread_mutex_t s_hostTimerLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_hostTimerCond;
+static bool s_hostTimerQuit;
+static u64 s_hostTimerEpoch;
+static HostTimer s_hostTimers[HostCpu_Count];
+
+MK_INLINE u64 _hostTimerGetMonotonicNsec(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+MK_INLINE u64 _hostTimerGetNsec(void)
+{
+	return _hostTimerGetMonotonicNsec() - s_hostTimerEpoch;
+}
+
+static void* _hostTimerThreadMain(void* arg)
+{
+	pthread_mutex_lock(&s_hostTimerLock);
+
+	while (!s_hostTimerQuit) {
+		u64 now = _hostTimerGetNsec();
+		u64 next = UINT64_MAX;
+
+		// Fire expired timers, and find out when the next one expires
+		for (unsigned i = 0; i < HostCpu_Count; i ++) {
+			HostTimer* t = &s_hostTimers[i];
+			if (!t->active) {
+				continue;
+			}
+
+			if (t->deadline <= now) {
+				t->active = false;
+				_hostCpuRaiseIrq((HostCpu)i, IRQ_TIMER3);
+			} else if (t->deadline < next) {
+				next = t->deadline;
+			}
+		}
+
+		if (next == UINT64_MAX) {
+			pthread_cond_wait(&s_hostTimerCond, &s_hostTimerLock);
+		} else {
+			next += s_hostTimerEpoch;
+			struct timespec ts = { .tv_sec = next / NSEC_PER_SEC, .tv_nsec = next % NSEC_PER_SEC };
+			pthread_cond_timedwait(&s_hostTimerCond, &s_hostTimerLock, &ts);
+		}
+	}
+
+	pthread_mutex_unlock(&s_hostTimerLock);
+	return NULL;
+}
+
+void _hostTimerThreadStart(void)
+{
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&s_hostTimerCond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	s_hostTimerQuit = false;
+	s_hostTimerEpoch = _hostTimerGetMonotonicNsec();
+	for (unsigned i = 0; i < HostCpu_Count; i ++) {
+		s_hostTimers[i].active = false;
+	}
+
+	pthread_create(&s_hostTimerThread, NULL, _hostTimerThreadMain, NULL);
+}
+
+void _hostTimerThreadStop(void)
+{
+	pthread_mutex_lock(&s_hostTimerLock);
+	s_hostTimerQuit = true;
+	pthread_cond_signal(&s_hostTimerCond);
+	pthread_mutex_unlock(&s_hostTimerLock);
+
+	pthread_join(s_hostTimerThread, NULL);
+	pthread_cond_destroy(&s_hostTimerCond);
+}
+
+void _hostTimerStart(u32 delay_ticks)
+{
+	// Round up, so that the tick counter has reached the target when the timer fires
+	u64 delay = (delay_ticks * NSEC_PER_SEC + TICK_FREQ - 1) / TICK_FREQ;
+
+	pthread_mutex_lock(&s_hostTimerLock);
+	HostTimer* t = &s_hostTimers[__host_cpu_id];
+	t->active = true;
+	t->deadline = _hostTimerGetNsec() + delay;
+	pthread_cond_signal(&s_hostTimerCond);
+	pthread_mutex_unlock(&s_hostTimerLock);
+}
+
+void _hostTimerStop(void)
+{
+	pthread_mutex_lock(&s_hostTimerLock);
+	s_hostTimers[__host_cpu_id].active = false;
+	pthread_mutex_unlock(&s_hostTimerLock);
+}
+
+u64 _hostTimerGetTicks(void)
+{
+	u64 ns = _hostTimerGetNsec();
+	return (ns / NSEC_PER_SEC) * TICK_FREQ + (ns % NSEC_PER_SEC) * TICK_FREQ / NSEC_PER_SEC;
+}
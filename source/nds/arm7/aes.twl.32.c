@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <calico/types.h>
+#include <calico/system/thread.h>
+#include <calico/system/mutex.h>
+#include <calico/system/mailbox.h>
+#include <calico/nds/pxi.h>
+#include <calico/nds/ndma.h>
+#include <calico/nds/arm7/aes.h>
+
+#include "../pxi/crypto.h"
+
+// Keyslot 0 is not used by the system, so we freely overwrite its normal key
+#define AES_SERVER_KEY_SLOT AesKeySlot_Unk0
+
+// NDMA channel 2 is only used by twlblk during AES transfers, which are
+// serialized with our own usage through the AES lock. The other channels
+// are used by other drivers at any time (0: mic, 1: wifi, 3: SD/eMMC).
+#define AES_SERVER_NDMA_CH 2
+
+static Mutex s_aesMutex;
+
+static Mailbox s_aesPxiMailbox;
+static u32 s_aesPxiMailboxData[PXI_CRYPTO_MAX_JOBS];
+static Thread s_aesPxiThread;
+alignas(8) static u8 s_aesPxiThreadStack[512];
+
+void aesLock(void)
+{
+	mutexLock(&s_aesMutex);
+}
+
+void aesUnlock(void)
+{
+	mutexUnlock(&s_aesMutex);
+}
+
+static void _aesCtrCryptChunk(const u32* in, u32* out, u32 num_words)
+{
+	// Drain the read FIFO using NDMA
+	REG_NDMAxSAD(AES_SERVER_NDMA_CH) = (uptr)&REG_AES_RDFIFO;
+	REG_NDMAxDAD(AES_SERVER_NDMA_CH) = (uptr)out;
+	REG_NDMAxBCNT(AES_SERVER_NDMA_CH) = 0;
+	REG_NDMAxTCNT(AES_SERVER_NDMA_CH) = num_words;
+	REG_NDMAxWCNT(AES_SERVER_NDMA_CH) = AES_BLOCK_SZ_WORDS;
+	REG_NDMAxCNT(AES_SERVER_NDMA_CH) =
+		NDMA_DST_MODE(NdmaMode_Increment) |
+		NDMA_SRC_MODE(NdmaMode_Fixed) |
+		NDMA_BLK_WORDS(AES_BLOCK_SZ_WORDS) |
+		NDMA_TIMING(NdmaTiming_AesRdFifo) |
+		NDMA_TX_MODE(NdmaTxMode_Timing) |
+		NDMA_START;
+
+	REG_AES_CNT =
+		AES_WRFIFO_FLUSH | AES_RDFIFO_FLUSH |
+		AES_WRFIFO_DMA_SIZE(AesWrfifoDma_16) | AES_RDFIFO_DMA_SIZE(AesRdfifoDma_4) |
+		AES_MODE(AesMode_Ctr) |
+		AES_ENABLE;
+
+	// Feed the write FIFO using the CPU. Note that the ARM7 has no cache, so it
+	// would end up stalled during a second DMA transfer anyway.
+	while (num_words) {
+		u32 cur_words = num_words > AES_FIFO_SZ_WORDS ? AES_FIFO_SZ_WORDS : num_words;
+		while (AES_WRFIFO_COUNT(REG_AES_CNT) > AES_FIFO_SZ_WORDS - cur_words);
+
+		for (u32 i = 0; i < cur_words; i ++) {
+			REG_AES_WRFIFO = *in++;
+		}
+
+		num_words -= cur_words;
+	}
+
+	ndmaBusyWait(AES_SERVER_NDMA_CH);
+}
+
+static bool _aesCtrCrypt(const PxiCryptoJob* job)
+{
+	const u32* in = (const u32*)job->in;
+	u32* out = (u32*)job->out;
+	u32 len = job->len;
+
+	if (!len || (len & (AES_BLOCK_SZ-1))) {
+		return false;
+	}
+
+	AesBlock key, iv;
+	for (unsigned i = 0; i < AES_BLOCK_SZ_WORDS; i ++) {
+		key.data[i] = job->key[i];
+		iv.data[i] = job->ctr[i];
+	}
+
+	aesLock();
+
+	aesBusyWaitReady();
+	REG_AES_SLOTxKEY(AES_SERVER_KEY_SLOT) = key;
+	aesSelectKeySlot(AES_SERVER_KEY_SLOT);
+
+	while (len) {
+		u32 cur_len = len > AES_MAX_PAYLOAD_SZ ? AES_MAX_PAYLOAD_SZ : len;
+
+		aesBusyWaitReady();
+		REG_AES_IV = iv;
+		REG_AES_LEN = (cur_len/AES_BLOCK_SZ) << 16;
+		_aesCtrCryptChunk(in, out, cur_len/sizeof(u32));
+
+		aesCtrIncrementIv(&iv, cur_len/AES_BLOCK_SZ);
+		in += cur_len/sizeof(u32);
+		out += cur_len/sizeof(u32);
+		len -= cur_len;
+	}
+
+	aesUnlock();
+	return true;
+}
+
+static int _aesPxiThread(void* unused)
+{
+	for (;;) {
+		u32 msg = mailboxRecv(&s_aesPxiMailbox);
+		u32 reply = 0;
+
+		switch (pxiCryptoMsgGetType(msg)) {
+			default: break;
+
+			case PxiCryptoMsg_CtrCrypt:
+				reply = _aesCtrCrypt(pxiCryptoMsgGetJob(msg));
+				break;
+		}
+
+		// Completion is sent as a request, as the ARM9 does not wait for a reply
+		pxiSend(PxiChannel_Crypto, reply);
+	}
+
+	return 0;
+}
+
+void aesStartServer(u8 thread_prio)
+{
+	if (threadIsValid(&s_aesPxiThread)) {
+		return;
+	}
+
+	mailboxPrepare(&s_aesPxiMailbox, s_aesPxiMailboxData, sizeof(s_aesPxiMailboxData)/sizeof(u32));
+	pxiSetMailbox(PxiChannel_Crypto, &s_aesPxiMailbox);
+	threadPrepare(&s_aesPxiThread, _aesPxiThread, NULL, &s_aesPxiThreadStack[sizeof(s_aesPxiThreadStack)], thread_prio);
+	threadStart(&s_aesPxiThread);
+}
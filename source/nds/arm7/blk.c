@@ -7,6 +7,7 @@
 #include <calico/dev/blk.h>
 #include <calico/nds/system.h>
 #include <calico/nds/pxi.h>
+#include <calico/nds/arm7/aes.h>
 #include <calico/nds/arm7/twlblk.h>
 
 #include "../crt0.h"
@@ -18,56 +19,201 @@ static BlkDevCallbackFn s_blkDevCallback;
 static DISC_INTERFACE* s_dldiDiscIface;
 static bool s_blkHasTwl;
 
+// Physical units used for request ordering and statistics (the AES view of NAND shares the same unit)
+#define BLK_QUEUE_NUM_UNITS 3
+
+// Merged requests are kept well within the limits of the TMIO block counter and the AES engine
+#define BLK_QUEUE_MAX_MERGE_SECTORS 1024
+
+typedef struct BlkQueueEntry {
+	u8 type;
+	u8 dev;
+	u8 unit;
+	u8 tag;
+	uptr buffer;
+	u32 first_sector;
+	u32 num_sectors;
+} BlkQueueEntry;
+
 static Mailbox s_blkPxiMailbox;
-static u32 s_blkPxiMailboxData[8];
+static u32 s_blkPxiMailboxData[4*PXI_NUM_TAGS];
 static Thread s_blkPxiThread;
 alignas(8) static u8 s_blkPxiThreadStack[1024];
 
-static int _blkPxiThread(void* unused)
+static BlkQueueEntry s_blkQueue[PXI_NUM_TAGS];
+static unsigned s_blkQueueCount;
+static BlkQueueStats s_blkQueueStats[BLK_QUEUE_NUM_UNITS];
+
+MK_INLINE unsigned _blkQueueGetUnit(unsigned dev)
 {
-	for (;;) {
-		u32 msg = mailboxRecv(&s_blkPxiMailbox);
+	return dev == BlkDevice_TwlNandAes ? BlkDevice_TwlNand : dev;
+}
 
-		PxiBlkDevMsgType type = pxiBlkDevMsgGetType(msg);
-		u32 imm = pxiBlkDevMsgGetImmediate(msg);
-		u32 reply = 0;
+static void _blkQueueUpdateStats(unsigned unit, int depth_delta, unsigned num_merged)
+{
+	if (unit >= BLK_QUEUE_NUM_UNITS) {
+		return;
+	}
 
-		switch (type) {
-			default: break;
+	BlkQueueStats* stats = &s_blkQueueStats[unit];
+	if (depth_delta > 0) {
+		stats->num_requests += depth_delta;
+	}
+	stats->cur_depth += depth_delta;
+	stats->num_merged += num_merged;
+	if (stats->cur_depth > stats->max_depth) {
+		stats->max_depth = stats->cur_depth;
+	}
 
-			case PxiBlkDevMsg_IsPresent:
-				reply = blkDevIsPresent((BlkDevice)imm);
-				break;
+	_transferSetBlkDevQueueStats(unit, stats);
+}
 
-			case PxiBlkDevMsg_Init:
-				reply = blkDevInit((BlkDevice)imm);
-				break;
+static bool _blkQueueIsBlocked(unsigned i, u32 pending_mask)
+{
+	// A request cannot be serviced before an earlier overlapping request, unless both are reads
+	BlkQueueEntry* e = &s_blkQueue[i];
+	for (unsigned j = 0; j < i; j ++) {
+		BlkQueueEntry* o = &s_blkQueue[j];
+		if (!(pending_mask & (1U<<j)) || o->unit != e->unit) {
+			continue;
+		}
 
-			case PxiBlkDevMsg_ReadSectors:
-			case PxiBlkDevMsg_WriteSectors: {
-				void* buffer = (void*)mailboxRecv(&s_blkPxiMailbox);
-				u32 first_sector = mailboxRecv(&s_blkPxiMailbox);
-				u32 num_sectors = mailboxRecv(&s_blkPxiMailbox);
+		if (o->type == PxiBlkDevMsg_ReadSectors && e->type == PxiBlkDevMsg_ReadSectors) {
+			continue;
+		}
 
-				if (type == PxiBlkDevMsg_ReadSectors) {
-					reply = blkDevReadSectors((BlkDevice)imm, buffer, first_sector, num_sectors);
-				} else /* if (type == PxiBlkDevCmd_WriteSectors) */ {
-					reply = blkDevWriteSectors((BlkDevice)imm, buffer, first_sector, num_sectors);
+		if (o->first_sector < e->first_sector + e->num_sectors && e->first_sector < o->first_sector + o->num_sectors) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void _blkQueueFlush(void)
+{
+	unsigned count = s_blkQueueCount;
+	u32 pending_mask = (1U << count) - 1;
+
+	while (pending_mask) {
+		// Select the eligible request with the lowest unit/sector
+		unsigned sel = count;
+		for (unsigned i = 0; i < count; i ++) {
+			if (!(pending_mask & (1U<<i)) || _blkQueueIsBlocked(i, pending_mask)) {
+				continue;
+			}
+
+			BlkQueueEntry* e = &s_blkQueue[i];
+			if (sel == count || e->unit < s_blkQueue[sel].unit ||
+				(e->unit == s_blkQueue[sel].unit && e->first_sector < s_blkQueue[sel].first_sector)) {
+				sel = i;
+			}
+		}
+
+		// Merge eligible requests that are contiguous both on the device and in memory
+		BlkQueueEntry* head = &s_blkQueue[sel];
+		u32 group_mask = 1U << sel;
+		u32 num_sectors = head->num_sectors;
+		pending_mask &= ~group_mask;
+
+		// Each merge restarts the scan, as an earlier request may now be contiguous
+		bool merged;
+		do {
+			merged = false;
+			for (unsigned i = 0; i < count; i ++) {
+				BlkQueueEntry* e = &s_blkQueue[i];
+				if (!(pending_mask & (1U<<i)) || e->dev != head->dev || e->type != head->type) {
+					continue;
+				}
+
+				if (e->first_sector != head->first_sector + num_sectors ||
+					e->buffer != head->buffer + num_sectors*BLK_SECTOR_SZ ||
+					num_sectors + e->num_sectors > BLK_QUEUE_MAX_MERGE_SECTORS ||
+					_blkQueueIsBlocked(i, pending_mask)) {
+					continue;
 				}
+
+				group_mask |= 1U << i;
+				pending_mask &= ~(1U << i);
+				num_sectors += e->num_sectors;
+				merged = true;
 				break;
 			}
+		} while (merged);
 
-			case PxiBlkDevMsg_DumpDldi: {
-				void* buffer = (void*)mailboxRecv(&s_blkPxiMailbox);
-				if (s_dldiDiscIface) {
-					DldiHeader* dldi = (DldiHeader*)((u8*)s_dldiDiscIface - offsetof(DldiHeader, disc));
-					armCopyMem32(buffer, dldi, 1U << dldi->driver_sz_log2);
-					reply = 1;
-				}
+		bool rc;
+		if (head->type == PxiBlkDevMsg_ReadSectors) {
+			rc = blkDevReadSectors((BlkDevice)head->dev, (void*)head->buffer, head->first_sector, num_sectors);
+		} else /* if (head->type == PxiBlkDevMsg_WriteSectors) */ {
+			rc = blkDevWriteSectors((BlkDevice)head->dev, (const void*)head->buffer, head->first_sector, num_sectors);
+		}
+
+		unsigned num_group = __builtin_popcount(group_mask);
+		_blkQueueUpdateStats(head->unit, -(int)num_group, num_group-1);
+
+		for (unsigned i = 0; i < count; i ++) {
+			if (group_mask & (1U<<i)) {
+				pxiReplyTagged(PxiChannel_BlkDev, s_blkQueue[i].tag, rc);
 			}
 		}
+	}
+
+	s_blkQueueCount = 0;
+}
+
+static int _blkPxiThread(void* unused)
+{
+	for (;;) {
+		u32 msg = mailboxRecv(&s_blkPxiMailbox);
+
+		// Collect all requests that are already pending, so that they can be reordered and merged
+		do {
+			PxiBlkDevMsgType type = pxiBlkDevMsgGetType(msg);
+			u32 imm = pxiBlkDevMsgGetImmediate(msg);
+			unsigned tag = pxiBlkDevMsgGetTag(msg);
+			u32 reply = 0;
+
+			if (type == PxiBlkDevMsg_ReadSectors || type == PxiBlkDevMsg_WriteSectors) {
+				BlkQueueEntry* e = &s_blkQueue[s_blkQueueCount++];
+				e->type = type;
+				e->dev = imm;
+				e->unit = _blkQueueGetUnit(imm);
+				e->tag = tag;
+				e->buffer = mailboxRecv(&s_blkPxiMailbox);
+				e->first_sector = mailboxRecv(&s_blkPxiMailbox);
+				e->num_sectors = mailboxRecv(&s_blkPxiMailbox);
+				_blkQueueUpdateStats(e->unit, 1, 0);
+				continue;
+			}
+
+			// Other requests act as a barrier
+			_blkQueueFlush();
+
+			switch (type) {
+				default: break;
+
+				case PxiBlkDevMsg_IsPresent:
+					reply = blkDevIsPresent((BlkDevice)imm);
+					break;
+
+				case PxiBlkDevMsg_Init:
+					reply = blkDevInit((BlkDevice)imm);
+					break;
+
+				case PxiBlkDevMsg_DumpDldi: {
+					void* buffer = (void*)mailboxRecv(&s_blkPxiMailbox);
+					if (s_dldiDiscIface) {
+						DldiHeader* dldi = (DldiHeader*)((u8*)s_dldiDiscIface - offsetof(DldiHeader, disc));
+						armCopyMem32(buffer, dldi, 1U << dldi->driver_sz_log2);
+						reply = 1;
+					}
+				}
+			}
+
+			pxiReplyTagged(PxiChannel_BlkDev, tag, reply);
+		} while (s_blkQueueCount < PXI_NUM_TAGS && mailboxTryRecv(&s_blkPxiMailbox, &msg));
 
-		pxiReply(PxiChannel_BlkDev, reply);
+		_blkQueueFlush();
 	}
 
 	return 0;
@@ -77,6 +223,9 @@ void blkInit(void)
 {
 	if (systemIsTwlMode()) {
 		s_blkHasTwl = twlblkInit();
+
+		// Start the ARM9 crypto service, which shares the AES engine with the eMMC driver
+		aesStartServer(THREAD_MIN_PRIO-1);
 	}
 
 	mailboxPrepare(&s_blkPxiMailbox, s_blkPxiMailboxData, sizeof(s_blkPxiMailboxData)/sizeof(u32));
@@ -118,7 +267,7 @@ MK_NOINLINE bool blkDevInit(BlkDevice dev)
 			bool rc = s_dldiDiscIface && s_dldiDiscIface->startup();
 			if (rc) {
 				// XX: detect disc size using MBR
-				s_transferRegion->blkdev_sector_count[BlkDevice_Dldi] = UINT32_MAX;
+				_transferSetBlkDevSectorCount(BlkDevice_Dldi, UINT32_MAX);
 			}
 			return rc;
 		}
@@ -141,12 +290,26 @@ MK_NOINLINE u32 blkDevGetSectorCount(BlkDevice dev)
 	}
 
 	if (dev >= BlkDevice_Dldi && dev <= BlkDevice_TwlNand) {
-		return s_transferRegion->blkdev_sector_count[dev];
+		return _transferGetBlkDevSectorCount(dev);
 	} else {
 		return 0;
 	}
 }
 
+MK_NOINLINE bool blkDevGetQueueStats(BlkDevice dev, BlkQueueStats* out)
+{
+	if (dev == BlkDevice_TwlNandAes) {
+		dev = BlkDevice_TwlNand;
+	}
+
+	if (dev >= BlkDevice_Dldi && dev <= BlkDevice_TwlNand) {
+		_transferGetBlkDevQueueStats(dev, out);
+		return true;
+	} else {
+		return false;
+	}
+}
+
 MK_NOINLINE bool blkDevReadSectors(BlkDevice dev, void* buffer, u32 first_sector, u32 num_sectors)
 {
 	switch (dev) {
@@ -237,3 +400,21 @@ void _blkShelterDldi(void)
 	}
 	s_transferRegion->exmemcnt_mirror |= exmemcnt_bits;
 }
+
+bool _blkGetDldiWramRange(uptr* out_start, uptr* out_end)
+{
+	if (!s_dldiDiscIface) {
+		return false;
+	}
+
+	// Report the WRAM area occupied by the sheltered DLDI driver (including its bss)
+	DldiHeader* dldi_hdr = (DldiHeader*)((u8*)s_dldiDiscIface - offsetof(DldiHeader, disc));
+	unsigned sz_log2 = dldi_hdr->driver_sz_log2;
+	if (dldi_hdr->alloc_sz_log2 > sz_log2) {
+		sz_log2 = dldi_hdr->alloc_sz_log2;
+	}
+
+	*out_start = dldi_hdr->dldi_start;
+	*out_end = dldi_hdr->dldi_start + (1U << sz_log2);
+	return true;
+}
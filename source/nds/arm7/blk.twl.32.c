@@ -52,14 +52,14 @@ bool twlblkInit(void)
 
 bool twlSdInit(void)
 {
-	if (s_transferRegion->blkdev_sector_count[BlkDevice_TwlSdCard]) {
+	if (_transferGetBlkDevSectorCount(BlkDevice_TwlSdCard)) {
 		// Already initialized
 		return true;
 	}
 
 	bool ret = sdmmcCardInit(&s_sdmcDevSd, &s_sdmcCtl, 0, false);
 	if (ret) {
-		s_transferRegion->blkdev_sector_count[BlkDevice_TwlSdCard] = s_sdmcDevSd.num_sectors;
+		_transferSetBlkDevSectorCount(BlkDevice_TwlSdCard, s_sdmcDevSd.num_sectors);
 	}
 
 	return ret;
@@ -67,7 +67,7 @@ bool twlSdInit(void)
 
 bool twlNandInit(void)
 {
-	if (s_transferRegion->blkdev_sector_count[BlkDevice_TwlNand]) {
+	if (_transferGetBlkDevSectorCount(BlkDevice_TwlNand)) {
 		// Already initialized
 		return true;
 	}
@@ -84,7 +84,7 @@ bool twlNandInit(void)
 	}
 
 	if (ret) {
-		s_transferRegion->blkdev_sector_count[BlkDevice_TwlNand] = s_sdmcDevNand.num_sectors;
+		_transferSetBlkDevSectorCount(BlkDevice_TwlNand, s_sdmcDevNand.num_sectors);
 	} else {
 		dietPrint("[TWLBLK] NAND init failed\n");
 		return false;
@@ -101,8 +101,10 @@ bool twlNandInit(void)
 		s_sdmcNandAesIv.data[0], s_sdmcNandAesIv.data[1], s_sdmcNandAesIv.data[2], s_sdmcNandAesIv.data[3]);
 
 	// Ensure NAND AES keyslot configuration is complete
+	aesLock();
 	aesBusyWaitReady();
 	REG_AES_SLOTxY(AesKeySlot_Nand).data[3] = 0xe1a00005;
+	aesUnlock();
 
 	return true;
 }
@@ -326,6 +328,7 @@ bool twlNandReadSectorsAes(void* buffer, u32 first_sector, u32 num_sectors)
 	tx.user = buffer;
 
 	bool ret = false;
+	aesLock();
 	while (num_sectors) {
 		const u32 max_sectors = AES_MAX_PAYLOAD_SZ/BLK_SECTOR_SZ;
 		u32 cur_sectors = num_sectors > max_sectors ? max_sectors : num_sectors;
@@ -339,6 +342,7 @@ bool twlNandReadSectorsAes(void* buffer, u32 first_sector, u32 num_sectors)
 		first_sector += cur_sectors;
 		num_sectors -= cur_sectors;
 	}
+	aesUnlock();
 
 	return ret;
 }
@@ -351,6 +355,7 @@ bool twlNandWriteSectorsAes(const void* buffer, u32 first_sector, u32 num_sector
 	tx.user = (void*)buffer;
 
 	bool ret = false;
+	aesLock();
 	while (num_sectors) {
 		const u32 max_sectors = AES_MAX_PAYLOAD_SZ/BLK_SECTOR_SZ;
 		u32 cur_sectors = num_sectors > max_sectors ? max_sectors : num_sectors;
@@ -364,6 +369,7 @@ bool twlNandWriteSectorsAes(const void* buffer, u32 first_sector, u32 num_sector
 		first_sector += cur_sectors;
 		num_sectors -= cur_sectors;
 	}
+	aesUnlock();
 
 	return ret;
 }
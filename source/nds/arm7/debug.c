@@ -16,7 +16,7 @@ void debugOutput(const char* buf, size_t size)
 
 	while (size) {
 		while ((s_debugBuf->flags & (DBG_BUF_ALIVE|DBG_BUF_BUSY)) != DBG_BUF_ALIVE) {
-			pxiWaitForPing();
+			pxiDoorbellWait(PxiDoorbell_Debug);
 		}
 
 		u32 remaining_sz = sizeof(s_debugBuf->data) - s_debugBuf->size;
@@ -44,7 +44,7 @@ void debugOutput(const char* buf, size_t size)
 
 		if (should_ping) {
 			s_debugBuf->flags |= DBG_BUF_BUSY;
-			pxiPing();
+			pxiDoorbellRing(PxiDoorbell_Debug);
 		}
 	}
 
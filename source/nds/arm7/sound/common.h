@@ -35,4 +35,5 @@ void _soundEnable(void);
 void _soundDisable(void);
 void _soundSetAutoUpdate(bool enable);
 void _soundUpdateSharedState(void);
+void _soundMarkChannelActive(unsigned ch);
 void _soundPxiProcess(Mailbox* mb, bool do_credit_update);
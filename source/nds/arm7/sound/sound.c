@@ -191,5 +191,14 @@ void _soundUpdateSharedState(void)
 		}
 	}
 
+	seqlockWriteBegin(&s_transferRegion->sound_lock);
 	s_transferRegion->sound_active_ch_mask = ch_mask;
+	seqlockWriteEnd(&s_transferRegion->sound_lock);
+}
+
+void _soundMarkChannelActive(unsigned ch)
+{
+	seqlockWriteBegin(&s_transferRegion->sound_lock);
+	s_transferRegion->sound_active_ch_mask |= 1U << ch;
+	seqlockWriteEnd(&s_transferRegion->sound_lock);
 }
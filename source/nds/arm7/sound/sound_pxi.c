@@ -102,7 +102,7 @@ MK_NOINLINE MK_CODE32 static void _soundPxiProcessCmd(PxiSoundCmd cmd, unsigned
 
 			if (arg->start) {
 				soundChStart(arg->ch);
-				s_transferRegion->sound_active_ch_mask |= 1U << arg->ch;
+				_soundMarkChannelActive(arg->ch);
 			}
 			break;
 		}
@@ -114,7 +114,7 @@ MK_NOINLINE MK_CODE32 static void _soundPxiProcessCmd(PxiSoundCmd cmd, unsigned
 
 			if (arg->start) {
 				soundChStart(ch);
-				s_transferRegion->sound_active_ch_mask |= 1U << ch;
+				_soundMarkChannelActive(ch);
 			}
 			break;
 		}
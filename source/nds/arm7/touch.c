@@ -61,20 +61,14 @@ static int _touchSrvThreadMain(void* arg)
 
 		TouchData data;
 		bool valid = touchRead(&data);
-		u16 state = s_transferRegion->touch_state ^ TOUCH_BUF;
 
+		// Publish state in transfer region
+		seqlockWriteBegin(&s_transferRegion->touch_lock);
+		s_transferRegion->touch_valid = valid;
 		if (valid) {
-			state |= TOUCH_VALID;
-
-			// Copy data into transfer region
-			TouchData* out = (TouchData*)s_transferRegion->touch_data[state & TOUCH_BUF];
-			*out = data;
-		} else {
-			state &= ~TOUCH_VALID;
+			s_transferRegion->touch_data = data;
 		}
-
-		// Update state in transfer region
-		s_transferRegion->touch_state = state;
+		seqlockWriteEnd(&s_transferRegion->touch_lock);
 	}
 
 	return 0;
@@ -4,4 +4,8 @@
 #define armAesDecrypt wpaAesDecrypt
 #define armAesSetEncryptKey wpaAesSetEncryptKey
 #define armAesSetDecryptKey wpaAesSetDecryptKey
+#define armAesCtrCrypt wpaAesCtrCrypt
+#define armAesCbcEncrypt wpaAesCbcEncrypt
+#define armAesCbcDecrypt wpaAesCbcDecrypt
+#define armAesCbcMac wpaAesCbcMac
 #include "../../arm/arm-aes.32.s"
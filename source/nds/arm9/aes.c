@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <stddef.h>
+#include <string.h>
+#include <calico/types.h>
+#include <calico/arm/cache.h>
+#include <calico/arm/aes.h>
+#include <calico/system/thread.h>
+#include <calico/system/mutex.h>
+#include <calico/nds/mm.h>
+#include <calico/nds/system.h>
+#include <calico/nds/pxi.h>
+#include <calico/nds/arm9/aes.h>
+
+#include "../pxi/crypto.h"
+
+// Number of blocks of keystream generated at a time by the software fallback
+#define AES_SOFT_BATCH_BLOCKS 16
+
+// The ARM7 reads submitted AesJob descriptors as PxiCryptoJob
+_Static_assert(offsetof(AesJob, key) == offsetof(PxiCryptoJob, key), "AesJob/PxiCryptoJob mismatch");
+_Static_assert(offsetof(AesJob, ctr) == offsetof(PxiCryptoJob, ctr), "AesJob/PxiCryptoJob mismatch");
+_Static_assert(offsetof(AesJob, in)  == offsetof(PxiCryptoJob, in),  "AesJob/PxiCryptoJob mismatch");
+_Static_assert(offsetof(AesJob, out) == offsetof(PxiCryptoJob, out), "AesJob/PxiCryptoJob mismatch");
+_Static_assert(offsetof(AesJob, len) == offsetof(PxiCryptoJob, len), "AesJob/PxiCryptoJob mismatch");
+
+static bool s_aesInit, s_aesHasHw;
+static Mutex s_aesSubmitMutex;
+static ThrListNode s_aesWaitQueue;
+static AesJob *s_aesJobHead, *s_aesJobTail;
+static unsigned s_aesNumJobs;
+
+static Mutex s_aesSyncMutex;
+static AesJob s_aesSyncJob;
+
+MK_CONSTEXPR bool _aesIsValidAddr(const void* addr, u32 alignment)
+{
+	// The output buffer is written by the ARM7 using DMA, and must therefore be
+	// cacheline aligned in order to not share a line with unrelated (possibly dirty)
+	// data, which would otherwise be written back over the output
+	uptr p = (uptr)addr;
+	return (p & (alignment-1)) == 0 && p >= MM_MAINRAM && p < MM_DTCM;
+}
+
+static void _aesPxiHandler(void* user, u32 data)
+{
+	// The ARM7 processes jobs in submission order
+	AesJob* job = s_aesJobHead;
+	if_unlikely (!job) {
+		return;
+	}
+
+	s_aesJobHead = job->next;
+	s_aesNumJobs --;
+
+	job->next = NULL;
+	job->state = data ? AesJobState_Done : AesJobState_Failed;
+
+	// Wake up threads waiting for this job, as well as any submitter waiting for a free slot
+	threadUnblockAllByValue(&s_aesWaitQueue, (u32)job);
+	threadUnblockOneByValue(&s_aesWaitQueue, 0);
+}
+
+static void _aesReverseBlock(u8* out, const void* in)
+{
+	const u8* in8 = (const u8*)in;
+	for (unsigned i = 0; i < AES_JOB_BLOCK_SZ; i ++) {
+		out[i] = in8[AES_JOB_BLOCK_SZ-1-i];
+	}
+}
+
+static bool _aesSoftCtrCrypt(AesJob* job)
+{
+	// Convert the key and counter into standard byte order
+	u8 key[AES_JOB_BLOCK_SZ], ctr[AES_JOB_BLOCK_SZ];
+	_aesReverseBlock(key, job->key);
+	_aesReverseBlock(ctr, job->ctr);
+
+	ArmAesContext ctx;
+	armAesSetEncryptKey(key, 128, &ctx);
+
+	const u8* in = (const u8*)job->in;
+	u8* out = (u8*)job->out;
+	size_t num_blocks = job->len / AES_JOB_BLOCK_SZ;
+
+	u8 stream[AES_SOFT_BATCH_BLOCKS*AES_JOB_BLOCK_SZ];
+	while (num_blocks) {
+		size_t cur_blocks = num_blocks > AES_SOFT_BATCH_BLOCKS ? AES_SOFT_BATCH_BLOCKS : num_blocks;
+
+		// Generate keystream, and apply it in reverse byte order to each block
+		memset(stream, 0, cur_blocks*AES_JOB_BLOCK_SZ);
+		armAesCtrCrypt(stream, stream, cur_blocks, ctr, &ctx);
+
+		for (size_t blk = 0; blk < cur_blocks; blk ++) {
+			const u8* ks = &stream[blk*AES_JOB_BLOCK_SZ];
+			for (unsigned i = 0; i < AES_JOB_BLOCK_SZ; i ++) {
+				out[i] = in[i] ^ ks[AES_JOB_BLOCK_SZ-1-i];
+			}
+
+			in += AES_JOB_BLOCK_SZ;
+			out += AES_JOB_BLOCK_SZ;
+		}
+
+		num_blocks -= cur_blocks;
+	}
+
+	return true;
+}
+
+static bool _aesUseHw(void)
+{
+	// Jobs are processed in software until the ARM7 side of the service is up
+	if_unlikely (!s_aesHasHw && s_aesInit && pxiIsRemoteReady(PxiChannel_Crypto)) {
+		s_aesHasHw = true;
+	}
+
+	return s_aesHasHw;
+}
+
+void aesInit(void)
+{
+	if (!systemIsTwlMode() || s_aesInit) {
+		return;
+	}
+
+	pxiSetHandler(PxiChannel_Crypto, _aesPxiHandler, NULL);
+	s_aesInit = true;
+}
+
+void aesJobPrepareCtr(AesJob* job, const void* key, const void* ctr, const void* in, void* out, size_t len)
+{
+	memcpy(job->key, key, sizeof(job->key));
+	memcpy(job->ctr, ctr, sizeof(job->ctr));
+	job->in = in;
+	job->out = out;
+	job->len = len;
+	job->next = NULL;
+	job->state = AesJobState_Idle;
+}
+
+bool aesJobSubmit(AesJob* job)
+{
+	if (job->state == AesJobState_Pending) {
+		return false;
+	}
+
+	if (!_aesIsValidAddr(job, 4) || !_aesIsValidAddr(job->in, 4) || !_aesIsValidAddr(job->out, ARM_CACHE_LINE_SZ) ||
+		!job->len || (job->len & (AES_JOB_BLOCK_SZ-1))) {
+		job->state = AesJobState_Failed;
+		return false;
+	}
+
+	if (!_aesUseHw()) {
+		job->state = _aesSoftCtrCrypt(job) ? AesJobState_Done : AesJobState_Failed;
+		return true;
+	}
+
+	// Write back the job descriptor and the input data, and evict the output buffer
+	armDCacheFlush(job, sizeof(*job));
+	armDCacheFlush(job->in, job->len);
+	if (job->out != job->in) {
+		armDCacheFlush(job->out, job->len);
+	}
+
+	mutexLock(&s_aesSubmitMutex);
+	ArmIrqState st = armIrqLockByPsr();
+
+	// Wait for a free slot in the ARM7 mailbox
+	while (s_aesNumJobs >= PXI_CRYPTO_MAX_JOBS) {
+		threadBlock(&s_aesWaitQueue, 0);
+	}
+
+	job->next = NULL;
+	job->state = AesJobState_Pending;
+	if (s_aesJobHead) {
+		s_aesJobTail->next = job;
+	} else {
+		s_aesJobHead = job;
+	}
+	s_aesJobTail = job;
+	s_aesNumJobs ++;
+
+	armIrqUnlockByPsr(st);
+
+	pxiSend(PxiChannel_Crypto, pxiCryptoMakeMsg(PxiCryptoMsg_CtrCrypt, job));
+	mutexUnlock(&s_aesSubmitMutex);
+
+	return true;
+}
+
+bool aesJobWait(AesJob* job)
+{
+	ArmIrqState st = armIrqLockByPsr();
+	while (job->state == AesJobState_Pending) {
+		threadBlock(&s_aesWaitQueue, (u32)job);
+	}
+	armIrqUnlockByPsr(st);
+
+	return job->state == AesJobState_Done;
+}
+
+bool aesCtrCrypt(const void* key, const void* ctr, const void* in, void* out, size_t len)
+{
+	// Use a static job descriptor, as thread stacks may be located in DTCM
+	mutexLock(&s_aesSyncMutex);
+	aesJobPrepareCtr(&s_aesSyncJob, key, ctr, in, out, len);
+	bool ret = aesJobSubmit(&s_aesSyncJob) && aesJobWait(&s_aesSyncJob);
+	mutexUnlock(&s_aesSyncMutex);
+
+	return ret;
+}
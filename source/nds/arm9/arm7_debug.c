@@ -16,12 +16,12 @@ static int _arm7DebugThread(void* data)
 	Arm7DebugFn fn = (Arm7DebugFn)data;
 
 	s_debugBuf->flags = DBG_BUF_ALIVE;
-	pxiPing();
+	pxiDoorbellRing(PxiDoorbell_Debug);
 
 	for (;;) {
 		u16 flags = s_debugBuf->flags;
 		if (!(flags & DBG_BUF_BUSY)) {
-			pxiWaitForPing();
+			pxiDoorbellWait(PxiDoorbell_Debug);
 			continue;
 		}
 
@@ -31,7 +31,7 @@ static int _arm7DebugThread(void* data)
 		}
 
 		s_debugBuf->flags = flags &~ DBG_BUF_BUSY;
-		pxiPing();
+		pxiDoorbellRing(PxiDoorbell_Debug);
 	}
 
 	return 0;
@@ -1,9 +1,12 @@
 // SPDX-License-Identifier: ZPL-2.1
 // SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <stdlib.h>
+#include <string.h>
 #include <calico/types.h>
 #include <calico/arm/cache.h>
 #include <calico/system/thread.h>
 #include <calico/system/mailbox.h>
+#include <calico/system/mutex.h>
 #include <calico/dev/blk.h>
 #include <calico/dev/dldi.h>
 #include <calico/nds/mm.h>
@@ -18,6 +21,53 @@ char* const __dldi_ref = __dldi_start;
 
 static BlkDevCallbackFn s_blkDevCallback;
 
+static ThrListNode s_blkRequestQueue;
+
+#define BLK_CACHE_NUM_DEVICES 4
+#define BLK_CACHE_NONE        0xffff
+
+#define BLK_CACHE_VALID (1U << 0)
+#define BLK_CACHE_DIRTY (1U << 1)
+
+typedef struct BlkCacheEntry {
+	u32 sector;
+	u16 prev;  // LRU list (towards most recently used)
+	u16 next;  // LRU list (towards least recently used)
+	u16 hnext; // Hash chain
+	u16 flags;
+} BlkCacheEntry;
+
+typedef struct BlkCacheState {
+	Mutex mutex;
+	unsigned num_entries;
+	unsigned hash_mask;
+	BlkCacheEntry* entries;
+	u16* buckets;
+	u8* data;
+	u16 mru;
+	u16 lru;
+	BlkCacheStats stats;
+} BlkCacheState;
+
+static BlkCacheState s_blkCache[BLK_CACHE_NUM_DEVICES];
+
+static void _blkCacheDiscard(BlkDevice dev);
+
+typedef struct BlkReadaheadState {
+	Mutex mutex;
+	u32 max_sectors;
+	u8* buffer;
+	u32 buf_sector;
+	u32 buf_count;
+	u32 next_sector;
+	u32 window;
+	BlkReadaheadStats stats;
+} BlkReadaheadState;
+
+static BlkReadaheadState s_blkReadahead[BLK_CACHE_NUM_DEVICES];
+
+static void _blkReadaheadInvalidate(BlkDevice dev, u32 first_sector, u32 num_sectors);
+
 static Mailbox s_blkPxiMailbox;
 static u32 s_blkPxiMailboxData[1];
 static Thread s_blkPxiThread;
@@ -48,6 +98,11 @@ static int _blkPxiThread(void* unused)
 			default: break;
 
 			case PxiBlkDevMsg_Removed:
+				// Cached sectors (including unwritten ones) no longer correspond to the device
+				_blkCacheDiscard((BlkDevice)imm);
+				_blkReadaheadInvalidate((BlkDevice)imm, 0, UINT32_MAX);
+				// fallthrough
+
 			case PxiBlkDevMsg_Inserted:
 				if (s_blkDevCallback) {
 					s_blkDevCallback((BlkDevice)imm, type == PxiBlkDevMsg_Inserted);
@@ -78,14 +133,27 @@ void blkSetDevCallback(BlkDevCallbackFn fn)
 	s_blkDevCallback = fn;
 }
 
+static u32 _blkPxiSendAndReceive(PxiBlkDevMsgType type, unsigned imm, const u32* params, unsigned num_params)
+{
+	// Use a tagged request, so that several threads can access block devices concurrently
+	unsigned tag = pxiTagAlloc(PxiChannel_BlkDev);
+	u32 msg = pxiBlkDevMakeTaggedMsg(type, imm, tag);
+	if (num_params) {
+		pxiSendWithData(PxiChannel_BlkDev, msg, params, num_params);
+	} else {
+		pxiSend(PxiChannel_BlkDev, msg);
+	}
+	return pxiTagWait(tag);
+}
+
 bool blkDevIsPresent(BlkDevice dev)
 {
-	return pxiSendAndReceive(PxiChannel_BlkDev, pxiBlkDevMakeMsg(PxiBlkDevMsg_IsPresent, dev));
+	return _blkPxiSendAndReceive(PxiBlkDevMsg_IsPresent, dev, NULL, 0);
 }
 
 bool blkDevInit(BlkDevice dev)
 {
-	return pxiSendAndReceive(PxiChannel_BlkDev, pxiBlkDevMakeMsg(PxiBlkDevMsg_Init, dev));
+	return _blkPxiSendAndReceive(PxiBlkDevMsg_Init, dev, NULL, 0);
 }
 
 u32 blkDevGetSectorCount(BlkDevice dev)
@@ -95,13 +163,27 @@ u32 blkDevGetSectorCount(BlkDevice dev)
 	}
 
 	if (dev >= BlkDevice_Dldi && dev <= BlkDevice_TwlNand) {
-		return s_transferRegion->blkdev_sector_count[dev];
+		return _transferGetBlkDevSectorCount(dev);
 	} else {
 		return 0;
 	}
 }
 
-MK_NOINLINE static bool _blkDevReadWriteSectors(u32 msg, u32 buffer, u32 first_sector, u32 num_sectors)
+bool blkDevGetQueueStats(BlkDevice dev, BlkQueueStats* out)
+{
+	if (dev == BlkDevice_TwlNandAes) {
+		dev = BlkDevice_TwlNand;
+	}
+
+	if (dev >= BlkDevice_Dldi && dev <= BlkDevice_TwlNand) {
+		_transferGetBlkDevQueueStats(dev, out);
+		return true;
+	} else {
+		return false;
+	}
+}
+
+MK_NOINLINE static bool _blkDevReadWriteSectors(PxiBlkDevMsgType type, BlkDevice dev, u32 buffer, u32 first_sector, u32 num_sectors)
 {
 	u32 params[3] = {
 		buffer,
@@ -109,7 +191,394 @@ MK_NOINLINE static bool _blkDevReadWriteSectors(u32 msg, u32 buffer, u32 first_s
 		num_sectors,
 	};
 
-	return pxiSendWithDataAndReceive(PxiChannel_BlkDev, msg, params, sizeof(params)/sizeof(u32));
+	return _blkPxiSendAndReceive(type, dev, params, sizeof(params)/sizeof(u32));
+}
+
+static bool _blkDevReadRaw(BlkDevice dev, void* buffer, u32 first_sector, u32 num_sectors)
+{
+	armDCacheInvalidate(buffer, num_sectors*BLK_SECTOR_SZ);
+	return _blkDevReadWriteSectors(
+		PxiBlkDevMsg_ReadSectors, dev,
+		(u32)buffer, first_sector, num_sectors);
+}
+
+static void _blkReadaheadInvalidate(BlkDevice dev, u32 first_sector, u32 num_sectors)
+{
+	// Both views of NAND share the same sectors
+	unsigned num_views = dev >= BlkDevice_TwlNand ? 2 : 1;
+	for (unsigned i = 0; i < num_views; i ++, dev ^= 1) {
+		if (dev >= BLK_CACHE_NUM_DEVICES || !s_blkReadahead[dev].max_sectors) {
+			continue;
+		}
+
+		BlkReadaheadState* s = &s_blkReadahead[dev];
+		mutexLock(&s->mutex);
+		if ((s->buf_sector - first_sector) < num_sectors || (first_sector - s->buf_sector) < s->buf_count) {
+			s->buf_count = 0;
+		}
+		mutexUnlock(&s->mutex);
+	}
+}
+
+static bool _blkDevWriteDirect(BlkDevice dev, const void* buffer, u32 first_sector, u32 num_sectors)
+{
+	_blkReadaheadInvalidate(dev, first_sector, num_sectors);
+
+	armDCacheFlush((void*)buffer, num_sectors*BLK_SECTOR_SZ);
+	return _blkDevReadWriteSectors(
+		PxiBlkDevMsg_WriteSectors, dev,
+		(u32)buffer, first_sector, num_sectors);
+}
+
+static bool _blkReadaheadRead(BlkReadaheadState* s, BlkDevice dev, u8* buffer, u32 first_sector, u32 num_sectors)
+{
+	// Serve the part of the request that has already been read ahead
+	u32 done = 0;
+	u32 offset = first_sector - s->buf_sector;
+	if (offset < s->buf_count) {
+		done = s->buf_count - offset;
+		if (done > num_sectors) {
+			done = num_sectors;
+		}
+
+		memcpy(buffer, &s->buffer[offset*BLK_SECTOR_SZ], done*BLK_SECTOR_SZ);
+		s->stats.num_hits += done;
+	}
+
+	bool is_sequential = done || first_sector == s->next_sector;
+	s->next_sector = first_sector + num_sectors;
+	if (done == num_sectors) {
+		return true;
+	}
+
+	buffer += done*BLK_SECTOR_SZ;
+	first_sector += done;
+	num_sectors -= done;
+
+	if (!is_sequential) {
+		// Random access: stop reading ahead until a new sequential pattern is detected
+		s->window = 0;
+		return _blkDevReadRaw(dev, buffer, first_sector, num_sectors);
+	}
+
+	// Sequential access: grow the readahead window on every refill
+	u32 window = s->window ? 2*s->window : 2*num_sectors;
+	if (window < BLK_READAHEAD_MIN_SECTORS) {
+		window = BLK_READAHEAD_MIN_SECTORS;
+	}
+	if (window > s->max_sectors) {
+		window = s->max_sectors;
+	}
+	s->window = window;
+
+	// Never read ahead past the end of the device (an unknown sector count is reported as 0)
+	u32 ra_len = window;
+	u32 sector_count = blkDevGetSectorCount(dev);
+	if (sector_count) {
+		u32 remaining = first_sector < sector_count ? sector_count - first_sector : 0;
+		if (ra_len > remaining) {
+			ra_len = remaining;
+		}
+	}
+
+	// Requests that are at least as large as the readahead do not benefit from it.
+	// If the readahead fails, the request is retried on its own.
+	if (num_sectors < ra_len) {
+		s->buf_count = 0;
+		if (_blkDevReadRaw(dev, s->buffer, first_sector, ra_len)) {
+			s->buf_sector = first_sector;
+			s->buf_count = ra_len;
+			s->stats.num_fills ++;
+			s->stats.num_prefetched += ra_len - num_sectors;
+			memcpy(buffer, s->buffer, num_sectors*BLK_SECTOR_SZ);
+			return true;
+		}
+	}
+
+	return _blkDevReadRaw(dev, buffer, first_sector, num_sectors);
+}
+
+static bool _blkDevReadDirect(BlkDevice dev, void* buffer, u32 first_sector, u32 num_sectors)
+{
+	if (dev >= BLK_CACHE_NUM_DEVICES || !s_blkReadahead[dev].max_sectors) {
+		return _blkDevReadRaw(dev, buffer, first_sector, num_sectors);
+	}
+
+	BlkReadaheadState* s = &s_blkReadahead[dev];
+	mutexLock(&s->mutex);
+	bool rc = s->max_sectors ?
+		_blkReadaheadRead(s, dev, (u8*)buffer, first_sector, num_sectors) :
+		_blkDevReadRaw(dev, buffer, first_sector, num_sectors);
+	mutexUnlock(&s->mutex);
+	return rc;
+}
+
+MK_INLINE u8* _blkCacheGetData(BlkCacheState* c, unsigned idx)
+{
+	return &c->data[idx*BLK_SECTOR_SZ];
+}
+
+static unsigned _blkCacheLookup(BlkCacheState* c, u32 sector)
+{
+	unsigned idx = c->buckets[sector & c->hash_mask];
+	while (idx != BLK_CACHE_NONE && c->entries[idx].sector != sector) {
+		idx = c->entries[idx].hnext;
+	}
+	return idx;
+}
+
+static void _blkCacheHashRemove(BlkCacheState* c, unsigned idx)
+{
+	u16* link = &c->buckets[c->entries[idx].sector & c->hash_mask];
+	while (*link != idx) {
+		link = &c->entries[*link].hnext;
+	}
+	*link = c->entries[idx].hnext;
+}
+
+static void _blkCacheUnlink(BlkCacheState* c, unsigned idx)
+{
+	BlkCacheEntry* e = &c->entries[idx];
+	if (e->prev != BLK_CACHE_NONE) {
+		c->entries[e->prev].next = e->next;
+	} else {
+		c->mru = e->next;
+	}
+	if (e->next != BLK_CACHE_NONE) {
+		c->entries[e->next].prev = e->prev;
+	} else {
+		c->lru = e->prev;
+	}
+}
+
+static void _blkCacheTouch(BlkCacheState* c, unsigned idx)
+{
+	if (c->mru == idx) {
+		return;
+	}
+
+	_blkCacheUnlink(c, idx);
+
+	BlkCacheEntry* e = &c->entries[idx];
+	e->prev = BLK_CACHE_NONE;
+	e->next = c->mru;
+	c->entries[c->mru].prev = idx;
+	c->mru = idx;
+}
+
+static void _blkCacheDrop(BlkCacheState* c, unsigned idx)
+{
+	// Invalidate the entry and move it to the least recently used end, so that it is reused first
+	BlkCacheEntry* e = &c->entries[idx];
+	_blkCacheHashRemove(c, idx);
+	e->flags = 0;
+
+	if (c->lru != idx) {
+		_blkCacheUnlink(c, idx);
+		e->prev = c->lru;
+		e->next = BLK_CACHE_NONE;
+		c->entries[c->lru].next = idx;
+		c->lru = idx;
+	}
+}
+
+static bool _blkCacheWriteBack(BlkCacheState* c, BlkDevice dev, unsigned idx)
+{
+	BlkCacheEntry* e = &c->entries[idx];
+	if (!_blkDevWriteDirect(dev, _blkCacheGetData(c, idx), e->sector, 1)) {
+		return false;
+	}
+
+	e->flags &= ~BLK_CACHE_DIRTY;
+	c->stats.num_writebacks ++;
+	return true;
+}
+
+static unsigned _blkCacheAlloc(BlkCacheState* c, BlkDevice dev, u32 sector)
+{
+	// Recycle the least recently used entry
+	unsigned idx = c->lru;
+	BlkCacheEntry* e = &c->entries[idx];
+	if (e->flags & BLK_CACHE_VALID) {
+		if ((e->flags & BLK_CACHE_DIRTY) && !_blkCacheWriteBack(c, dev, idx)) {
+			return BLK_CACHE_NONE;
+		}
+		_blkCacheHashRemove(c, idx);
+	}
+
+	u16* bucket = &c->buckets[sector & c->hash_mask];
+	e->sector = sector;
+	e->flags = BLK_CACHE_VALID;
+	e->hnext = *bucket;
+	*bucket = idx;
+	_blkCacheTouch(c, idx);
+	return idx;
+}
+
+static bool _blkCacheFlush(BlkCacheState* c, BlkDevice dev)
+{
+	bool rc = true;
+	for (unsigned i = 0; i < c->num_entries; i ++) {
+		if ((c->entries[i].flags & BLK_CACHE_DIRTY) && !_blkCacheWriteBack(c, dev, i)) {
+			rc = false;
+		}
+	}
+	return rc;
+}
+
+static bool _blkCacheSyncRange(BlkCacheState* c, BlkDevice dev, u32 first_sector, u32 num_sectors, bool drop)
+{
+	// Write back (or drop, if the range is about to be overwritten) cached sectors in the range
+	for (unsigned i = 0; i < c->num_entries; i ++) {
+		BlkCacheEntry* e = &c->entries[i];
+		if (!(e->flags & BLK_CACHE_VALID) || (e->sector - first_sector) >= num_sectors) {
+			continue;
+		}
+
+		if (drop) {
+			_blkCacheDrop(c, i);
+		} else if ((e->flags & BLK_CACHE_DIRTY) && !_blkCacheWriteBack(c, dev, i)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool _blkCacheRead(BlkCacheState* c, BlkDevice dev, u8* buffer, u32 first_sector, u32 num_sectors)
+{
+	if (num_sectors > c->num_entries/4) {
+		// Large read: bypass the cache, then overlay sectors that have not been written back yet
+		c->stats.num_bypassed ++;
+		if (!_blkDevReadDirect(dev, buffer, first_sector, num_sectors)) {
+			return false;
+		}
+
+		for (unsigned i = 0; i < c->num_entries; i ++) {
+			BlkCacheEntry* e = &c->entries[i];
+			u32 offset = e->sector - first_sector;
+			if ((e->flags & BLK_CACHE_DIRTY) && offset < num_sectors) {
+				memcpy(&buffer[offset*BLK_SECTOR_SZ], _blkCacheGetData(c, i), BLK_SECTOR_SZ);
+			}
+		}
+
+		return true;
+	}
+
+	u32 i = 0;
+	while (i < num_sectors) {
+		unsigned idx = _blkCacheLookup(c, first_sector+i);
+		if (idx != BLK_CACHE_NONE) {
+			c->stats.num_hits ++;
+			memcpy(&buffer[i*BLK_SECTOR_SZ], _blkCacheGetData(c, idx), BLK_SECTOR_SZ);
+			_blkCacheTouch(c, idx);
+			i ++;
+			continue;
+		}
+
+		// Read the whole run of missing sectors with a single request, then populate the cache
+		u32 run = 1;
+		while (i+run < num_sectors && _blkCacheLookup(c, first_sector+i+run) == BLK_CACHE_NONE) {
+			run ++;
+		}
+
+		c->stats.num_misses += run;
+		u8* run_buf = &buffer[i*BLK_SECTOR_SZ];
+		if (!_blkDevReadDirect(dev, run_buf, first_sector+i, run)) {
+			return false;
+		}
+
+		for (u32 j = 0; j < run; j ++) {
+			idx = _blkCacheAlloc(c, dev, first_sector+i+j);
+			if (idx == BLK_CACHE_NONE) {
+				break;
+			}
+			memcpy(_blkCacheGetData(c, idx), &run_buf[j*BLK_SECTOR_SZ], BLK_SECTOR_SZ);
+		}
+
+		i += run;
+	}
+
+	return true;
+}
+
+static bool _blkCacheWrite(BlkCacheState* c, BlkDevice dev, const u8* buffer, u32 first_sector, u32 num_sectors)
+{
+	if (num_sectors > c->num_entries/4) {
+		// Large write: bypass the cache, dropping the copies it supersedes
+		c->stats.num_bypassed ++;
+		_blkCacheSyncRange(c, dev, first_sector, num_sectors, true);
+		return _blkDevWriteDirect(dev, buffer, first_sector, num_sectors);
+	}
+
+	for (u32 i = 0; i < num_sectors; i ++) {
+		unsigned idx = _blkCacheLookup(c, first_sector+i);
+		if (idx != BLK_CACHE_NONE) {
+			c->stats.num_hits ++;
+			_blkCacheTouch(c, idx);
+		} else {
+			c->stats.num_misses ++;
+			idx = _blkCacheAlloc(c, dev, first_sector+i);
+			if (idx == BLK_CACHE_NONE) {
+				return false;
+			}
+		}
+
+		memcpy(_blkCacheGetData(c, idx), &buffer[i*BLK_SECTOR_SZ], BLK_SECTOR_SZ);
+		c->entries[idx].flags |= BLK_CACHE_DIRTY;
+	}
+
+	return true;
+}
+
+MK_INLINE BlkCacheState* _blkCacheLock(BlkDevice dev)
+{
+	if (dev >= BLK_CACHE_NUM_DEVICES || !s_blkCache[dev].num_entries) {
+		return NULL;
+	}
+
+	BlkCacheState* c = &s_blkCache[dev];
+	mutexLock(&c->mutex);
+	if (!c->num_entries) {
+		mutexUnlock(&c->mutex);
+		c = NULL;
+	}
+
+	return c;
+}
+
+static void _blkCacheDiscard(BlkDevice dev)
+{
+	BlkCacheState* c = _blkCacheLock(dev);
+	if (c) {
+		for (unsigned i = 0; i < c->num_entries; i ++) {
+			if (c->entries[i].flags & BLK_CACHE_VALID) {
+				_blkCacheDrop(c, i);
+			}
+		}
+		mutexUnlock(&c->mutex);
+	}
+}
+
+static bool _blkCacheSyncForAsync(BlkDevice dev, u32 first_sector, u32 num_sectors, bool drop)
+{
+	bool rc = true;
+	BlkCacheState* c = _blkCacheLock(dev);
+	if (c) {
+		rc = _blkCacheSyncRange(c, dev, first_sector, num_sectors, drop);
+		mutexUnlock(&c->mutex);
+	}
+	return rc;
+}
+
+static bool _blkCacheSyncOtherView(BlkDevice dev, u32 first_sector, u32 num_sectors, bool drop)
+{
+	// Both views of NAND share the same sectors, so accesses through one of them must
+	// see the writes cached by the other (and writes must supersede its cached copies)
+	if (dev == BlkDevice_TwlNand || dev == BlkDevice_TwlNandAes) {
+		return _blkCacheSyncForAsync((BlkDevice)(dev ^ 1), first_sector, num_sectors, drop);
+	}
+	return true;
 }
 
 bool blkDevReadSectors(BlkDevice dev, void* buffer, u32 first_sector, u32 num_sectors)
@@ -118,10 +587,18 @@ bool blkDevReadSectors(BlkDevice dev, void* buffer, u32 first_sector, u32 num_se
 		return false;
 	}
 
-	armDCacheInvalidate(buffer, num_sectors*BLK_SECTOR_SZ);
-	return _blkDevReadWriteSectors(
-		pxiBlkDevMakeMsg(PxiBlkDevMsg_ReadSectors, dev),
-		(u32)buffer, first_sector, num_sectors);
+	if (!_blkCacheSyncOtherView(dev, first_sector, num_sectors, false)) {
+		return false;
+	}
+
+	BlkCacheState* c = _blkCacheLock(dev);
+	if (!c) {
+		return _blkDevReadDirect(dev, buffer, first_sector, num_sectors);
+	}
+
+	bool rc = _blkCacheRead(c, dev, (u8*)buffer, first_sector, num_sectors);
+	mutexUnlock(&c->mutex);
+	return rc;
 }
 
 bool blkDevWriteSectors(BlkDevice dev, const void* buffer, u32 first_sector, u32 num_sectors)
@@ -130,10 +607,233 @@ bool blkDevWriteSectors(BlkDevice dev, const void* buffer, u32 first_sector, u32
 		return false;
 	}
 
+	_blkCacheSyncOtherView(dev, first_sector, num_sectors, true);
+
+	BlkCacheState* c = _blkCacheLock(dev);
+	if (!c) {
+		return _blkDevWriteDirect(dev, buffer, first_sector, num_sectors);
+	}
+
+	bool rc = _blkCacheWrite(c, dev, (const u8*)buffer, first_sector, num_sectors);
+	mutexUnlock(&c->mutex);
+	return rc;
+}
+
+bool blkCacheSetup(BlkDevice dev, unsigned num_sectors)
+{
+	// Smaller caches would be bypassed by every request (see _blkCacheRead)
+	if (dev >= BLK_CACHE_NUM_DEVICES || (num_sectors && num_sectors < BLK_CACHE_MIN_SECTORS) || num_sectors > BLK_CACHE_MAX_SECTORS) {
+		return false;
+	}
+
+	// Both views of NAND share the same sectors, so they cannot be cached independently
+	if (num_sectors && dev >= BlkDevice_TwlNand && s_blkCache[dev ^ 1].num_entries) {
+		return false;
+	}
+
+	BlkCacheState* c = &s_blkCache[dev];
+	mutexLock(&c->mutex);
+
+	// Write back and release the previous cache
+	if (c->num_entries) {
+		if (!_blkCacheFlush(c, dev)) {
+			mutexUnlock(&c->mutex);
+			return false;
+		}
+
+		free(c->data);
+		free(c->entries);
+		c->num_entries = 0;
+	}
+
+	bool rc = true;
+	if (num_sectors) {
+		unsigned num_buckets = 1U << (32 - __builtin_clz(num_sectors));
+		void* mem = malloc(num_sectors*sizeof(BlkCacheEntry) + num_buckets*sizeof(u16));
+		u8* data = (u8*)aligned_alloc(ARM_CACHE_LINE_SZ, num_sectors*BLK_SECTOR_SZ);
+		if (!mem || !data) {
+			free(mem);
+			free(data);
+			rc = false;
+		} else {
+			c->entries = (BlkCacheEntry*)mem;
+			c->buckets = (u16*)&c->entries[num_sectors];
+			c->data = data;
+			c->hash_mask = num_buckets - 1;
+			c->mru = 0;
+			c->lru = num_sectors - 1;
+
+			for (unsigned i = 0; i < num_sectors; i ++) {
+				BlkCacheEntry* e = &c->entries[i];
+				e->sector = 0;
+				e->prev = i ? i-1 : BLK_CACHE_NONE;
+				e->next = i+1 < num_sectors ? i+1 : BLK_CACHE_NONE;
+				e->hnext = BLK_CACHE_NONE;
+				e->flags = 0;
+			}
+
+			for (unsigned i = 0; i < num_buckets; i ++) {
+				c->buckets[i] = BLK_CACHE_NONE;
+			}
+
+			memset(&c->stats, 0, sizeof(c->stats));
+			c->stats.num_sectors = num_sectors;
+			c->num_entries = num_sectors;
+		}
+	}
+
+	mutexUnlock(&c->mutex);
+	return rc;
+}
+
+bool blkCacheFlush(BlkDevice dev)
+{
+	BlkCacheState* c = _blkCacheLock(dev);
+	if (!c) {
+		return true;
+	}
+
+	bool rc = _blkCacheFlush(c, dev);
+	mutexUnlock(&c->mutex);
+	return rc;
+}
+
+bool blkReadaheadSetup(BlkDevice dev, unsigned max_sectors)
+{
+	if (dev >= BLK_CACHE_NUM_DEVICES || max_sectors > BLK_READAHEAD_MAX_SECTORS) {
+		return false;
+	}
+
+	u8* buffer = NULL;
+	if (max_sectors) {
+		if (max_sectors < BLK_READAHEAD_MIN_SECTORS) {
+			max_sectors = BLK_READAHEAD_MIN_SECTORS;
+		}
+
+		buffer = (u8*)aligned_alloc(ARM_CACHE_LINE_SZ, max_sectors*BLK_SECTOR_SZ);
+		if (!buffer) {
+			return false;
+		}
+	}
+
+	BlkReadaheadState* s = &s_blkReadahead[dev];
+	mutexLock(&s->mutex);
+
+	free(s->buffer);
+	s->max_sectors = max_sectors;
+	s->buffer = buffer;
+	s->buf_sector = 0;
+	s->buf_count = 0;
+	s->next_sector = UINT32_MAX; // so that the first read is not considered sequential
+	s->window = 0;
+	memset(&s->stats, 0, sizeof(s->stats));
+
+	mutexUnlock(&s->mutex);
+	return true;
+}
+
+bool blkReadaheadGetStats(BlkDevice dev, BlkReadaheadStats* out)
+{
+	if (dev >= BLK_CACHE_NUM_DEVICES || !s_blkReadahead[dev].max_sectors) {
+		return false;
+	}
+
+	BlkReadaheadState* s = &s_blkReadahead[dev];
+	mutexLock(&s->mutex);
+	*out = s->stats;
+	out->cur_window = s->window;
+	out->max_sectors = s->max_sectors;
+	mutexUnlock(&s->mutex);
+	return true;
+}
+
+bool blkCacheGetStats(BlkDevice dev, BlkCacheStats* out)
+{
+	BlkCacheState* c = _blkCacheLock(dev);
+	if (!c) {
+		return false;
+	}
+
+	*out = c->stats;
+	out->num_dirty = 0;
+	for (unsigned i = 0; i < c->num_entries; i ++) {
+		if (c->entries[i].flags & BLK_CACHE_DIRTY) {
+			out->num_dirty ++;
+		}
+	}
+
+	mutexUnlock(&c->mutex);
+	return true;
+}
+
+static void _blkRequestComplete(void* user, u32 reply)
+{
+	BlkRequest* req = (BlkRequest*)user;
+	req->state = reply ? BlkRequestState_Success : BlkRequestState_Failure;
+	threadUnblockAllByValue(&s_blkRequestQueue, (u32)req);
+
+	if (req->mailbox) {
+		mailboxTrySend(req->mailbox, (u32)req);
+	}
+
+	if (req->callback) {
+		req->callback(req);
+	}
+}
+
+static void _blkRequestSubmit(BlkRequest* req, PxiBlkDevMsgType type, BlkDevice dev, u32 buffer, u32 first_sector, u32 num_sectors)
+{
+	u32 params[3] = {
+		buffer,
+		first_sector,
+		num_sectors,
+	};
+
+	req->state = BlkRequestState_Pending;
+	unsigned tag = pxiTagAllocAsync(PxiChannel_BlkDev, _blkRequestComplete, req);
+	pxiSendWithData(PxiChannel_BlkDev, pxiBlkDevMakeTaggedMsg(type, dev, tag), params, sizeof(params)/sizeof(u32));
+}
+
+bool blkDevReadSectorsAsync(BlkRequest* req, BlkDevice dev, void* buffer, u32 first_sector, u32 num_sectors)
+{
+	if (!_blkIsValidAddr(buffer, ARM_CACHE_LINE_SZ)) {
+		return false;
+	}
+
+	if (!_blkCacheSyncForAsync(dev, first_sector, num_sectors, false) ||
+		!_blkCacheSyncOtherView(dev, first_sector, num_sectors, false)) {
+		return false;
+	}
+
+	armDCacheInvalidate(buffer, num_sectors*BLK_SECTOR_SZ);
+	_blkRequestSubmit(req, PxiBlkDevMsg_ReadSectors, dev, (u32)buffer, first_sector, num_sectors);
+	return true;
+}
+
+bool blkDevWriteSectorsAsync(BlkRequest* req, BlkDevice dev, const void* buffer, u32 first_sector, u32 num_sectors)
+{
+	if (!_blkIsValidAddr(buffer, 4)) {
+		return false;
+	}
+
+	_blkCacheSyncForAsync(dev, first_sector, num_sectors, true);
+	_blkCacheSyncOtherView(dev, first_sector, num_sectors, true);
+	_blkReadaheadInvalidate(dev, first_sector, num_sectors);
+
 	armDCacheFlush((void*)buffer, num_sectors*BLK_SECTOR_SZ);
-	return _blkDevReadWriteSectors(
-		pxiBlkDevMakeMsg(PxiBlkDevMsg_WriteSectors, dev),
-		(u32)buffer, first_sector, num_sectors);
+	_blkRequestSubmit(req, PxiBlkDevMsg_WriteSectors, dev, (u32)buffer, first_sector, num_sectors);
+	return true;
+}
+
+bool blkRequestWait(BlkRequest* req)
+{
+	ArmIrqState st = armIrqLockByPsr();
+	while (req->state == BlkRequestState_Pending) {
+		threadBlock(&s_blkRequestQueue, (u32)req);
+	}
+	armIrqUnlockByPsr(st);
+
+	return req->state == BlkRequestState_Success;
 }
 
 bool dldiDumpInternal(void* buffer)
@@ -147,6 +847,5 @@ bool dldiDumpInternal(void* buffer)
 	};
 
 	armDCacheInvalidate(buffer, DLDI_MAX_ALLOC_SZ);
-	return pxiSendWithDataAndReceive(PxiChannel_BlkDev,
-		pxiBlkDevMakeMsg(PxiBlkDevMsg_DumpDldi, 0), params, sizeof(params)/sizeof(u32));
+	return _blkPxiSendAndReceive(PxiBlkDevMsg_DumpDldi, 0, params, sizeof(params)/sizeof(u32));
 }
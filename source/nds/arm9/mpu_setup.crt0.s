@@ -29,6 +29,10 @@ FUNC_START32 crt0SetupMPU
 	mcr   p15, 0, r10, c6, c6, 0
 	mcr   p15, 0, r11, c6, c7, 0
 
+	mov   r3, #0
+	mcr   p15, 0, r3, c9, c0, 0 @ Reset DCache lockdown
+	mcr   p15, 0, r3, c9, c0, 1 @ Reset ICache lockdown
+
 	mov   r3, #0b00000010
 	mcr   p15, 0, r3, c3, c0, 0
 	mov   r3, #0b01000010
@@ -51,8 +55,8 @@ FUNC_START32 crt0SetupMPU
 .LmpuRegions:
 	.word CP15_PU_ENABLE | CP15_PU_64M | MM_IO   @ IO + VRAM
 	.word CP15_PU_ENABLE | MM_MAINRAM            @ Main RAM
-	.word 0
-	.word 0
+	.word 0                                      @ (GBA slot, see gbacart.c)
+	.word 0                                      @ (MPU window, see mpuwin.c)
 	.word CP15_PU_ENABLE | CP15_PU_64K | MM_DTCM @ DTCM + high shared memory
 	.word CP15_PU_ENABLE | CP15_PU_32K | MM_ITCM @ ITCM
 	.word CP15_PU_ENABLE | CP15_PU_32K | MM_BIOS @ BIOS
@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <stdlib.h>
+
+#include <calico/types.h>
+#include <calico/arm/common.h>
+#include <calico/arm/cache.h>
+#include <calico/arm/mpu.h>
+#include <calico/system/mutex.h>
+#include <calico/system/rheap.h>
+#include <calico/nds/arm9/mpuwin.h>
+
+// MPU region 3 is left unused by mpu_setup.crt0.s (region 2 belongs to gbacart.c)
+#define MPUWIN_FIRST_REGION 3
+
+static u8 s_mpuWinUsedMask;
+
+static Mutex s_uncachedMutex;
+static RHeap s_uncachedHeap;
+static void* s_uncachedPoolMem;
+
+int mpuWinMap(MpuWinType type, uptr addr, size_t size)
+{
+	// Validate window size and alignment
+	if (size < MPUWIN_MIN_SZ || (size & (size-1)) || (addr & (size-1))) {
+		return -1;
+	}
+
+	ArmIrqState st = armIrqLockByPsr();
+
+	// Find a free region
+	int id = -1;
+	for (unsigned i = 0; i < MPUWIN_NUM_REGIONS; i ++) {
+		if (!(s_mpuWinUsedMask & (1U << i))) {
+			s_mpuWinUsedMask |= 1U << i;
+			id = MPUWIN_FIRST_REGION + i;
+			break;
+		}
+	}
+
+	if (id >= 0) {
+		// Write back and discard cached data within the window, as the cache
+		// may no longer be looked up for it once the attributes are changed
+		if (size >= 4*ARM_DCACHE_SZ) {
+			armDCacheFlushAll();
+		} else {
+			armDCacheFlush((void*)addr, size);
+		}
+
+		bool cached = type == MpuWinType_WriteThrough;
+		bool no_access = type == MpuWinType_NoAccess;
+		armMpuSetRegionDCacheEnable(id, cached);
+		armMpuSetRegionICacheEnable(id, cached);
+		armMpuSetRegionWrBufEnable(id, false);
+		armMpuSetRegionDataPerm(id, no_access ? CP15_PU_PERM_NONE : CP15_PU_PERM_RW);
+		armMpuSetRegionCodePerm(id, no_access ? CP15_PU_PERM_NONE : CP15_PU_PERM_RO);
+		armMpuSetRegionAddrSize(id, addr, (__builtin_ctz(size) - 1) << 1);
+	}
+
+	armIrqUnlockByPsr(st);
+	return id;
+}
+
+void mpuWinUnmap(int id)
+{
+	unsigned i = id - MPUWIN_FIRST_REGION;
+	if (i >= MPUWIN_NUM_REGIONS) {
+		return;
+	}
+
+	ArmIrqState st = armIrqLockByPsr();
+
+	if (s_mpuWinUsedMask & (1U << i)) {
+		armMpuClearRegion(id);
+		armMpuSetRegionDCacheEnable(id, false);
+		armMpuSetRegionICacheEnable(id, false);
+		armMpuSetRegionDataPerm(id, CP15_PU_PERM_NONE);
+		armMpuSetRegionCodePerm(id, CP15_PU_PERM_NONE);
+		s_mpuWinUsedMask &= ~(1U << i);
+	}
+
+	armIrqUnlockByPsr(st);
+}
+
+static bool _uncachedPoolInit(size_t size)
+{
+	// Fail if the pool is already set up
+	if (s_uncachedPoolMem) {
+		return false;
+	}
+
+	// Reserve memory for the pool (aligned to its size as required by the MPU)
+	void* mem = aligned_alloc(size, size);
+	if (!mem) {
+		return false;
+	}
+
+	// Map the pool as uncached memory
+	if (mpuWinMap(MpuWinType_Uncached, (uptr)mem, size) < 0) {
+		free(mem);
+		return false;
+	}
+
+	rheapPrepare(&s_uncachedHeap);
+	rheapAddRegion(&s_uncachedHeap, mem, size);
+	s_uncachedPoolMem = mem;
+	return true;
+}
+
+bool uncachedPoolInit(size_t size)
+{
+	mutexLock(&s_uncachedMutex);
+	bool ret = _uncachedPoolInit(size);
+	mutexUnlock(&s_uncachedMutex);
+	return ret;
+}
+
+void* uncachedAlloc(size_t size, size_t align)
+{
+	void* ret = NULL;
+	mutexLock(&s_uncachedMutex);
+
+	if (s_uncachedPoolMem || _uncachedPoolInit(UNCACHED_POOL_DEFAULT_SZ)) {
+		ret = rheapAlloc(&s_uncachedHeap, size, align);
+	}
+
+	mutexUnlock(&s_uncachedMutex);
+	return ret;
+}
+
+void uncachedFree(void* ptr)
+{
+	mutexLock(&s_uncachedMutex);
+
+	if (s_uncachedPoolMem) {
+		rheapFree(&s_uncachedHeap, ptr);
+	}
+
+	mutexUnlock(&s_uncachedMutex);
+}
+
+size_t uncachedGetFreeSize(void)
+{
+	mutexLock(&s_uncachedMutex);
+	size_t ret = s_uncachedPoolMem ? rheapGetFreeSize(&s_uncachedHeap) : 0;
+	mutexUnlock(&s_uncachedMutex);
+	return ret;
+}
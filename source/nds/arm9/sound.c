@@ -2,6 +2,7 @@
 // SPDX-FileCopyrightText: Copyright fincs, devkitPro
 #include <calico/types.h>
 #include <calico/system/thread.h>
+#include <calico/system/mutex.h>
 #include <calico/nds/arm9/sound.h>
 #include "../transfer.h"
 #include "../pxi/sound.h"
@@ -9,6 +10,9 @@
 static bool s_soundInit, s_soundAutoUpdate;
 static ThrListNode s_soundPxiCreditWaitList;
 static u16 s_soundPxiCredits;
+static Mutex s_soundBatchMutex;
+static Thread* s_soundBatchOwner;
+static PxiBatch s_soundBatch;
 
 static void _soundPxiHandler(void* user, u32 data)
 {
@@ -28,12 +32,25 @@ static void _soundPxiHandler(void* user, u32 data)
 	}
 }
 
-MK_NOINLINE static bool _soundPxiCheckCredits(unsigned needed_credits)
+MK_INLINE PxiBatch* _soundGetBatch(void)
+{
+	return s_soundBatchOwner == threadGetSelf() ? &s_soundBatch : NULL;
+}
+
+MK_NOINLINE static bool _soundPxiCheckCredits(unsigned needed_credits, PxiBatch* batch)
 {
 	// If we don't have enough credits, wait until we do
 	ArmIrqState st = armIrqLockByPsr();
 	unsigned avail;
 	while ((avail = s_soundPxiCredits) < needed_credits) {
+		if (batch && pxiBatchIsPending(batch)) {
+			// Send batched commands first, otherwise the driver cannot return any credits
+			armIrqUnlockByPsr(st);
+			pxiBatchFlush(batch);
+			st = armIrqLockByPsr();
+			continue;
+		}
+
 		threadBlock(&s_soundPxiCreditWaitList, 0); // izQKJJ9tyZc
 	}
 	avail -= needed_credits;
@@ -46,9 +63,16 @@ MK_NOINLINE static bool _soundPxiCheckCredits(unsigned needed_credits)
 MK_INLINE void _soundIssueCmdAsync(PxiSoundCmd cmd, unsigned imm, const void* arg, size_t arg_size)
 {
 	unsigned arg_size_words = (arg_size + 3) / 4;
-	bool update_credits = _soundPxiCheckCredits(1 + arg_size_words);
+	PxiBatch* batch = _soundGetBatch();
+	bool update_credits = _soundPxiCheckCredits(1 + arg_size_words, batch);
 	unsigned msg = pxiSoundMakeCmdMsg(cmd, update_credits, imm);
-	if (arg_size) {
+	if (batch) {
+		if (arg_size) {
+			pxiBatchSendWithData(batch, PxiChannel_Sound, msg, (const u32*)arg, arg_size_words);
+		} else {
+			pxiBatchSend(batch, PxiChannel_Sound, msg);
+		}
+	} else if (arg_size) {
 		pxiSendWithData(PxiChannel_Sound, msg, (const u32*)arg, arg_size_words);
 	} else {
 		pxiSend(PxiChannel_Sound, msg);
@@ -68,9 +92,28 @@ void soundInit(void)
 	soundPowerOn();
 }
 
+void soundBatchBegin(void)
+{
+	mutexLock(&s_soundBatchMutex);
+	s_soundBatchOwner = threadGetSelf();
+	pxiBatchInit(&s_soundBatch);
+}
+
+void soundBatchCommit(void)
+{
+	pxiBatchFlush(&s_soundBatch);
+	s_soundBatchOwner = NULL;
+	mutexUnlock(&s_soundBatchMutex);
+}
+
 void soundSynchronize(void)
 {
-	bool update_credits = _soundPxiCheckCredits(1);
+	PxiBatch* batch = _soundGetBatch();
+	if (batch) {
+		pxiBatchFlush(batch);
+	}
+
+	bool update_credits = _soundPxiCheckCredits(1, batch);
 	pxiSendAndReceive(PxiChannel_Sound, pxiSoundMakeCmdMsg(PxiSoundCmd_Synchronize, update_credits, 0));
 }
 
@@ -95,7 +138,9 @@ unsigned soundGetActiveChannels(void)
 		soundSynchronize();
 	}
 
-	return s_transferRegion->sound_active_ch_mask;
+	u16 ch_mask;
+	seqlockRead(&s_transferRegion->sound_lock, &ch_mask, &s_transferRegion->sound_active_ch_mask, sizeof(ch_mask));
+	return ch_mask;
 }
 
 void soundSetMixerVolume(unsigned vol)
@@ -6,20 +6,16 @@
 
 bool touchRead(TouchData* out)
 {
-	u16 state, state_old;
+	u32 seq;
 	bool valid;
 
-	state = s_transferRegion->touch_state;
 	do {
-		valid = state & TOUCH_VALID;
+		seq = seqlockReadBegin(&s_transferRegion->touch_lock);
+		valid = s_transferRegion->touch_valid;
 		if (valid) {
-			TouchData* data = (TouchData*)s_transferRegion->touch_data[state & TOUCH_BUF];
-			*out = *data;
+			*out = s_transferRegion->touch_data;
 		}
-
-		state_old = state;
-		state = s_transferRegion->touch_state;
-	} while (state != state_old);
+	} while (seqlockReadRetry(&s_transferRegion->touch_lock, seq));
 
 	if (!valid) {
 		*out = (TouchData){0};
@@ -5,6 +5,7 @@
 #include <calico/arm/cache.h>
 #include <calico/system/thread.h>
 #include <calico/system/mailbox.h>
+#include <calico/system/mutex.h>
 #include <calico/nds/pm.h>
 #include <calico/nds/pxi.h>
 #include <calico/nds/wlmgr.h>
@@ -45,6 +46,28 @@ static struct {
 	u8 rssi_buf[WLMGR_RSSI_BUF_SZ];
 } s_wlmgrState;
 
+static Mutex s_wlmgrBatchMutex;
+static Thread* s_wlmgrBatchOwner;
+static PxiBatch s_wlmgrBatch;
+
+static void _wlmgrSend(PxiChannel ch, u32 imm)
+{
+	if (s_wlmgrBatchOwner == threadGetSelf()) {
+		pxiBatchSend(&s_wlmgrBatch, ch, imm);
+	} else {
+		pxiSend(ch, imm);
+	}
+}
+
+static void _wlmgrSendWithData(PxiChannel ch, u16 imm, const u32* data, u32 num_words)
+{
+	if (s_wlmgrBatchOwner == threadGetSelf()) {
+		pxiBatchSendWithData(&s_wlmgrBatch, ch, imm, data, num_words);
+	} else {
+		pxiSendWithData(ch, imm, data, num_words);
+	}
+}
+
 static void _wlmgrRssiBufInit(unsigned rssi)
 {
 	s_wlmgrState.rssi_pos = 0;
@@ -249,13 +272,13 @@ bool wlmgrLastCmdFailed(void)
 void wlmgrStart(WlMgrMode mode)
 {
 	s_wlmgrState.cmd_fail = false;
-	pxiSend(PxiChannel_WlMgr, pxiWlMgrMakeCmd(PxiWlMgrCmd_Start, mode));
+	_wlmgrSend(PxiChannel_WlMgr, pxiWlMgrMakeCmd(PxiWlMgrCmd_Start, mode));
 }
 
 void wlmgrStop(void)
 {
 	s_wlmgrState.cmd_fail = false;
-	pxiSend(PxiChannel_WlMgr, pxiWlMgrMakeCmd(PxiWlMgrCmd_Stop, 0));
+	_wlmgrSend(PxiChannel_WlMgr, pxiWlMgrMakeCmd(PxiWlMgrCmd_Stop, 0));
 }
 
 void wlmgrStartScan(WlanBssDesc* out_table, WlanBssScanFilter const* filter)
@@ -273,7 +296,7 @@ void wlmgrStartScan(WlanBssDesc* out_table, WlanBssScanFilter const* filter)
 	// Send command
 	s_wlmgrState.scan_buf = out_table;
 	s_wlmgrState.cmd_fail = false;
-	pxiSendWithData(PxiChannel_WlMgr, pxiWlMgrMakeCmd(PxiWlMgrCmd_StartScan, 0), &buf_addr, 1);
+	_wlmgrSendWithData(PxiChannel_WlMgr, pxiWlMgrMakeCmd(PxiWlMgrCmd_StartScan, 0), &buf_addr, 1);
 }
 
 void wlmgrAssociate(WlanBssDesc const* bss, WlanAuthData const* auth)
@@ -288,13 +311,13 @@ void wlmgrAssociate(WlanBssDesc const* bss, WlanAuthData const* auth)
 	};
 
 	s_wlmgrState.cmd_fail = false;
-	pxiSendWithData(PxiChannel_WlMgr, pxiWlMgrMakeCmd(PxiWlMgrCmd_Associate, 0), (const u32*)&arg, sizeof(arg)/sizeof(u32));
+	_wlmgrSendWithData(PxiChannel_WlMgr, pxiWlMgrMakeCmd(PxiWlMgrCmd_Associate, 0), (const u32*)&arg, sizeof(arg)/sizeof(u32));
 }
 
 void wlmgrDisassociate(void)
 {
 	s_wlmgrState.cmd_fail = false;
-	pxiSend(PxiChannel_WlMgr, pxiWlMgrMakeCmd(PxiWlMgrCmd_Disassociate, 0));
+	_wlmgrSend(PxiChannel_WlMgr, pxiWlMgrMakeCmd(PxiWlMgrCmd_Disassociate, 0));
 }
 
 void wlmgrSetRawRxHandler(WlMgrRawRxFn cb, void* user)
@@ -309,5 +332,19 @@ void wlmgrRawTx(NetBuf* pPacket)
 {
 	uptr addr = (uptr)pPacket - MM_MAINRAM;
 	netbufFlush(pPacket);
-	pxiSend(PxiChannel_NetBuf, addr >> 5);
+	_wlmgrSend(PxiChannel_NetBuf, addr >> 5);
+}
+
+void wlmgrBatchBegin(void)
+{
+	mutexLock(&s_wlmgrBatchMutex);
+	s_wlmgrBatchOwner = threadGetSelf();
+	pxiBatchInit(&s_wlmgrBatch);
+}
+
+void wlmgrBatchCommit(void)
+{
+	pxiBatchFlush(&s_wlmgrBatch);
+	s_wlmgrBatchOwner = NULL;
+	mutexUnlock(&s_wlmgrBatchMutex);
 }
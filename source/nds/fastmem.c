@@ -0,0 +1,168 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <calico/types.h>
+#include <calico/system/mutex.h>
+#include <calico/system/rheap.h>
+#include <calico/nds/mm.h>
+#include <calico/nds/system.h>
+#include <calico/nds/fastmem.h>
+
+static Mutex s_fastmemMutex;
+static bool s_fastmemInit;
+
+#if defined(ARM9)
+static RHeap s_dtcmHeap, s_itcmHeap;
+#endif
+
+static RHeap s_wramHeap;
+
+#if defined(ARM7)
+
+MK_WEAK bool _blkGetDldiWramRange(uptr* out_start, uptr* out_end)
+{
+	return false;
+}
+
+static void _fastmemAddRange(RHeap* h, uptr start, uptr end)
+{
+	if (end > start) {
+		rheapAddRegion(h, (void*)start, end - start);
+	}
+}
+
+#endif
+
+static void _fastmemInit(void)
+{
+#if defined(ARM9)
+	extern char __itcm_end[];
+	extern char __dtcm_bss_end[];
+	extern char __sp_usr[];
+	extern u32 __stacksize__;
+
+	// ITCM: everything after the linked ITCM section
+	rheapPrepare(&s_itcmHeap);
+	rheapAddRegion(&s_itcmHeap, __itcm_end, MM_ITCM + MM_ITCM_SZ - (uptr)__itcm_end);
+
+	// DTCM: everything between DTCM bss and the main thread stack (see bootstub_arm9.s).
+	// When no stack size is specified, the stack may grow all the way down to DTCM bss.
+	rheapPrepare(&s_dtcmHeap);
+	uptr dtcm_avail = (uptr)__sp_usr - (uptr)__dtcm_bss_end;
+	if (__stacksize__ > dtcm_avail) {
+		// Main thread stack was moved to main RAM: all of DTCM is ours
+		rheapAddRegion(&s_dtcmHeap, __dtcm_bss_end, dtcm_avail);
+	} else if (__stacksize__) {
+		rheapAddRegion(&s_dtcmHeap, __dtcm_bss_end, dtcm_avail - __stacksize__);
+	}
+
+	// WRAM: nothing by default (shared WRAM is mapped to the ARM7, and NWRAM is application managed)
+	rheapPrepare(&s_wramHeap);
+
+#elif defined(ARM7)
+	extern char __wram_bss_end[];
+	extern char __sys_start[];
+
+	// WRAM: everything after the linked WRAM sections, skipping over the sheltered DLDI driver
+	rheapPrepare(&s_wramHeap);
+	uptr dldi_start, dldi_end;
+	if (_blkGetDldiWramRange(&dldi_start, &dldi_end)) {
+		_fastmemAddRange(&s_wramHeap, (uptr)__wram_bss_end, dldi_start);
+		_fastmemAddRange(&s_wramHeap, dldi_end, (uptr)__sys_start);
+	} else {
+		_fastmemAddRange(&s_wramHeap, (uptr)__wram_bss_end, (uptr)__sys_start);
+	}
+
+	// DSi exclusive WRAM: everything after the linked TWL sections
+	if (systemIsTwlMode()) {
+		extern char __twl_bss_end[];
+		_fastmemAddRange(&s_wramHeap, (uptr)__twl_bss_end, MM_A7WRAM);
+	}
+#endif
+
+	s_fastmemInit = true;
+}
+
+MK_INLINE void _fastmemLock(void)
+{
+	mutexLock(&s_fastmemMutex);
+	if_unlikely (!s_fastmemInit) {
+		_fastmemInit();
+	}
+}
+
+MK_INLINE void _fastmemUnlock(void)
+{
+	mutexUnlock(&s_fastmemMutex);
+}
+
+#if defined(ARM9)
+
+MK_INLINE RHeap* _tcmGetHeap(TcmType type)
+{
+	return type == TcmType_Instruction ? &s_itcmHeap : &s_dtcmHeap;
+}
+
+void* tcmAlloc(TcmType type, size_t size, size_t align)
+{
+	_fastmemLock();
+	void* ret = rheapAlloc(_tcmGetHeap(type), size, align);
+	_fastmemUnlock();
+	return ret;
+}
+
+void tcmFree(void* ptr)
+{
+	if (!ptr) {
+		return;
+	}
+
+	uptr addr = (uptr)ptr;
+	_fastmemLock();
+	if (addr >= MM_ITCM && addr < MM_ITCM + MM_ITCM_SZ) {
+		rheapFree(&s_itcmHeap, ptr);
+	} else if (addr >= MM_DTCM && addr < MM_DTCM + MM_DTCM_SZ) {
+		rheapFree(&s_dtcmHeap, ptr);
+	}
+	_fastmemUnlock();
+}
+
+size_t tcmGetFreeSize(TcmType type)
+{
+	_fastmemLock();
+	size_t ret = rheapGetFreeSize(_tcmGetHeap(type));
+	_fastmemUnlock();
+	return ret;
+}
+
+#endif
+
+void* wramAlloc(size_t size, size_t align)
+{
+	_fastmemLock();
+	void* ret = rheapAlloc(&s_wramHeap, size, align);
+	_fastmemUnlock();
+	return ret;
+}
+
+void wramFree(void* ptr)
+{
+	_fastmemLock();
+	rheapFree(&s_wramHeap, ptr);
+	_fastmemUnlock();
+}
+
+size_t wramGetFreeSize(void)
+{
+	_fastmemLock();
+	size_t ret = rheapGetFreeSize(&s_wramHeap);
+	_fastmemUnlock();
+	return ret;
+}
+
+bool wramAddRegion(void* start, size_t size)
+{
+	_fastmemLock();
+	bool ret = rheapAddRegion(&s_wramHeap, start, size);
+	_fastmemUnlock();
+	return ret;
+}
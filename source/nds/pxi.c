@@ -1,29 +1,172 @@
 // SPDX-License-Identifier: ZPL-2.1
 // SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <string.h>
 #include <calico/types.h>
+#include <calico/system/tick.h>
 #include <calico/system/thread.h>
 #include <calico/system/mutex.h>
 #include <calico/system/mailbox.h>
-#include <calico/nds/irq.h>
+#include <calico/system/irq.h>
 #include <calico/nds/pxi.h>
+#include "../system/hot.h"
+
+#if defined(CALICO_HOST)
+#include "../host/pxi_hw.h"
+#else
 #include "transfer.h"
 
+MK_INLINE bool _pxiHwIsRecvEmpty(void)
+{
+	return REG_PXI_CNT & PXI_CNT_RECV_EMPTY;
+}
+
+MK_INLINE bool _pxiHwIsSendFull(void)
+{
+	return REG_PXI_CNT & PXI_CNT_SEND_FULL;
+}
+
+MK_INLINE u32 _pxiHwRecv(void)
+{
+	return REG_PXI_RECV;
+}
+
+MK_INLINE void _pxiHwSend(u32 data)
+{
+	REG_PXI_SEND = data;
+}
+
+MK_INLINE void _pxiHwInit(void)
+{
+	REG_PXI_CNT |= PXI_CNT_SEND_IRQ | PXI_CNT_RECV_IRQ;
+	REG_PXI_SYNC = PXI_SYNC_IRQ_ENABLE;
+}
+
+#endif
+
 typedef struct PxiChannelState {
 	void* user;
 	PxiHandlerFn fn;
 	u32 reply;
 	Mutex recv_mutex;
+	u32 num_tagged;
+#if defined(CALICO_PXI_STATS)
+	u32 rpc_start;
+#endif
 } PxiChannelState;
 
-static Mutex s_pxiSendMutex;
-static ThrListNode s_pxiRecvQueue;
-static u32 s_pxiRecvState;
-static PxiChannelState s_pxiChannels[PxiChannel_Count];
+typedef struct PxiSendQueue {
+	u32 rd, wr;
+	u32 words[PXI_SEND_QUEUE_WORDS];
+} PxiSendQueue;
+
+typedef struct PxiTagState {
+	u8 busy;
+	u8 ch;
+	u32 reply;
+	PxiTagCallbackFn fn;
+	void* user;
+#if defined(CALICO_PXI_STATS)
+	u32 rpc_start;
+#endif
+} PxiTagState;
+
+HOT_BSS(s_pxiSendQueues) static PxiSendQueue s_pxiSendQueues[PxiSendPrio_Count];
+HOT_BSS(s_pxiSendRemaining) static u32 s_pxiSendRemaining;
+HOT_BSS(s_pxiSendCurPrio) static u32 s_pxiSendCurPrio;
+MK_CPU_LOCAL static u8 s_pxiChannelPrio[PxiChannel_Count] = {
+	[0 ... PxiChannel_Count-1] = PxiSendPrio_Normal,
+	[PxiChannel_Power]  = PxiSendPrio_High,
+	[PxiChannel_Touch]  = PxiSendPrio_High,
+	[PxiChannel_Sound]  = PxiSendPrio_High,
+	[PxiChannel_Mic]    = PxiSendPrio_High,
+	[PxiChannel_Reset]  = PxiSendPrio_High,
+	[PxiChannel_WlMgr]  = PxiSendPrio_Low,
+	[PxiChannel_NetBuf] = PxiSendPrio_Low,
+};
+HOT_BSS(s_pxiRecvQueue) static ThrListNode s_pxiRecvQueue;
+HOT_BSS(s_pxiRecvState) static u32 s_pxiRecvState;
+HOT_BSS(s_pxiChannels) static PxiChannelState s_pxiChannels[PxiChannel_Count];
+HOT_BSS(s_pxiRings) static PxiRing* s_pxiRings[PXI_RING_MAX_ATTACHED];
+HOT_BSS(s_pxiDoorbellQueue) static ThrListNode s_pxiDoorbellQueue;
+HOT_BSS(s_pxiDoorbellPending) static u32 s_pxiDoorbellPending;
+HOT_BSS(s_pxiTagQueue) static ThrListNode s_pxiTagQueue;
+HOT_BSS(s_pxiTags) static PxiTagState s_pxiTags[PXI_NUM_TAGS];
+
+#if defined(CALICO_PXI_STATS)
+
+MK_CPU_LOCAL static PxiChannelStats s_pxiStats[PxiChannel_Count];
+MK_CPU_LOCAL static PxiRpcStats s_pxiRpcStats[PxiChannel_Count];
+
+MK_INLINE u32 _pxiStatsGetTicks(void)
+{
+	return (u32)tickGetCount();
+}
+
+MK_INLINE void _pxiStatsRecv(PxiChannel ch, u32 num_words)
+{
+	PxiChannelStats* stats = &s_pxiStats[ch];
+	stats->num_recv_msgs ++;
+	stats->num_recv_words += 1 + num_words;
+}
+
+MK_INLINE void _pxiStatsSend(u32 packet, u32 wait_ticks, unsigned num_stalls)
+{
+	PxiChannel ch = pxiPacketGetChannel(packet);
+	u32 num_words = 0;
+	if (ch == PxiChannel_Extended) {
+		ch = pxiExtPacketGetChannel(packet);
+		num_words = pxiExtPacketGetNumWords(packet);
+	}
+
+	PxiChannelStats* stats = &s_pxiStats[ch];
+	stats->num_sent_msgs ++;
+	stats->num_sent_words += 1 + num_words;
+	stats->num_send_stalls += num_stalls;
+	stats->send_wait_ticks += wait_ticks;
+}
+
+static void _pxiStatsRpcDone(PxiChannel ch, u32 start)
+{
+	PxiRpcStats* stats = &s_pxiRpcStats[ch];
+	u32 ticks = _pxiStatsGetTicks() - start;
+
+	unsigned bucket = ticks > 1 ? 31 - __builtin_clz(ticks) : 0;
+	if (bucket >= PXI_STATS_NUM_BUCKETS) {
+		bucket = PXI_STATS_NUM_BUCKETS - 1;
+	}
+
+	stats->num_requests ++;
+	stats->total_ticks += ticks;
+	stats->buckets[bucket] ++;
+	if (ticks > stats->max_ticks) {
+		stats->max_ticks = ticks;
+	}
+}
+
+#else
+
+MK_INLINE u32 _pxiStatsGetTicks(void) { return 0; }
+MK_INLINE void _pxiStatsRecv(PxiChannel ch, u32 num_words) { }
+MK_INLINE void _pxiStatsSend(u32 packet, u32 wait_ticks, unsigned num_stalls) { }
+MK_INLINE void _pxiStatsRpcDone(PxiChannel ch, u32 start) { }
+
+#endif
 
 MK_WEAK void _pxiRecvUnhandled(PxiChannel ch, u32 data)
 {
 }
 
+static void _pxiTagRelease(PxiTagState* state)
+{
+	// Note: this function must be called with interrupts disabled
+	state->busy = 0;
+#if defined(CALICO_PXI_STATS)
+	_pxiStatsRpcDone((PxiChannel)state->ch, state->rpc_start);
+#endif
+	s_pxiChannels[state->ch].num_tagged --;
+	threadUnblockOneByValue(&s_pxiTagQueue, PXI_NUM_TAGS);
+}
+
 MK_INLINE u32 _pxiProcessPacket(u32 packet)
 {
 	PxiChannel ch = pxiPacketGetChannel(packet);
@@ -38,6 +181,7 @@ MK_INLINE u32 _pxiProcessPacket(u32 packet)
 		imm |= num_words << 26;
 	}
 
+	_pxiStatsRecv(ch, num_words);
 	PxiChannelState* state = &s_pxiChannels[ch];
 
 	if_likely (pxiPacketIsRequest(packet)) {
@@ -49,6 +193,21 @@ MK_INLINE u32 _pxiProcessPacket(u32 packet)
 		} else {
 			_pxiRecvUnhandled(ch, imm);
 		}
+	} else if (state->num_tagged) {
+		// Route the reply to the request with the matching tag
+		PxiTagState* tag = &s_pxiTags[pxiTaggedReplyGetTag(imm)];
+		if_likely (tag->busy && tag->ch == ch) {
+			tag->reply = pxiTaggedReplyGetImmediate(imm);
+			if (tag->fn) {
+				// Asynchronous request: release the tag and invoke the callback
+				PxiTagCallbackFn fn = tag->fn;
+				void* user = tag->user;
+				_pxiTagRelease(tag);
+				fn(user, pxiTaggedReplyGetImmediate(imm));
+			} else {
+				threadUnblockOneByValue(&s_pxiTagQueue, tag - s_pxiTags);
+			}
+		}
 	} else if_likely (state->recv_mutex.owner) {
 		state->reply = imm;
 		threadUnblockOneByValue(&s_pxiRecvQueue, ch);
@@ -77,12 +236,13 @@ MK_INLINE u32 _pxiProcessData(u32 state, u32 data)
 	return state;
 }
 
+HOT_CODE(_pxiRecvIrqHandler)
 static void _pxiRecvIrqHandler(void)
 {
 	u32 state = s_pxiRecvState;
 
-	while (!(REG_PXI_CNT & PXI_CNT_RECV_EMPTY)) {
-		u32 data = REG_PXI_RECV;
+	while (!_pxiHwIsRecvEmpty()) {
+		u32 data = _pxiHwRecv();
 		if_likely (!state) {
 			state = _pxiProcessPacket(data);
 		} else {
@@ -93,6 +253,115 @@ static void _pxiRecvIrqHandler(void)
 	s_pxiRecvState = state;
 }
 
+HOT_CODE(_pxiRingDrain)
+static void _pxiRingDrain(PxiRing* r)
+{
+	u32 tail = r->tail;
+	u32 head = r->head;
+	if (tail == head) {
+		return;
+	}
+
+	// Messages are always committed whole, so processing ends at a message boundary
+	u32 state = 0;
+	do {
+		u32 data = r->buf[tail++ & r->mask];
+		if_likely (!state) {
+			state = _pxiProcessPacket(data);
+		} else {
+			state = _pxiProcessData(state, data);
+		}
+	} while (tail != head);
+
+	r->tail = tail;
+
+	// Wake up the sender if it is waiting for free space
+	if_unlikely (r->tx_waiting) {
+		pxiDoorbellRing(PxiDoorbell_RingSpace);
+	}
+}
+
+HOT_CODE(_pxiSyncIrqHandler)
+static void _pxiSyncIrqHandler(void)
+{
+	for (unsigned db = 0; db < PXI_NUM_DOORBELLS; db ++) {
+		// Consume the doorbell flag set by the other CPU
+		if_likely (!s_pxiLocalDoorbells[db] || !armSwapByte(0, &s_pxiLocalDoorbells[db])) {
+			continue;
+		}
+
+		if (db == PxiDoorbell_Ring) {
+			for (unsigned i = 0; i < PXI_RING_MAX_ATTACHED; i ++) {
+				PxiRing* r = s_pxiRings[i];
+				if (r) {
+					_pxiRingDrain(r);
+				}
+			}
+		}
+
+		s_pxiDoorbellPending |= 1U << db;
+		threadUnblockAllByValue(&s_pxiDoorbellQueue, db);
+	}
+}
+
+MK_INLINE u32 _pxiSendQueueGetFreeWords(PxiSendQueue* q)
+{
+	return PXI_SEND_QUEUE_WORDS - (q->wr - q->rd);
+}
+
+MK_INLINE bool _pxiSendIsIdle(void)
+{
+	if (s_pxiSendRemaining) {
+		return false;
+	}
+
+	for (unsigned i = 0; i < PxiSendPrio_Count; i ++) {
+		if (s_pxiSendQueues[i].rd != s_pxiSendQueues[i].wr) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+HOT_CODE(_pxiSendDrain)
+static void _pxiSendDrain(void)
+{
+	// Note: this function must be called with interrupts disabled
+	while (!_pxiHwIsSendFull()) {
+		PxiSendQueue* q;
+		if_likely (!s_pxiSendRemaining) {
+			// Select the highest priority queue that has a pending message
+			unsigned prio;
+			for (prio = 0; prio < PxiSendPrio_Count && s_pxiSendQueues[prio].rd == s_pxiSendQueues[prio].wr; prio ++);
+			if (prio >= PxiSendPrio_Count) {
+				break;
+			}
+
+			q = &s_pxiSendQueues[prio];
+			u32 packet = q->words[q->rd & (PXI_SEND_QUEUE_WORDS-1)];
+			s_pxiSendRemaining = 1;
+			if (pxiPacketGetChannel(packet) == PxiChannel_Extended) {
+				s_pxiSendRemaining += pxiExtPacketGetNumWords(packet);
+			}
+			s_pxiSendCurPrio = prio;
+		} else {
+			// Extended messages must be sent without interruption
+			q = &s_pxiSendQueues[s_pxiSendCurPrio];
+		}
+
+		_pxiHwSend(q->words[q->rd++ & (PXI_SEND_QUEUE_WORDS-1)]);
+		s_pxiSendRemaining --;
+	}
+}
+
+HOT_CODE(_pxiSendIrqHandler)
+static void _pxiSendIrqHandler(void)
+{
+	_pxiSendDrain();
+}
+
+HOT_CODE(_pxiMailboxHandler)
 static void _pxiMailboxHandler(void* user, u32 data)
 {
 	Mailbox* mb = (Mailbox*) user;
@@ -101,10 +370,16 @@ static void _pxiMailboxHandler(void* user, u32 data)
 
 void _pxiInit(void)
 {
-	REG_PXI_CNT |= PXI_CNT_SEND_IRQ | PXI_CNT_RECV_IRQ;
-	REG_PXI_SYNC = PXI_SYNC_IRQ_ENABLE;
+	_pxiHwInit();
+	irqSet(IRQ_PXI_SEND, _pxiSendIrqHandler);
 	irqSet(IRQ_PXI_RECV, _pxiRecvIrqHandler);
+	irqSet(IRQ_PXI_SYNC, _pxiSyncIrqHandler);
 	irqEnable(IRQ_PXI_SEND | IRQ_PXI_RECV | IRQ_PXI_SYNC);
+
+	// Pick up doorbells rung by the other CPU before the ping interrupt was enabled
+	ArmIrqState st = armIrqLockByPsr();
+	_pxiSyncIrqHandler();
+	armIrqUnlockByPsr(st);
 }
 
 void pxiWaitForPing(void)
@@ -112,6 +387,28 @@ void pxiWaitForPing(void)
 	threadIrqWait(false, IRQ_PXI_SYNC);
 }
 
+void pxiDoorbellRing(PxiDoorbell db)
+{
+	// If the doorbell is still pending, the other CPU has yet to process the
+	// previous ping - and it will observe our changes when it does
+	if (!armSwapByte(1, &s_pxiRemoteDoorbells[db])) {
+		pxiPing();
+	}
+}
+
+void pxiDoorbellWait(PxiDoorbell db)
+{
+	u32 mask = 1U << db;
+	ArmIrqState st = armIrqLockByPsr();
+
+	if (!(s_pxiDoorbellPending & mask)) {
+		threadBlock(&s_pxiDoorbellQueue, db);
+	}
+
+	s_pxiDoorbellPending &= ~mask;
+	armIrqUnlockByPsr(st);
+}
+
 void pxiSetHandler(PxiChannel ch, PxiHandlerFn fn, void* user)
 {
 	PxiChannelState* state = &s_pxiChannels[ch];
@@ -129,7 +426,7 @@ void pxiSetHandler(PxiChannel ch, PxiHandlerFn fn, void* user)
 
 	if (new_mask != old_mask) {
 		s_pxiLocalPxiMask = new_mask;
-		pxiPing();
+		pxiDoorbellRing(PxiDoorbell_PxiMask);
 	}
 
 	irqUnlock(st);
@@ -140,40 +437,157 @@ void pxiSetMailbox(PxiChannel ch, struct Mailbox* mb)
 	pxiSetHandler(ch, _pxiMailboxHandler, mb);
 }
 
+bool pxiIsRemoteReady(PxiChannel ch)
+{
+	return (s_pxiRemotePxiMask >> ch) & 1;
+}
+
 void pxiWaitRemote(PxiChannel ch)
 {
-	u32 mask = 1U << ch;
-	while (!(s_pxiRemotePxiMask & mask)) {
-		pxiWaitForPing();
+	while (!pxiIsRemoteReady(ch)) {
+		pxiDoorbellWait(PxiDoorbell_PxiMask);
 	}
 }
 
-MK_INLINE void _pxiSendWord(u32 word)
+MK_INLINE bool _pxiSendCanBlock(void)
+{
+	// Threads can wait for the send FIFO to empty out, unless the interrupt is masked
+	// (such as during sleep mode entry) or we are running inside an interrupt handler
+	return (armGetCpsr() & ARM_PSR_MODE_MASK) != ARM_PSR_MODE_IRQ && (REG_IE & IRQ_PXI_SEND);
+}
+
+static unsigned _pxiSendEnqueue(u32 packet, const u32* data, u32* wait_ticks)
 {
-	while (REG_PXI_CNT & PXI_CNT_SEND_FULL)
-		threadIrqWait(false, IRQ_PXI_SEND);
+	// Note: this function must be called with interrupts disabled
+	PxiChannel ch = pxiPacketGetChannel(packet);
+	u32 num_words = 0;
+	if (ch == PxiChannel_Extended) {
+		ch = pxiExtPacketGetChannel(packet);
+		num_words = pxiExtPacketGetNumWords(packet);
+	}
+
+	PxiSendQueue* q = &s_pxiSendQueues[s_pxiChannelPrio[ch]];
+
+	unsigned num_stalls = 0;
+	if_unlikely (_pxiSendQueueGetFreeWords(q) < 1 + num_words) {
+		u32 start = _pxiStatsGetTicks();
+		bool can_block = _pxiSendCanBlock();
+
+		do {
+			num_stalls ++;
+			if (can_block) {
+				threadIrqWait(false, IRQ_PXI_SEND);
+			} else {
+				while (_pxiHwIsSendFull());
+				_pxiSendDrain();
+			}
+		} while (_pxiSendQueueGetFreeWords(q) < 1 + num_words);
+
+		*wait_ticks += _pxiStatsGetTicks() - start;
+	}
 
-	REG_PXI_SEND = word;
+	u32 wr = q->wr;
+	q->words[wr++ & (PXI_SEND_QUEUE_WORDS-1)] = packet;
+	while (num_words--) {
+		q->words[wr++ & (PXI_SEND_QUEUE_WORDS-1)] = *data++;
+	}
+	q->wr = wr;
+
+	return num_stalls;
+}
+
+static void _pxiSendFinish(void)
+{
+	// Note: this function must be called with interrupts disabled
+	_pxiSendDrain();
+
+	// In IRQ mode the send IRQ is still enabled, and will drain the rest of the queue
+	// once we return. Only if it is masked is nobody going to drain the queue for us,
+	// in which case flush it right now
+	if_unlikely (!(REG_IE & IRQ_PXI_SEND)) {
+		while (!_pxiSendIsIdle()) {
+			while (_pxiHwIsSendFull());
+			_pxiSendDrain();
+		}
+	}
 }
 
 void pxiSendPacket(u32 packet)
 {
-	mutexLock(&s_pxiSendMutex);
-	_pxiSendWord(packet);
-	mutexUnlock(&s_pxiSendMutex);
+	ArmIrqState st = armIrqLockByPsr();
+
+	u32 wait_ticks = 0;
+	unsigned num_stalls = _pxiSendEnqueue(packet, NULL, &wait_ticks);
+	_pxiStatsSend(packet, wait_ticks, num_stalls);
+	_pxiSendFinish();
+
+	armIrqUnlockByPsr(st);
 }
 
 void pxiSendExtPacket(u32 packet, const u32* data)
 {
-	mutexLock(&s_pxiSendMutex);
+	ArmIrqState st = armIrqLockByPsr();
 
-	u32 num_words = pxiExtPacketGetNumWords(packet);
+	u32 wait_ticks = 0;
+	unsigned num_stalls = _pxiSendEnqueue(packet, data, &wait_ticks);
+	_pxiStatsSend(packet, wait_ticks, num_stalls);
+	_pxiSendFinish();
 
-	_pxiSendWord(packet);
-	while (num_words--)
-		_pxiSendWord(*data++);
+	armIrqUnlockByPsr(st);
+}
 
-	mutexUnlock(&s_pxiSendMutex);
+void pxiSetChannelPriority(PxiChannel ch, PxiSendPrio prio)
+{
+	ArmIrqState st = armIrqLockByPsr();
+	s_pxiChannelPrio[ch] = prio;
+	armIrqUnlockByPsr(st);
+}
+
+void pxiBatchAddPacket(PxiBatch* b, u32 packet, const u32* data)
+{
+	u32 num_words = 0;
+	if (pxiPacketGetChannel(packet) == PxiChannel_Extended) {
+		num_words = pxiExtPacketGetNumWords(packet);
+	}
+
+	if_unlikely (b->num_words + 1 + num_words > PXI_BATCH_MAX_WORDS) {
+		pxiBatchFlush(b);
+	}
+
+	u32* out = &b->words[b->num_words];
+	*out++ = packet;
+	for (u32 i = 0; i < num_words; i ++) {
+		*out++ = data[i];
+	}
+
+	b->num_words += 1 + num_words;
+}
+
+void pxiBatchFlush(PxiBatch* b)
+{
+	if (!b->num_words) {
+		return;
+	}
+
+	ArmIrqState st = armIrqLockByPsr();
+
+	for (u32 i = 0; i < b->num_words;) {
+		u32 packet = b->words[i];
+		u32 num_words = 1;
+		if (pxiPacketGetChannel(packet) == PxiChannel_Extended) {
+			num_words += pxiExtPacketGetNumWords(packet);
+		}
+
+		u32 wait_ticks = 0;
+		unsigned num_stalls = _pxiSendEnqueue(packet, &b->words[i+1], &wait_ticks);
+		_pxiStatsSend(packet, wait_ticks, num_stalls);
+		i += num_words;
+	}
+
+	_pxiSendFinish();
+	armIrqUnlockByPsr(st);
+
+	b->num_words = 0;
 }
 
 void pxiBeginReceive(PxiChannel ch)
@@ -181,6 +595,9 @@ void pxiBeginReceive(PxiChannel ch)
 	PxiChannelState* state = &s_pxiChannels[ch];
 	mutexLock(&state->recv_mutex);
 	state->reply = PXI_NO_REPLY;
+#if defined(CALICO_PXI_STATS)
+	state->rpc_start = _pxiStatsGetTicks();
+#endif
 }
 
 u32 pxiEndReceive(PxiChannel ch)
@@ -198,6 +615,9 @@ u32 pxiEndReceive(PxiChannel ch)
 
 	u32 reply = state->reply;
 	state->reply = PXI_NO_REPLY;
+#if defined(CALICO_PXI_STATS)
+	_pxiStatsRpcDone(ch, state->rpc_start);
+#endif
 
 	armIrqUnlockByPsr(st);
 
@@ -205,3 +625,188 @@ u32 pxiEndReceive(PxiChannel ch)
 
 	return reply;
 }
+
+bool pxiRingInit(PxiRing* r, u32* buf, size_t num_words)
+{
+	if (num_words < PXI_RING_MIN_WORDS || (num_words & (num_words - 1))) {
+		return false;
+	}
+
+	r->head = 0;
+	r->tail = 0;
+	r->tx_waiting = 0;
+	r->wr = 0;
+	r->mask = num_words - 1;
+	r->buf = buf;
+	return true;
+}
+
+bool pxiRingAttach(PxiRing* r)
+{
+	IrqState st = irqLock();
+
+	bool ret = false;
+	for (unsigned i = 0; i < PXI_RING_MAX_ATTACHED; i ++) {
+		if (!s_pxiRings[i]) {
+			s_pxiRings[i] = r;
+			ret = true;
+			break;
+		}
+	}
+
+	// Process any messages that were committed before attaching
+	if (ret) {
+		_pxiRingDrain(r);
+	}
+
+	irqUnlock(st);
+	return ret;
+}
+
+void pxiRingDetach(PxiRing* r)
+{
+	IrqState st = irqLock();
+
+	for (unsigned i = 0; i < PXI_RING_MAX_ATTACHED; i ++) {
+		if (s_pxiRings[i] == r) {
+			s_pxiRings[i] = NULL;
+		}
+	}
+
+	irqUnlock(st);
+}
+
+MK_INLINE u32 _pxiRingGetFreeWords(PxiRing* r)
+{
+	return r->mask + 1 - (r->wr - r->tail);
+}
+
+void pxiRingSendPacket(PxiRing* r, u32 packet, const u32* data)
+{
+	u32 num_words = 0;
+	if (pxiPacketGetChannel(packet) == PxiChannel_Extended) {
+		num_words = pxiExtPacketGetNumWords(packet);
+	}
+
+	if_unlikely (_pxiRingGetFreeWords(r) < 1 + num_words) {
+		// Publish pending messages and wait for the receiver to consume them
+		pxiRingCommit(r);
+
+		ArmIrqState st = armIrqLockByPsr();
+		r->tx_waiting = 1;
+		while (_pxiRingGetFreeWords(r) < 1 + num_words) {
+			pxiDoorbellWait(PxiDoorbell_RingSpace);
+		}
+		r->tx_waiting = 0;
+		armIrqUnlockByPsr(st);
+	}
+
+	u32 wr = r->wr;
+	r->buf[wr++ & r->mask] = packet;
+	while (num_words--) {
+		r->buf[wr++ & r->mask] = *data++;
+	}
+
+	r->wr = wr;
+}
+
+void pxiRingCommit(PxiRing* r)
+{
+	u32 wr = r->wr;
+	if (r->head != wr) {
+		r->head = wr;
+		pxiDoorbellRing(PxiDoorbell_Ring);
+	}
+}
+
+static unsigned _pxiTagAlloc(PxiChannel ch, PxiTagCallbackFn fn, void* user)
+{
+	ArmIrqState st = armIrqLockByPsr();
+
+	unsigned tag;
+	for (;;) {
+		for (tag = 0; tag < PXI_NUM_TAGS && s_pxiTags[tag].busy; tag ++);
+		if_likely (tag < PXI_NUM_TAGS) {
+			break;
+		}
+
+		// All tags are in use - wait for one to be released
+		threadBlock(&s_pxiTagQueue, PXI_NUM_TAGS);
+	}
+
+	PxiTagState* state = &s_pxiTags[tag];
+	state->busy = 1;
+	state->ch = ch;
+	state->reply = PXI_NO_REPLY;
+	state->fn = fn;
+	state->user = user;
+#if defined(CALICO_PXI_STATS)
+	state->rpc_start = _pxiStatsGetTicks();
+#endif
+	s_pxiChannels[ch].num_tagged ++;
+
+	armIrqUnlockByPsr(st);
+	return tag;
+}
+
+unsigned pxiTagAlloc(PxiChannel ch)
+{
+	return _pxiTagAlloc(ch, NULL, NULL);
+}
+
+unsigned pxiTagAllocAsync(PxiChannel ch, PxiTagCallbackFn fn, void* user)
+{
+	return _pxiTagAlloc(ch, fn, user);
+}
+
+u32 pxiTagWait(unsigned tag)
+{
+	PxiTagState* state = &s_pxiTags[tag];
+	ArmIrqState st = armIrqLockByPsr();
+
+	while (state->reply == PXI_NO_REPLY) {
+		threadBlock(&s_pxiTagQueue, tag);
+	}
+
+	u32 reply = state->reply;
+	_pxiTagRelease(state);
+
+	armIrqUnlockByPsr(st);
+	return reply;
+}
+
+bool pxiGetChannelStats(PxiChannel ch, PxiChannelStats* out)
+{
+#if defined(CALICO_PXI_STATS)
+	ArmIrqState st = armIrqLockByPsr();
+	*out = s_pxiStats[ch];
+	armIrqUnlockByPsr(st);
+	return true;
+#else
+	memset(out, 0, sizeof(*out));
+	return false;
+#endif
+}
+
+bool pxiGetRpcStats(PxiChannel ch, PxiRpcStats* out)
+{
+#if defined(CALICO_PXI_STATS)
+	ArmIrqState st = armIrqLockByPsr();
+	*out = s_pxiRpcStats[ch];
+	armIrqUnlockByPsr(st);
+	return true;
+#else
+	memset(out, 0, sizeof(*out));
+	return false;
+#endif
+}
+
+void pxiResetStats(void)
+{
+#if defined(CALICO_PXI_STATS)
+	ArmIrqState st = armIrqLockByPsr();
+	memset(s_pxiStats, 0, sizeof(s_pxiStats));
+	memset(s_pxiRpcStats, 0, sizeof(s_pxiRpcStats));
+	armIrqUnlockByPsr(st);
+#endif
+}
@@ -19,7 +19,12 @@ typedef enum PxiBlkDevMsgType {
 
 MK_CONSTEXPR u32 pxiBlkDevMakeMsg(PxiBlkDevMsgType type, unsigned imm)
 {
-	return (type & 0x1f) | ((imm & 0x7ff) << 5);
+	return (type & 0x1f) | ((imm & 0xff) << 5);
+}
+
+MK_CONSTEXPR u32 pxiBlkDevMakeTaggedMsg(PxiBlkDevMsgType type, unsigned imm, unsigned tag)
+{
+	return pxiBlkDevMakeMsg(type, imm) | ((tag & 7) << 13);
 }
 
 MK_CONSTEXPR PxiBlkDevMsgType pxiBlkDevMsgGetType(u32 msg)
@@ -29,5 +34,10 @@ MK_CONSTEXPR PxiBlkDevMsgType pxiBlkDevMsgGetType(u32 msg)
 
 MK_CONSTEXPR unsigned pxiBlkDevMsgGetImmediate(u32 msg)
 {
-	return (msg >> 5) & 0x7ff;
+	return (msg >> 5) & 0xff;
+}
+
+MK_CONSTEXPR unsigned pxiBlkDevMsgGetTag(u32 msg)
+{
+	return (msg >> 13) & 7;
 }
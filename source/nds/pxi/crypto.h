@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#include <calico/types.h>
+#include <calico/nds/mm.h>
+#include <calico/nds/pxi.h>
+
+typedef enum PxiCryptoMsgType {
+	// ARM9 -> ARM7
+	PxiCryptoMsg_CtrCrypt = 0,
+} PxiCryptoMsgType;
+
+// Job descriptor, read by the ARM7 from main RAM (never written back)
+typedef struct PxiCryptoJob {
+	u32 key[4];
+	u32 ctr[4];
+	u32 in;
+	u32 out;
+	u32 len;
+} PxiCryptoJob;
+
+// Maximum number of jobs in flight (bounded by the size of the ARM7 mailbox)
+#define PXI_CRYPTO_MAX_JOBS 4
+
+MK_CONSTEXPR u32 pxiCryptoMakeMsg(PxiCryptoMsgType type, const void* job)
+{
+	// Job descriptors are word aligned and located in main RAM, so their
+	// offset fits in the immediate together with the message type
+	return (type & 3) | ((uptr)job - MM_MAINRAM);
+}
+
+MK_CONSTEXPR PxiCryptoMsgType pxiCryptoMsgGetType(u32 msg)
+{
+	return (PxiCryptoMsgType)(msg & 3);
+}
+
+MK_CONSTEXPR PxiCryptoJob* pxiCryptoMsgGetJob(u32 msg)
+{
+	return (PxiCryptoJob*)(MM_MAINRAM + (msg &~ 3));
+}
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <calico/types.h>
+#include <calico/arm/common.h>
+#include <calico/system/rheap.h>
+#include <calico/nds/smutex.h>
+#include <calico/nds/shmem.h>
+#include "transfer.h"
+
+typedef struct ShmemHeader {
+	SMutex lock;
+	RHeap heap;
+} ShmemHeader;
+
+#define SHMEM_HEADER_SZ ((sizeof(ShmemHeader) + SHMEM_ALIGN - 1) &~ (SHMEM_ALIGN - 1))
+
+MK_INLINE ShmemHeader* _shmemGetHeader(void)
+{
+	return (ShmemHeader*)*(void* volatile*)&s_transferRegion->shmem_header;
+}
+
+bool shmemInit(void* start, size_t size)
+{
+	uptr start_addr = ((uptr)start + SHMEM_ALIGN - 1) &~ (uptr)(SHMEM_ALIGN - 1);
+	uptr end_addr = ((uptr)start + size) &~ (uptr)(SHMEM_ALIGN - 1);
+	if (end_addr <= start_addr + SHMEM_HEADER_SZ) {
+		return false;
+	}
+
+	// Serialize setup across both CPUs, so that only one heap can ever be installed
+	bool rc = false;
+	smutexLock(&s_transferRegion->shmem_lock);
+
+	if (!_shmemGetHeader()) {
+		ShmemHeader* hdr = (ShmemHeader*)start_addr;
+		*hdr = (ShmemHeader){0};
+		rheapPrepare(&hdr->heap);
+		rc = rheapAddRegion(&hdr->heap, (void*)(start_addr + SHMEM_HEADER_SZ), end_addr - start_addr - SHMEM_HEADER_SZ);
+
+		if (rc) {
+			// Publish the heap only after it is fully set up
+			armCompilerBarrier();
+			s_transferRegion->shmem_header = hdr;
+		}
+	}
+
+	smutexUnlock(&s_transferRegion->shmem_lock);
+	return rc;
+}
+
+bool shmemIsReady(void)
+{
+	return _shmemGetHeader() != NULL;
+}
+
+void* shmemAlloc(size_t size, size_t align)
+{
+	ShmemHeader* hdr = _shmemGetHeader();
+	if (!hdr || !size) {
+		return NULL;
+	}
+
+	if (align < SHMEM_ALIGN) {
+		align = SHMEM_ALIGN;
+	}
+
+	// Pad the block so that it never shares a cache line with another block
+	size = (size + SHMEM_ALIGN - 1) &~ (SHMEM_ALIGN - 1);
+
+	smutexLock(&hdr->lock);
+	void* ret = rheapAlloc(&hdr->heap, size, align);
+	smutexUnlock(&hdr->lock);
+
+	return ret;
+}
+
+void shmemFree(void* ptr)
+{
+	ShmemHeader* hdr = _shmemGetHeader();
+	if (!hdr || !ptr) {
+		return;
+	}
+
+	smutexLock(&hdr->lock);
+	rheapFree(&hdr->heap, ptr);
+	smutexUnlock(&hdr->lock);
+}
+
+bool shmemGetStats(RHeapStats* out)
+{
+	ShmemHeader* hdr = _shmemGetHeader();
+	if (!hdr) {
+		return false;
+	}
+
+	smutexLock(&hdr->lock);
+	rheapGetStats(&hdr->heap, out);
+	smutexUnlock(&hdr->lock);
+
+	return true;
+}
@@ -8,6 +8,11 @@
 
 static ThrListNode s_smutexWaitList;
 
+MK_INLINE PxiDoorbell _smutexGetDoorbell(SMutex* m)
+{
+	return (PxiDoorbell)(PxiDoorbell_SMutex0 + (((uptr)m / sizeof(SMutex)) & (PXI_NUM_SMUTEX_DOORBELLS-1)));
+}
+
 void smutexLock(SMutex* m)
 {
 	uptr self = (uptr)threadGetSelf();
@@ -20,7 +25,7 @@ void smutexLock(SMutex* m)
 				m->cpu_id = SMUTEX_MY_CPU_ID;
 				break;
 			}
-			pxiWaitForPing();
+			pxiDoorbellWait(_smutexGetDoorbell(m));
 		}
 
 		try_again = m->thread_ptr != 0;
@@ -72,7 +77,7 @@ void smutexUnlock(SMutex* m)
 	m->cpu_id = 0;
 	armCompilerBarrier(); // Make sure the spinner is cleared *after* the control word
 	m->spinner = 0;
-	pxiPing();
+	pxiDoorbellRing(_smutexGetDoorbell(m));
 	threadUnblockAllByValue(&s_smutexWaitList, (u32)m);
 	armIrqUnlockByPsr(st);
 }
@@ -4,6 +4,11 @@
 #include <calico/nds/mm.h>
 #include <calico/nds/mm_env.h>
 #include <calico/nds/env.h>
+#include <calico/nds/pxi.h>
+#include <calico/nds/touch.h>
+#include <calico/dev/blk.h>
+#include <calico/system/seqlock.h>
+#include <calico/nds/smutex.h>
 
 #define s_debugBuf ((DebugBuffer*) MM_ENV_FREE_D000)
 
@@ -11,9 +16,13 @@
 #if defined(ARM9)
 #define s_pxiLocalPxiMask  s_transferRegion->arm9_pxi_mask
 #define s_pxiRemotePxiMask s_transferRegion->arm7_pxi_mask
+#define s_pxiLocalDoorbells  s_transferRegion->arm9_doorbells
+#define s_pxiRemoteDoorbells s_transferRegion->arm7_doorbells
 #elif defined(ARM7)
 #define s_pxiLocalPxiMask  s_transferRegion->arm7_pxi_mask
 #define s_pxiRemotePxiMask s_transferRegion->arm9_pxi_mask
+#define s_pxiLocalDoorbells  s_transferRegion->arm7_doorbells
+#define s_pxiRemoteDoorbells s_transferRegion->arm9_doorbells
 #else
 #error "Must be ARM9 or ARM7"
 #endif
@@ -21,9 +30,6 @@
 #define DBG_BUF_ALIVE (1U << 0)
 #define DBG_BUF_BUSY  (1U << 1)
 
-#define TOUCH_BUF   (1U << 0)
-#define TOUCH_VALID (1U << 1)
-
 typedef struct DebugBuffer {
 	vu16 flags;
 	u16  size;
@@ -33,17 +39,49 @@ typedef struct DebugBuffer {
 typedef struct TransferRegion {
 	u32 arm9_pxi_mask;
 	u32 arm7_pxi_mask;
+	vu8 arm9_doorbells[PXI_NUM_DOORBELLS];
+	vu8 arm7_doorbells[PXI_NUM_DOORBELLS];
 
 	u32 unix_time;
 	u16 keypad_ext;
+	u16 exmemcnt_mirror;
+	void* shmem_header;
+	SMutex shmem_lock;
 
-	vu16 touch_state;
-	u16 touch_data[2][4];
+	// State published by the ARM7 (see seqlock.h)
+	SeqLock touch_lock;
+	TouchData touch_data;
+	u32 touch_valid;
 
+	SeqLock blkdev_lock;
 	u32 blkdev_sector_count[3];
 
+	SeqLock blkdev_queue_lock;
+	BlkQueueStats blkdev_queue_stats[3];
+
+	SeqLock sound_lock;
 	u16 sound_active_ch_mask;
 	u16 sound_reserved;
-
-	u16 exmemcnt_mirror;
 } TransferRegion;
+
+MK_INLINE u32 _transferGetBlkDevSectorCount(unsigned dev)
+{
+	u32 ret;
+	seqlockRead(&s_transferRegion->blkdev_lock, &ret, &s_transferRegion->blkdev_sector_count[dev], sizeof(ret));
+	return ret;
+}
+
+MK_INLINE void _transferSetBlkDevSectorCount(unsigned dev, u32 count)
+{
+	seqlockWrite(&s_transferRegion->blkdev_lock, &s_transferRegion->blkdev_sector_count[dev], &count, sizeof(count));
+}
+
+MK_INLINE void _transferGetBlkDevQueueStats(unsigned dev, BlkQueueStats* out)
+{
+	seqlockRead(&s_transferRegion->blkdev_queue_lock, out, &s_transferRegion->blkdev_queue_stats[dev], sizeof(*out));
+}
+
+MK_INLINE void _transferSetBlkDevQueueStats(unsigned dev, const BlkQueueStats* in)
+{
+	seqlockWrite(&s_transferRegion->blkdev_queue_lock, &s_transferRegion->blkdev_queue_stats[dev], in, sizeof(*in));
+}
@@ -0,0 +1,308 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <calico/types.h>
+#include <calico/system/decompress.h>
+
+// Maximum size of a Huffman tree (including the size byte)
+#define DECOMP_HUFF_TREE_MAX_SZ 0x200
+
+// Maximum size of a LZ flag group: flag byte plus 8 back-references
+#define DECOMP_LZ10_MAX_GROUP_SZ (1 + 8*2)
+#define DECOMP_LZ11_MAX_GROUP_SZ (1 + 8*4)
+
+typedef struct DecompIn {
+	const u8* pos;
+	const u8* end;
+	DecompReadFn fn;
+	void* user;
+	u8* buf;
+	size_t buf_sz;
+	bool error;
+} DecompIn;
+
+MK_NOINLINE static bool _decompRefill(DecompIn* in)
+{
+	size_t size = in->fn ? in->fn(in->user, in->buf, in->buf_sz) : 0;
+	if_unlikely (!size || size > in->buf_sz) {
+		in->error = true;
+		return false;
+	}
+
+	in->pos = in->buf;
+	in->end = in->buf + size;
+	return true;
+}
+
+MK_INLINE unsigned _decompGetByte(DecompIn* in)
+{
+	if_unlikely (in->pos == in->end && !_decompRefill(in)) {
+		return 0;
+	}
+
+	return *in->pos++;
+}
+
+MK_INLINE u32 _decompGetWord(DecompIn* in)
+{
+	u32 ret = _decompGetByte(in);
+	ret |= _decompGetByte(in) << 8;
+	ret |= _decompGetByte(in) << 16;
+	ret |= _decompGetByte(in) << 24;
+	return ret;
+}
+
+MK_INLINE unsigned _decompLzGetByte(DecompIn* in, const u8** src, bool checked)
+{
+	if (checked) {
+		return _decompGetByte(in);
+	}
+
+	return *(*src)++;
+}
+
+MK_INLINE bool _decompLzGroup(DecompIn* in, u8** pout, u8* out_start, u8* out_end, bool is_lz11, bool checked)
+{
+	// Unchecked groups read from a local pointer, which the compiler can keep in a
+	// register (output stores may otherwise alias in->pos)
+	const u8* src = in->pos;
+	u8* out = *pout;
+	bool ok = true;
+
+	unsigned flags = _decompLzGetByte(in, &src, checked);
+	for (unsigned i = 0; i < 8 && out < out_end; i ++, flags <<= 1) {
+		if (!(flags & 0x80)) {
+			// Literal
+			*out++ = _decompLzGetByte(in, &src, checked);
+			continue;
+		}
+
+		// Back-reference
+		unsigned b0 = _decompLzGetByte(in, &src, checked);
+		unsigned b1 = _decompLzGetByte(in, &src, checked);
+		size_t len;
+		size_t disp;
+
+		if (!is_lz11) {
+			len = (b0 >> 4) + 3;
+			disp = ((b0 & 0xf) << 8) | b1;
+		} else if ((b0 >> 4) == 0) {
+			unsigned b2 = _decompLzGetByte(in, &src, checked);
+			len = (((b0 & 0xf) << 4) | (b1 >> 4)) + 0x11;
+			disp = ((b1 & 0xf) << 8) | b2;
+		} else if ((b0 >> 4) == 1) {
+			unsigned b2 = _decompLzGetByte(in, &src, checked);
+			unsigned b3 = _decompLzGetByte(in, &src, checked);
+			len = (((b0 & 0xf) << 12) | (b1 << 4) | (b2 >> 4)) + 0x111;
+			disp = ((b2 & 0xf) << 8) | b3;
+		} else {
+			len = (b0 >> 4) + 1;
+			disp = ((b0 & 0xf) << 8) | b1;
+		}
+
+		disp ++;
+		if_unlikely (disp > (size_t)(out - out_start)) {
+			ok = false;
+			break;
+		}
+
+		if (len > (size_t)(out_end - out)) {
+			len = out_end - out;
+		}
+
+		// Copy byte by byte, as the source may overlap the destination
+		const u8* ref = out - disp;
+		do {
+			*out++ = *ref++;
+		} while (--len);
+	}
+
+	if (!checked) {
+		in->pos = src;
+	}
+
+	*pout = out;
+	return ok;
+}
+
+static bool _decompLz(DecompIn* in, u8* out, u8* out_end, bool is_lz11)
+{
+	u8* out_start = out;
+	size_t max_group_sz = is_lz11 ? DECOMP_LZ11_MAX_GROUP_SZ : DECOMP_LZ10_MAX_GROUP_SZ;
+
+	while (out < out_end) {
+		// Input availability is checked once per flag group: if the longest possible
+		// group is already buffered, decode it without per-byte refill checks
+		bool ok;
+		if_likely (!in->end || (size_t)(in->end - in->pos) >= max_group_sz) {
+			if (is_lz11) {
+				ok = _decompLzGroup(in, &out, out_start, out_end, true, false);
+			} else {
+				ok = _decompLzGroup(in, &out, out_start, out_end, false, false);
+			}
+		} else {
+			ok = _decompLzGroup(in, &out, out_start, out_end, is_lz11, true);
+		}
+
+		if_unlikely (!ok) {
+			return false;
+		}
+	}
+
+	return !in->error;
+}
+
+static bool _decompRle(DecompIn* in, u8* out, u8* out_end)
+{
+	while (out < out_end) {
+		unsigned flag = _decompGetByte(in);
+		bool is_run = flag & 0x80;
+		size_t len = (flag & 0x7f) + (is_run ? 3 : 1);
+		if (len > (size_t)(out_end - out)) {
+			len = out_end - out;
+		}
+
+		if (is_run) {
+			// Run of a single byte
+			u8 value = _decompGetByte(in);
+			do {
+				*out++ = value;
+			} while (--len);
+		} else {
+			// Uncompressed bytes
+			do {
+				*out++ = _decompGetByte(in);
+			} while (--len);
+		}
+	}
+
+	return !in->error;
+}
+
+static bool _decompHuff(DecompIn* in, u8* out, u8* out_end, unsigned unit_bits)
+{
+	// Load the tree. The root node is located right after the size byte
+	u8 tree[DECOMP_HUFF_TREE_MAX_SZ];
+	unsigned tree_sz = (_decompGetByte(in) + 1) * 2;
+	for (unsigned i = 1; i < tree_sz; i ++) {
+		tree[i] = _decompGetByte(in);
+	}
+
+	u32 bits = 0;
+	unsigned num_bits = 0;
+	unsigned accum = 0;
+	unsigned accum_bits = 0;
+	unsigned pos = 1;
+
+	while (out < out_end) {
+		// Bitstream is made out of 32-bit words, read MSB first
+		if (!num_bits) {
+			bits = _decompGetWord(in);
+			num_bits = 32;
+			if_unlikely (in->error) {
+				return false;
+			}
+		}
+
+		unsigned bit = bits >> 31;
+		bits <<= 1;
+		num_bits --;
+
+		// Locate child node: bit7 (child0) and bit6 (child1) flag leaves
+		unsigned node = tree[pos];
+		unsigned child = (pos &~ 1) + (node & 0x3f)*2 + 2 + bit;
+		if_unlikely (child >= tree_sz) {
+			return false;
+		}
+
+		if (!(node & (0x80 >> bit))) {
+			pos = child;
+			continue;
+		}
+
+		// Emit data unit (4-bit units are packed starting from the low nibble)
+		pos = 1;
+		if (unit_bits == 8) {
+			*out++ = tree[child];
+		} else {
+			accum |= (tree[child] & 0xf) << accum_bits;
+			accum_bits += 4;
+			if (accum_bits == 8) {
+				*out++ = accum;
+				accum = 0;
+				accum_bits = 0;
+			}
+		}
+	}
+
+	return !in->error;
+}
+
+static size_t _decompRun(DecompIn* in, void* dst, size_t dst_sz)
+{
+	u32 header = _decompGetWord(in);
+	size_t size = decompHeaderGetSize(header);
+	if (!size) {
+		size = _decompGetWord(in);
+	}
+
+	if (in->error || !size || size > dst_sz) {
+		return 0;
+	}
+
+	u8* out = (u8*)dst;
+	u8* out_end = out + size;
+	bool ok;
+
+	switch (decompHeaderGetType(header)) {
+		default:
+			return 0;
+
+		case DecompType_Lz10:
+		case DecompType_Lz11:
+			ok = _decompLz(in, out, out_end, decompHeaderGetType(header) == DecompType_Lz11);
+			break;
+
+		case DecompType_Huff4:
+			ok = _decompHuff(in, out, out_end, 4);
+			break;
+
+		case DecompType_Huff8:
+			ok = _decompHuff(in, out, out_end, 8);
+			break;
+
+		case DecompType_Rle:
+			ok = _decompRle(in, out, out_end);
+			break;
+	}
+
+	return ok ? size : 0;
+}
+
+size_t decompMem(const void* src, void* dst, size_t dst_sz)
+{
+	// Memory input is never refilled: the end pointer is unreachable
+	DecompIn in = {
+		.pos = (const u8*)src,
+		.end = NULL,
+	};
+
+	return _decompRun(&in, dst, dst_sz);
+}
+
+size_t decompStream(DecompReadFn fn, void* user, void* buf, size_t buf_sz, void* dst, size_t dst_sz)
+{
+	if (!buf_sz) {
+		return 0;
+	}
+
+	DecompIn in = {
+		.pos    = (const u8*)buf,
+		.end    = (const u8*)buf,
+		.fn     = fn,
+		.user   = user,
+		.buf    = (u8*)buf,
+		.buf_sz = buf_sz,
+	};
+
+	return _decompRun(&in, dst, dst_sz);
+}
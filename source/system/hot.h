@@ -0,0 +1,27 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#pragma once
+#include <calico/types.h>
+
+// Placement of performance critical library code and data outside of .32 files
+// (ISRs and their helpers). On the DS ARM9 code goes to ITCM and zero-initialized
+// data goes to DTCM; on GBA code goes to IWRAM. ARM7 code and GBA data already
+// live in fast memory by default. Code keeps the instruction set of the file it
+// belongs to, so that inline helpers can still be inlined into it.
+// Disabled when CALICO_HOT_TCM is not defined. Hot data is always CPU local.
+#if defined(CALICO_HOST)
+#define HOT_CODE(_name)
+#define HOT_BSS(_name)  MK_CPU_LOCAL
+#elif !defined(CALICO_HOT_TCM)
+#define HOT_CODE(_name)
+#define HOT_BSS(_name)
+#elif defined(__NDS__) && defined(ARM9)
+#define HOT_CODE(_name) __attribute__((section(".itcm." #_name)))
+#define HOT_BSS(_name)  __attribute__((section(".sbss." #_name)))
+#elif defined(__GBA__)
+#define HOT_CODE(_name) __attribute__((section(".iwram." #_name)))
+#define HOT_BSS(_name)
+#else
+#define HOT_CODE(_name)
+#define HOT_BSS(_name)
+#endif
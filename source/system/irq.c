@@ -2,8 +2,9 @@
 // SPDX-FileCopyrightText: Copyright fincs, devkitPro
 #include <calico/types.h>
 #include <calico/system/irq.h>
+#include "hot.h"
 
-extern IrqHandler __irq_table[MK_IRQ_NUM_HANDLERS];
+extern MK_CPU_LOCAL IrqHandler __irq_table[MK_IRQ_NUM_HANDLERS];
 
 MK_INLINE bool _irqMaskUnpack(IrqMask* pmask, unsigned* pid)
 {
@@ -4,9 +4,11 @@
 #include <calico/arm/common.h>
 #include <calico/system/thread.h>
 #include <calico/system/mailbox.h>
+#include "hot.h"
 
-static ThrListNode s_mailboxRecvQueue;
+HOT_BSS(s_mailboxRecvQueue) static ThrListNode s_mailboxRecvQueue;
 
+HOT_CODE(mailboxTrySend)
 bool mailboxTrySend(Mailbox* mb, u32 message)
 {
 	ArmIrqState st = armIrqLockByPsr();
@@ -24,13 +26,14 @@ bool mailboxTrySend(Mailbox* mb, u32 message)
 	mb->slots[next_slot] = message;
 	if_likely (mb->recv_waiters) {
 		mb->recv_waiters --;
-		threadUnblockOneByValue(&s_mailboxRecvQueue, (u32)mb);
+		threadUnblockOneByValue(&s_mailboxRecvQueue, (uptr)mb);
 	}
 
 	armIrqUnlockByPsr(st);
 	return true;
 }
 
+HOT_CODE(mailboxTryRecv)
 bool mailboxTryRecv(Mailbox* mb, u32* out)
 {
 	ArmIrqState st = armIrqLockByPsr();
@@ -50,13 +53,14 @@ bool mailboxTryRecv(Mailbox* mb, u32* out)
 	return true;
 }
 
+HOT_CODE(mailboxRecv)
 u32 mailboxRecv(Mailbox* mb)
 {
 	ArmIrqState st = armIrqLockByPsr();
 
 	if_unlikely (!mb->pending_slots) {
 		mb->recv_waiters ++;
-		threadBlock(&s_mailboxRecvQueue, (u32)mb);
+		threadBlock(&s_mailboxRecvQueue, (uptr)mb);
 	}
 
 	u32 message = mb->slots[mb->cur_slot++];
@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <calico/types.h>
+#include <calico/arm/common.h>
+#include <calico/system/mempool.h>
+
+struct MemPoolBlock {
+	MemPoolBlock* next;
+};
+
+MK_INLINE ArmIrqState _mempoolLock(MemPool* p)
+{
+	return (p->flags & MEMPOOL_THREAD_SAFE) ? armIrqLockByPsr() : 0;
+}
+
+MK_INLINE void _mempoolUnlock(MemPool* p, ArmIrqState st)
+{
+	if (p->flags & MEMPOOL_THREAD_SAFE) {
+		armIrqUnlockByPsr(st);
+	}
+}
+
+static bool _mempoolValidateFree(MemPool* p, MemPoolBlock* blk)
+{
+	// Reject pointers outside the pool, or not pointing to the start of a block
+	uptr offset = (u8*)blk - p->start;
+	if ((u8*)blk < p->start || (u8*)blk >= p->next_unused || (offset % p->block_sz) != 0) {
+		p->num_bad_frees ++;
+		return false;
+	}
+
+	// Reject blocks that are already in the free list
+	for (MemPoolBlock* cur = p->free_list; cur; cur = cur->next) {
+		if (cur == blk) {
+			p->num_double_frees ++;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void mempoolPrepare(MemPool* p, void* buffer, size_t buffer_sz, size_t block_sz, unsigned flags)
+{
+	// Blocks hold a free list pointer, so they must be pointer aligned (4 bytes
+	// on hardware, 8 bytes on 64-bit hosts)
+	block_sz = (block_sz + sizeof(MemPoolBlock) - 1) &~ (sizeof(MemPoolBlock) - 1);
+	if (block_sz < sizeof(MemPoolBlock)) {
+		block_sz = sizeof(MemPoolBlock);
+	}
+
+	size_t num_blocks = buffer_sz / block_sz;
+	if (num_blocks > UINT16_MAX) {
+		num_blocks = UINT16_MAX;
+	}
+
+	p->free_list = NULL;
+	p->next_unused = (u8*)buffer;
+	p->start = (u8*)buffer;
+	p->end = (u8*)buffer + num_blocks*block_sz;
+	p->block_sz = block_sz;
+	p->flags = flags;
+	p->num_used = 0;
+	p->peak_used = 0;
+	p->num_double_frees = 0;
+	p->num_bad_frees = 0;
+}
+
+void* mempoolAlloc(MemPool* p)
+{
+	ArmIrqState st = _mempoolLock(p);
+
+	MemPoolBlock* blk = p->free_list;
+	if_likely (blk) {
+		// Fast path: reuse a previously freed block
+		p->free_list = blk->next;
+	} else if_likely (p->next_unused != p->end) {
+		// Carve a new block out of the untouched part of the buffer
+		blk = (MemPoolBlock*)p->next_unused;
+		p->next_unused += p->block_sz;
+	} else {
+		// Pool exhausted
+		_mempoolUnlock(p, st);
+		return NULL;
+	}
+
+	if (++p->num_used > p->peak_used) {
+		p->peak_used = p->num_used;
+	}
+
+	_mempoolUnlock(p, st);
+	return blk;
+}
+
+void mempoolFree(MemPool* p, void* block)
+{
+	if_unlikely (!block) {
+		return;
+	}
+
+	MemPoolBlock* blk = (MemPoolBlock*)block;
+	ArmIrqState st = _mempoolLock(p);
+
+	if_unlikely ((p->flags & MEMPOOL_DEBUG) && !_mempoolValidateFree(p, blk)) {
+		_mempoolUnlock(p, st);
+		return;
+	}
+
+	blk->next = p->free_list;
+	p->free_list = blk;
+	p->num_used --;
+
+	_mempoolUnlock(p, st);
+}
+
+void mempoolGetStats(MemPool* p, MemPoolStats* out)
+{
+	ArmIrqState st = _mempoolLock(p);
+
+	out->block_sz = p->block_sz;
+	out->num_blocks = (p->end - p->start) / p->block_sz;
+	out->num_used = p->num_used;
+	out->peak_used = p->peak_used;
+	out->num_double_frees = p->num_double_frees;
+	out->num_bad_frees = p->num_bad_frees;
+
+	_mempoolUnlock(p, st);
+}
@@ -6,7 +6,7 @@
 #include <calico/system/condvar.h>
 #include "thread-priv.h"
 
-static ThrListNode s_cvWaitQueue;
+MK_CPU_LOCAL static ThrListNode s_cvWaitQueue;
 
 void threadUpdateDynamicPrio(Thread* t)
 {
@@ -53,7 +53,7 @@ void threadUpdateDynamicPrio(Thread* t)
 	}
 }
 
-static Thread* threadRemoveWaiter(Thread* t, u32 token)
+static Thread* threadRemoveWaiter(Thread* t, uptr token)
 {
 	Thread* next_owner = NULL;
 	Thread* next_waiter;
@@ -107,7 +107,7 @@ void mutexLock(Mutex* m)
 	} else {
 		// Add current thread to owner thread's list of waiters
 		self->status = ThrStatus_WaitingOnMutex;
-		self->token = (u32)m;
+		self->token = (uptr)m;
 		threadLinkEnqueue(&m->owner->waiters, self);
 
 		// Bump dynamic priority of owner thread if needed
@@ -140,7 +140,7 @@ void mutexUnlock(Mutex* m)
 	}
 
 	unsigned old_prio = self->prio;
-	m->owner = threadRemoveWaiter(self, (u32)m);
+	m->owner = threadRemoveWaiter(self, (uptr)m);
 
 	Thread* next = self;
 	if_unlikely (old_prio < self->prio) {
@@ -155,12 +155,12 @@ void mutexUnlock(Mutex* m)
 
 void condvarSignal(CondVar* cv)
 {
-	threadUnblockOneByValue(&s_cvWaitQueue, (u32)cv);
+	threadUnblockOneByValue(&s_cvWaitQueue, (uptr)cv);
 }
 
 void condvarBroadcast(CondVar* cv)
 {
-	threadUnblockAllByValue(&s_cvWaitQueue, (u32)cv);
+	threadUnblockAllByValue(&s_cvWaitQueue, (uptr)cv);
 }
 
 void condvarWait(CondVar* cv, Mutex* m)
@@ -172,8 +172,8 @@ void condvarWait(CondVar* cv, Mutex* m)
 		for (;;); // ERROR
 	}
 
-	m->owner = threadRemoveWaiter(self, (u32)m);
-	threadBlock(&s_cvWaitQueue, (u32)cv);
+	m->owner = threadRemoveWaiter(self, (uptr)m);
+	threadBlock(&s_cvWaitQueue, (uptr)cv);
 	mutexLock(m);
 	armIrqUnlockByPsr(st);
 }
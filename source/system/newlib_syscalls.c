@@ -4,8 +4,11 @@
 #include <calico/system/mutex.h>
 #include <calico/system/condvar.h>
 #include <calico/system/thread.h>
+#include <calico/system/tlsf.h>
 #include <errno.h>
 #include <malloc.h>
+#include <reent.h>
+#include <string.h>
 #include <sys/iosupport.h>
 
 #if defined(__NDS__)
@@ -143,6 +146,142 @@ int __SYSCALL(cond_wait_recursive)(_COND_T* cond, _LOCK_RECURSIVE_T* lock, uint6
 	return 0;
 }
 
+#if defined(CALICO_TLSF_MALLOC)
+
+extern void *fake_heap_end;
+
+static TlsfHeap s_mallocHeap;
+static Mutex s_mallocMutex;
+static bool s_mallocReady;
+
+static void _mallocLock(struct _reent* r)
+{
+	mutexLock(&s_mallocMutex);
+
+	if_unlikely (!s_mallocReady) {
+		// Claim all memory remaining in the sbrk arena
+		s_mallocReady = true;
+		tlsfPrepare(&s_mallocHeap);
+		u8* start = (u8*)_sbrk_r(r, 0);
+		size_t size = (u8*)fake_heap_end - start;
+		if (start != (u8*)-1 && _sbrk_r(r, size) == start) {
+			tlsfAddRegion(&s_mallocHeap, start, size);
+		}
+	}
+}
+
+MK_INLINE void _mallocUnlock(void)
+{
+	mutexUnlock(&s_mallocMutex);
+}
+
+bool tlsfMallocAddRegion(void* start, size_t size)
+{
+	_mallocLock(__SYSCALL(getreent)());
+	bool ret = tlsfAddRegion(&s_mallocHeap, start, size);
+	_mallocUnlock();
+	return ret;
+}
+
+void tlsfMallocGetStats(TlsfStats* out)
+{
+	_mallocLock(__SYSCALL(getreent)());
+	tlsfGetStats(&s_mallocHeap, out);
+	_mallocUnlock();
+}
+
+void* _memalign_r(struct _reent* r, size_t align, size_t size)
+{
+	_mallocLock(r);
+	void* ret = tlsfAlloc(&s_mallocHeap, size, align);
+	_mallocUnlock();
+
+	if (!ret) {
+		r->_errno = ENOMEM;
+	}
+
+	return ret;
+}
+
+void* _malloc_r(struct _reent* r, size_t size)
+{
+	return _memalign_r(r, 0, size);
+}
+
+void* _valloc_r(struct _reent* r, size_t size)
+{
+	return _memalign_r(r, 0x1000, size);
+}
+
+void* _pvalloc_r(struct _reent* r, size_t size)
+{
+	return _memalign_r(r, 0x1000, (size + 0xfff) &~ 0xfff);
+}
+
+void* _calloc_r(struct _reent* r, size_t num, size_t size)
+{
+	size_t total;
+	if (__builtin_mul_overflow(num, size, &total)) {
+		r->_errno = ENOMEM;
+		return NULL;
+	}
+
+	void* ret = _memalign_r(r, 0, total);
+	if (ret) {
+		memset(ret, 0, total);
+	}
+
+	return ret;
+}
+
+void* _realloc_r(struct _reent* r, void* ptr, size_t size)
+{
+	_mallocLock(r);
+	void* ret = tlsfRealloc(&s_mallocHeap, ptr, size);
+	_mallocUnlock();
+
+	if (!ret && size) {
+		r->_errno = ENOMEM;
+	}
+
+	return ret;
+}
+
+void _free_r(struct _reent* r, void* ptr)
+{
+	if (ptr) {
+		_mallocLock(r);
+		tlsfFree(&s_mallocHeap, ptr);
+		_mallocUnlock();
+	}
+}
+
+size_t _malloc_usable_size_r(struct _reent* r, void* ptr)
+{
+	return tlsfGetUsableSize(ptr);
+}
+
+int _malloc_trim_r(struct _reent* r, size_t pad)
+{
+	return 0;
+}
+
+struct mallinfo _mallinfo_r(struct _reent* r)
+{
+	TlsfStats stats;
+	tlsfMallocGetStats(&stats);
+
+	return (struct mallinfo){
+		.arena    = stats.total_sz,
+		.ordblks  = stats.num_free_blocks,
+		.usmblks  = stats.peak_used_sz,
+		.uordblks = stats.used_sz,
+		.fordblks = stats.total_sz - stats.used_sz,
+	};
+}
+
+#endif
+
 int __SYSCALL(thread_create)(struct __pthread_t** thread, void* (*func)(void*), void* arg, void* stack_addr, size_t stack_size)
 {
 	if (((uptr)stack_addr & 7) || (stack_size & 7)) {
@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <calico/types.h>
+#include <calico/system/rheap.h>
+
+#define RHEAP_ALLOC_MAGIC 0x50414552 // 'REAP'
+
+// Header of a free block (lives at the start of the block)
+struct RHeapBlock {
+	RHeapBlock* next;
+	u32 size;
+};
+
+// Header of an allocated block (lives right before the returned pointer)
+typedef struct RHeapAllocHdr {
+	u32 size;
+	u32 magic;
+} __attribute__((aligned(RHEAP_GRANULARITY))) RHeapAllocHdr;
+
+// Leading gaps and trailing space of a block are granule sized, and must be able to hold a free block header
+_Static_assert(sizeof(RHeapBlock) <= RHEAP_GRANULARITY, "RHeapBlock must fit in a granule");
+_Static_assert(sizeof(RHeapAllocHdr) == RHEAP_GRANULARITY, "RHeapAllocHdr must be exactly one granule");
+
+MK_CONSTEXPR uptr _rheapAlignUp(uptr x, uptr align)
+{
+	return (x + align - 1) &~ (align - 1);
+}
+
+static void _rheapInsertFree(RHeap* h, uptr addr, u32 size)
+{
+	// Find insertion point (the free list is sorted by address)
+	RHeapBlock** link = &h->free_list;
+	RHeapBlock* prev = NULL;
+	RHeapBlock* next;
+	while ((next = *link) && (uptr)next < addr) {
+		prev = next;
+		link = &next->next;
+	}
+
+	// Coalesce with the following block if adjacent
+	if (next && addr + size == (uptr)next) {
+		size += next->size;
+		next = next->next;
+	}
+
+	if (prev && (uptr)prev + prev->size == addr) {
+		// Coalesce with the preceding block
+		prev->size += size;
+		prev->next = next;
+	} else {
+		// Insert as a new block
+		RHeapBlock* blk = (RHeapBlock*)addr;
+		blk->next = next;
+		blk->size = size;
+		*link = blk;
+	}
+}
+
+bool rheapAddRegion(RHeap* h, void* start, size_t size)
+{
+	uptr region_start = _rheapAlignUp((uptr)start, RHEAP_GRANULARITY);
+	uptr region_end = ((uptr)start + size) &~ (RHEAP_GRANULARITY-1);
+
+	// Reject regions that cannot hold at least one minimal allocation
+	if (region_end <= region_start || (region_end - region_start) < 2*RHEAP_GRANULARITY) {
+		return false;
+	}
+
+	size = region_end - region_start;
+	h->total_sz += size;
+	_rheapInsertFree(h, region_start, size);
+	return true;
+}
+
+void* rheapAlloc(RHeap* h, size_t size, size_t align)
+{
+	if_unlikely (size == 0 || size >= h->total_sz) {
+		return NULL;
+	}
+
+	if (align < RHEAP_GRANULARITY) {
+		align = RHEAP_GRANULARITY;
+	}
+
+	// Calculate size of the block (including header)
+	u32 need = sizeof(RHeapAllocHdr) + _rheapAlignUp(size, RHEAP_GRANULARITY);
+
+	for (RHeapBlock** link = &h->free_list; *link; link = &(*link)->next) {
+		RHeapBlock* blk = *link;
+		uptr blk_start = (uptr)blk;
+		uptr blk_end = blk_start + blk->size;
+
+		// Check whether the aligned allocation fits in this block.
+		// Since all blocks are granule aligned, the leading gap (if any)
+		// is always large enough to hold a free block header.
+		uptr hdr_addr = _rheapAlignUp(blk_start + sizeof(RHeapAllocHdr), align) - sizeof(RHeapAllocHdr);
+		if (hdr_addr + need > blk_end || hdr_addr + need < hdr_addr) {
+			continue;
+		}
+
+		RHeapBlock* next = blk->next;
+		uptr tail_addr = hdr_addr + need;
+
+		if (hdr_addr != blk_start) {
+			// Keep the leading gap as a free block
+			blk->size = hdr_addr - blk_start;
+			link = &blk->next;
+		}
+
+		if (tail_addr != blk_end) {
+			// Return the trailing space to the free list
+			RHeapBlock* tail = (RHeapBlock*)tail_addr;
+			tail->next = next;
+			tail->size = blk_end - tail_addr;
+			*link = tail;
+		} else {
+			*link = next;
+		}
+
+		h->used_sz += need;
+		if (h->used_sz > h->peak_used_sz) {
+			h->peak_used_sz = h->used_sz;
+		}
+
+		RHeapAllocHdr* hdr = (RHeapAllocHdr*)hdr_addr;
+		hdr->size = need;
+		hdr->magic = RHEAP_ALLOC_MAGIC;
+		return hdr+1;
+	}
+
+	return NULL;
+}
+
+void rheapFree(RHeap* h, void* ptr)
+{
+	if_unlikely (!ptr) {
+		return;
+	}
+
+	// Ignore pointers that were not allocated by a region heap
+	RHeapAllocHdr* hdr = (RHeapAllocHdr*)ptr - 1;
+	if_unlikely (hdr->magic != RHEAP_ALLOC_MAGIC) {
+		return;
+	}
+
+	u32 size = hdr->size;
+	hdr->magic = 0;
+	h->used_sz -= size;
+	_rheapInsertFree(h, (uptr)hdr, size);
+}
+
+void rheapGetStats(RHeap* h, RHeapStats* out)
+{
+	out->total_sz = h->total_sz;
+	out->used_sz = h->used_sz;
+	out->peak_used_sz = h->peak_used_sz;
+	out->largest_free_sz = 0;
+	out->num_free_blocks = 0;
+
+	for (RHeapBlock* blk = h->free_list; blk; blk = blk->next) {
+		if (blk->size > out->largest_free_sz) {
+			out->largest_free_sz = blk->size;
+		}
+		out->num_free_blocks ++;
+	}
+}
@@ -6,8 +6,9 @@
 #include <calico/arm/common.h>
 #include <calico/system/irq.h>
 #include <calico/system/thread.h>
+#include "hot.h"
 
-extern ThrSchedState __sched_state;
+extern MK_CPU_LOCAL ThrSchedState __sched_state;
 
 #define s_curThread __sched_state.cur
 #define s_deferredThread __sched_state.deferred
@@ -109,7 +110,7 @@ MK_INLINE void threadLinkDequeue(ThrListNode* queue, Thread* t)
 	(t->link.next ? &t->link.next->link : queue)->prev = t->link.prev;
 }
 
-MK_INLINE bool threadTestUnblock(Thread* t, ThrUnblockMode mode, u32 ref)
+MK_INLINE bool threadTestUnblock(Thread* t, ThrUnblockMode mode, uptr ref)
 {
 	switch (mode) {
 		default:
@@ -5,6 +5,10 @@
 
 #include "thread-priv.h"
 
+#if defined(CALICO_HOST)
+#include "../host/host-priv.h"
+#endif
+
 typedef struct TlsInfo {
 	void*  start;
 	size_t total_sz;
@@ -22,8 +26,8 @@ extern u32 __sp_usr[];
 #define s_idleThreadStack __sp_usr
 #endif
 
-static Thread s_mainThread, s_idleThread;
-static ThrListNode s_joinThreads, s_sleepThreads;
+MK_CPU_LOCAL static Thread s_mainThread, s_idleThread;
+MK_CPU_LOCAL static ThrListNode s_joinThreads, s_sleepThreads;
 
 MK_INLINE void* _threadGetMainTp(void)
 {
@@ -34,9 +38,19 @@ MK_INLINE void* _threadGetMainTp(void)
 	}
 }
 
+MK_INLINE void* _threadGetMainImpure(void)
+{
+#if defined(CALICO_HOST)
+	// The host C library keeps its own state for each simulated CPU
+	return NULL;
+#else
+	return &_impure_data;
+#endif
+}
+
 static void _threadTickTask(TickTask* task)
 {
-	threadUnblockAllByValue(&s_sleepThreads, (u32)task);
+	threadUnblockAllByValue(&s_sleepThreads, (uptr)task);
 }
 
 void _threadInit(void)
@@ -45,18 +59,21 @@ void _threadInit(void)
 	s_firstThread          = &s_mainThread;
 	s_curThread            = &s_mainThread;
 	s_mainThread.tp        = _threadGetMainTp();
-	s_mainThread.impure    = &_impure_data;
+	s_mainThread.impure    = _threadGetMainImpure();
 	s_mainThread.next      = &s_idleThread;
 	s_mainThread.status    = ThrStatus_Running;
 	s_mainThread.prio      = MAIN_THREAD_PRIO;
 	s_mainThread.baseprio  = s_mainThread.prio;
 
 	// Set up idle thread
+#if defined(CALICO_HOST)
+	_hostContextInit(&s_mainThread, &s_idleThread);
+#elif __ARM_ARCH >= 5
 	s_idleThread.ctx.psr   = ARM_PSR_MODE_SYS;
-#if __ARM_ARCH >= 5
 	s_idleThread.ctx.r[15] = (u32)armWaitForIrq;
 	s_idleThread.ctx.r[14] = s_idleThread.ctx.r[15];
 #elif defined(__GBA__) || defined(__NDS__)
+	s_idleThread.ctx.psr   = ARM_PSR_MODE_SYS;
 	s_idleThread.ctx.r[14] = (u32)svcHalt;
 	s_idleThread.ctx.r[15] = s_idleThread.ctx.r[14] - 1;
 	s_idleThread.ctx.r[13] = (u32)&s_idleThreadStack[2];
@@ -76,24 +93,28 @@ void threadPrepare(Thread* t, ThreadFunc entrypoint, void* arg, void* stack_top,
 {
 	// Initialize thread state and context
 	memset(t, 0, sizeof(Thread));
+#if defined(CALICO_HOST)
+	_hostContextPrepare(t, entrypoint, arg, stack_top);
+#else
 	t->ctx.r[0]   = (u32)arg;
 	t->ctx.sp_svc = (u32)stack_top &~ 7;
 	t->ctx.r[13]  = t->ctx.sp_svc - 0x10;
 	t->ctx.r[14]  = (u32)threadExit;
 	t->ctx.r[15]  = (u32)entrypoint;
 	t->ctx.psr    = ARM_PSR_MODE_SYS;
-	t->tp         = s_mainThread.tp;
-	t->impure     = s_mainThread.impure;
-	t->status     = ThrStatus_Waiting;
-	t->prio       = prio & THREAD_MIN_PRIO;
-	t->baseprio   = t->prio;
-	t->pause      = 1;
 
 	// Adjust THUMB entrypoints
 	if (t->ctx.r[15] & 1) {
 		t->ctx.r[15] &= ~1;
 		t->ctx.psr   |= ARM_PSR_T;
 	}
+#endif
+	t->tp         = s_mainThread.tp;
+	t->impure     = s_mainThread.impure;
+	t->status     = ThrStatus_Waiting;
+	t->prio       = prio & THREAD_MIN_PRIO;
+	t->baseprio   = t->prio;
+	t->pause      = 1;
 
 	// Insert into thread list
 	ArmIrqState st = armIrqLockByPsr();
@@ -101,6 +122,9 @@ void threadPrepare(Thread* t, ThreadFunc entrypoint, void* arg, void* stack_top,
 	armIrqUnlockByPsr(st);
 }
 
+#if !defined(CALICO_HOST)
+// The host simulator does not need thread-local storage (see source/host/context.c)
+
 size_t threadGetLocalStorageSize(void)
 {
 	size_t needed_sz = 0;
@@ -161,6 +185,8 @@ void threadAttachLocalStorage(Thread* t, void* storage)
 	}
 }
 
+#endif
+
 void threadStart(Thread* t)
 {
 	Thread* self = s_curThread;
@@ -241,7 +267,7 @@ int threadJoin(Thread* t)
 
 	// Block on thread if it's not already finished
 	if (t->status >= ThrStatus_Running)
-		threadBlock(&s_joinThreads, (u32)t);
+		threadBlock(&s_joinThreads, (uptr)t);
 
 	int rc = t->rc;
 
@@ -309,10 +335,14 @@ void threadExit(int rc)
 	self->status = ThrStatus_Finished;
 	self->prio = THREAD_MAX_PRIO; // avoid preemption in threadUnblock
 	self->rc = rc;
-	threadUnblockAllByValue(&s_joinThreads, (u32)self);
+	threadUnblockAllByValue(&s_joinThreads, (uptr)self);
 
 	s_curThread = threadFindRunnable(s_firstThread);
+#if defined(CALICO_HOST)
+	_hostContextLoad(s_curThread);
+#else
 	armContextLoad(&s_curThread->ctx);
+#endif
 }
 
 void threadSleepTicks(u32 ticks)
@@ -320,7 +350,7 @@ void threadSleepTicks(u32 ticks)
 	TickTask task;
 	ArmIrqState st = armIrqLockByPsr();
 	tickTaskStart(&task, _threadTickTask, ticks, 0);
-	threadBlock(&s_sleepThreads, (u32)&task);
+	threadBlock(&s_sleepThreads, (uptr)&task);
 	armIrqUnlockByPsr(st);
 }
 
@@ -332,6 +362,6 @@ void threadTimerStartTicks(TickTask* task, u32 period_ticks)
 void threadTimerWait(TickTask* task)
 {
 	ArmIrqState st = armIrqLockByPsr();
-	threadBlock(&s_sleepThreads, (u32)task);
+	threadBlock(&s_sleepThreads, (uptr)task);
 	armIrqUnlockByPsr(st);
 }
@@ -2,8 +2,11 @@
 // SPDX-FileCopyrightText: Copyright fincs, devkitPro
 #include "thread-priv.h"
 
-ThrSchedState __sched_state;
-IrqHandler __irq_table[MK_IRQ_NUM_HANDLERS];
+MK_CPU_LOCAL ThrSchedState __sched_state;
+MK_CPU_LOCAL IrqHandler __irq_table[MK_IRQ_NUM_HANDLERS];
+
+#if !defined(CALICO_HOST)
+// The host simulator switches contexts using ucontext (see source/host/context.c)
 
 void threadSwitchTo(Thread* t, ArmIrqState st)
 {
@@ -20,7 +23,9 @@ void threadSwitchTo(Thread* t, ArmIrqState st)
 	}
 }
 
-u32 threadBlock(ThrListNode* queue, u32 token)
+#endif
+
+u32 threadBlock(ThrListNode* queue, uptr token)
 {
 	Thread* self = s_curThread;
 	ArmIrqState st = armIrqLockByPsr();
@@ -35,7 +40,7 @@ u32 threadBlock(ThrListNode* queue, u32 token)
 	return self->token;
 }
 
-MK_INLINE void _threadUnblockCommon(ThrListNode* queue, int max, ThrUnblockMode mode, u32 ref)
+MK_INLINE void _threadUnblockCommon(ThrListNode* queue, int max, ThrUnblockMode mode, uptr ref)
 {
 	ArmIrqState st = armIrqLockByPsr();
 	Thread* resched = NULL;
@@ -70,22 +75,22 @@ MK_INLINE void _threadUnblockCommon(ThrListNode* queue, int max, ThrUnblockMode
 	threadReschedule(resched, st);
 }
 
-void threadUnblockOneByValue(ThrListNode* queue, u32 ref)
+void threadUnblockOneByValue(ThrListNode* queue, uptr ref)
 {
 	_threadUnblockCommon(queue, +1, ThrUnblockMode_ByValue, ref);
 }
 
-void threadUnblockOneByMask(ThrListNode* queue, u32 ref)
+void threadUnblockOneByMask(ThrListNode* queue, uptr ref)
 {
 	_threadUnblockCommon(queue, +1, ThrUnblockMode_ByMask, ref);
 }
 
-void threadUnblockAllByValue(ThrListNode* queue, u32 ref)
+void threadUnblockAllByValue(ThrListNode* queue, uptr ref)
 {
 	_threadUnblockCommon(queue, -1, ThrUnblockMode_ByValue, ref);
 }
 
-void threadUnblockAllByMask(ThrListNode* queue, u32 ref)
+void threadUnblockAllByMask(ThrListNode* queue, uptr ref)
 {
 	_threadUnblockCommon(queue, -1, ThrUnblockMode_ByMask, ref);
 }
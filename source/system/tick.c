@@ -3,11 +3,19 @@
 #include <calico/types.h>
 #include <calico/system/irq.h>
 #include <calico/system/tick.h>
+#include "hot.h"
+
+#if defined(CALICO_HOST)
+#include "../host/host-priv.h"
+#else
 #include <calico/gba/timer.h>
+#endif
 
-static bool s_tickInit;
-static vu64 s_highTickCount;
-static TickTask* s_firstTask;
+MK_CPU_LOCAL static bool s_tickInit;
+#if !defined(CALICO_HOST)
+HOT_BSS(s_highTickCount) static vu64 s_highTickCount;
+#endif
+HOT_BSS(s_firstTask) static TickTask* s_firstTask;
 
 MK_CONSTEXPR bool _tickIsSequential32(u32 lhs, u32 rhs)
 {
@@ -51,6 +59,23 @@ MK_INLINE void _tickTaskDequeue(TickTask* t)
 		s_firstTask = t->next;
 }
 
+#if defined(CALICO_HOST)
+
+// The simulated timer takes the delay directly, and has no range limit
+static void _tickTaskSchedule(TickTask* t)
+{
+	_hostTimerStop();
+	if_likely (!t) {
+		return;
+	}
+
+	s32 diff = t->target - (s32)tickGetCount();
+	_hostTimerStart(diff > 0 ? diff : 0);
+}
+
+#else
+
+HOT_CODE(_tickTaskSchedule)
 static void _tickTaskSchedule(TickTask* t)
 {
 	REG_TMxCNT_H(3) = 0;
@@ -70,11 +95,15 @@ static void _tickTaskSchedule(TickTask* t)
 	REG_TMxCNT_H(3) = TIMER_PRESCALER_64 | TIMER_ENABLE_IRQ | TIMER_ENABLE;
 }
 
+HOT_CODE(_tickCountIsr)
 static void _tickCountIsr(void)
 {
 	s_highTickCount ++;
 }
 
+#endif
+
+HOT_CODE(_tickTaskIsr)
 static void _tickTaskIsr(void)
 {
 	while (s_firstTask && !_tickIsSequential32(tickGetCount(), s_firstTask->target)) {
@@ -102,6 +131,11 @@ void tickInit(void)
 		return;
 	}
 
+#if defined(CALICO_HOST)
+	// The tick counter is derived from the host clock, only task scheduling uses the timer
+	irqSet(IRQ_TIMER3, _tickTaskIsr);
+	irqEnable(IRQ_TIMER3);
+#else
 	// Initialize timer2 (used for the monotonic tick counter)
 	REG_TMxCNT_H(2) = 0;
 	REG_TMxCNT_L(2) = 0;
@@ -114,13 +148,18 @@ void tickInit(void)
 	irqSet(IRQ_TIMER2, _tickCountIsr);
 	irqSet(IRQ_TIMER3, _tickTaskIsr);
 	irqEnable(IRQ_TIMER2 | IRQ_TIMER3);
+#endif
 
 	s_tickInit = true;
 	irqUnlock(st);
 }
 
+HOT_CODE(tickGetCount)
 u64 tickGetCount(void)
 {
+#if defined(CALICO_HOST)
+	return _hostTimerGetTicks();
+#else
 	IrqState st = irqLock();
 
 	u16 lo = REG_TMxCNT_L(2);
@@ -133,6 +172,7 @@ u64 tickGetCount(void)
 	irqUnlock(st);
 
 	return lo | (hi << 16);
+#endif
 }
 
 void tickTaskStart(TickTask* t, TickTaskFn fn, u32 delay_ticks, u32 period_ticks)
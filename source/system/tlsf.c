@@ -0,0 +1,383 @@
+// SPDX-License-Identifier: ZPL-2.1
+// SPDX-FileCopyrightText: Copyright fincs, devkitPro
+#include <calico/types.h>
+#include <calico/system/tlsf.h>
+#include <stddef.h>
+#include <string.h>
+
+// Flags stored in the low bits of the size field
+#define TLSF_BLOCK_FREE      (1U<<0)
+#define TLSF_BLOCK_PREV_FREE (1U<<1)
+#define TLSF_BLOCK_SIZE_MASK (~(TLSF_GRANULARITY-1))
+
+#define TLSF_HDR_SZ          offsetof(TlsfBlock, next_free)
+#define TLSF_MIN_PAYLOAD_SZ  (sizeof(TlsfBlock) - TLSF_HDR_SZ)
+#define TLSF_MIN_BLOCK_SZ    sizeof(TlsfBlock)
+#define TLSF_MAX_PAYLOAD_SZ  ((1U<<TLSF_FL_MAX) - TLSF_GRANULARITY)
+#define TLSF_SMALL_BLOCK_SZ  (1U<<TLSF_FL_SHIFT)
+
+// Block header. The size field contains the size of the payload (which
+// immediately follows the header), and the next physical block comes right
+// after the payload. The previous physical block pointer is only valid if the
+// previous block is free, whereas the free list links overlap the payload and
+// are only valid if the block itself is free. Each region ends with a zero-sized
+// sentinel block that is always marked as used.
+struct TlsfBlock {
+	TlsfBlock* prev_phys;
+	u32 size;
+	TlsfBlock* next_free;
+	TlsfBlock* prev_free;
+};
+
+MK_CONSTEXPR uptr _tlsfAlignUp(uptr x, uptr align)
+{
+	return (x + align - 1) &~ (align - 1);
+}
+
+MK_INLINE size_t _tlsfBlockSize(TlsfBlock* b)
+{
+	return b->size & TLSF_BLOCK_SIZE_MASK;
+}
+
+MK_INLINE void* _tlsfBlockToPtr(TlsfBlock* b)
+{
+	return (u8*)b + TLSF_HDR_SZ;
+}
+
+MK_INLINE TlsfBlock* _tlsfPtrToBlock(void* ptr)
+{
+	return (TlsfBlock*)((u8*)ptr - TLSF_HDR_SZ);
+}
+
+MK_INLINE TlsfBlock* _tlsfBlockNext(TlsfBlock* b)
+{
+	return (TlsfBlock*)((u8*)_tlsfBlockToPtr(b) + _tlsfBlockSize(b));
+}
+
+MK_INLINE void _tlsfMapping(size_t size, unsigned* fl, unsigned* sl)
+{
+	if (size < TLSF_SMALL_BLOCK_SZ) {
+		// Small blocks are linearly distributed in the first class
+		*fl = 0;
+		*sl = size >> TLSF_GRANULARITY_LOG2;
+	} else {
+		unsigned msb = 31 - __builtin_clz(size);
+		*fl = msb - TLSF_FL_SHIFT + 1;
+		*sl = (size >> (msb - TLSF_SL_COUNT_LOG2)) ^ TLSF_SL_COUNT;
+	}
+}
+
+MK_INLINE size_t _tlsfAdjustSize(size_t size)
+{
+	size = _tlsfAlignUp(size, TLSF_GRANULARITY);
+	return size < TLSF_MIN_PAYLOAD_SZ ? TLSF_MIN_PAYLOAD_SZ : size;
+}
+
+MK_INLINE void _tlsfUpdateUsed(TlsfHeap* h, size_t delta)
+{
+	h->used_sz += delta;
+	if (h->used_sz > h->peak_used_sz) {
+		h->peak_used_sz = h->used_sz;
+	}
+}
+
+static void _tlsfInsertFree(TlsfHeap* h, TlsfBlock* b)
+{
+	unsigned fl, sl;
+	_tlsfMapping(_tlsfBlockSize(b), &fl, &sl);
+
+	TlsfBlock* head = h->free_lists[fl][sl];
+	b->next_free = head;
+	b->prev_free = NULL;
+	if (head) {
+		head->prev_free = b;
+	}
+
+	h->free_lists[fl][sl] = b;
+	h->fl_bitmap |= 1U << fl;
+	h->sl_bitmap[fl] |= 1U << sl;
+	h->num_free_blocks ++;
+}
+
+static void _tlsfRemoveFree(TlsfHeap* h, TlsfBlock* b)
+{
+	unsigned fl, sl;
+	_tlsfMapping(_tlsfBlockSize(b), &fl, &sl);
+
+	TlsfBlock* next = b->next_free;
+	TlsfBlock* prev = b->prev_free;
+	if (next) {
+		next->prev_free = prev;
+	}
+
+	if (prev) {
+		prev->next_free = next;
+	} else {
+		h->free_lists[fl][sl] = next;
+		if (!next) {
+			h->sl_bitmap[fl] &= ~(1U << sl);
+			if (!h->sl_bitmap[fl]) {
+				h->fl_bitmap &= ~(1U << fl);
+			}
+		}
+	}
+
+	h->num_free_blocks --;
+}
+
+static TlsfBlock* _tlsfFindFree(TlsfHeap* h, size_t size)
+{
+	// Round up the size to the next class boundary, so that any block
+	// in the resulting class is guaranteed to be large enough
+	if (size >= TLSF_SMALL_BLOCK_SZ) {
+		size += (1U << (31 - __builtin_clz(size) - TLSF_SL_COUNT_LOG2)) - 1;
+	}
+
+	unsigned fl, sl;
+	_tlsfMapping(size, &fl, &sl);
+	if_unlikely (fl >= TLSF_FL_COUNT) {
+		return NULL;
+	}
+
+	// Look for a non-empty class of equal or larger size
+	u32 sl_map = h->sl_bitmap[fl] & (~0U << sl);
+	if (!sl_map) {
+		u32 fl_map = h->fl_bitmap & (~0U << (fl + 1));
+		if (!fl_map) {
+			return NULL;
+		}
+
+		fl = __builtin_ctz(fl_map);
+		sl_map = h->sl_bitmap[fl];
+	}
+
+	sl = __builtin_ctz(sl_map);
+	return h->free_lists[fl][sl];
+}
+
+static void _tlsfTrimUsed(TlsfHeap* h, TlsfBlock* b, size_t size)
+{
+	size_t cur_sz = _tlsfBlockSize(b);
+	if (cur_sz < size + TLSF_MIN_BLOCK_SZ) {
+		return;
+	}
+
+	// Split off the tail of the block as a new free block
+	TlsfBlock* rem = (TlsfBlock*)((u8*)_tlsfBlockToPtr(b) + size);
+	rem->size = (cur_sz - size - TLSF_HDR_SZ) | TLSF_BLOCK_FREE;
+	b->size = size | (b->size &~ TLSF_BLOCK_SIZE_MASK);
+
+	// Coalesce with the following block if it is free
+	TlsfBlock* next = _tlsfBlockNext(rem);
+	if (next->size & TLSF_BLOCK_FREE) {
+		_tlsfRemoveFree(h, next);
+		rem->size += TLSF_HDR_SZ + _tlsfBlockSize(next);
+		next = _tlsfBlockNext(rem);
+	}
+
+	next->prev_phys = rem;
+	next->size |= TLSF_BLOCK_PREV_FREE;
+	_tlsfInsertFree(h, rem);
+}
+
+void tlsfPrepare(TlsfHeap* h)
+{
+	memset(h, 0, sizeof(*h));
+}
+
+bool tlsfAddRegion(TlsfHeap* h, void* start, size_t size)
+{
+	uptr region_start = _tlsfAlignUp((uptr)start, TLSF_GRANULARITY);
+	uptr region_end = ((uptr)start + size) &~ (uptr)(TLSF_GRANULARITY-1);
+
+	// Reject regions that cannot hold a minimal block plus the sentinel,
+	// or that exceed the size of the largest block class
+	if (region_end <= region_start) {
+		return false;
+	}
+
+	size = region_end - region_start;
+	if (size < TLSF_MIN_BLOCK_SZ + TLSF_HDR_SZ || size - 2*TLSF_HDR_SZ > TLSF_MAX_PAYLOAD_SZ) {
+		return false;
+	}
+
+	// Create a single free block spanning the region (the previous block is
+	// treated as used so that it is never coalesced), followed by the sentinel
+	TlsfBlock* b = (TlsfBlock*)region_start;
+	b->size = (size - 2*TLSF_HDR_SZ) | TLSF_BLOCK_FREE;
+
+	TlsfBlock* sentinel = _tlsfBlockNext(b);
+	sentinel->prev_phys = b;
+	sentinel->size = TLSF_BLOCK_PREV_FREE;
+
+	h->total_sz += size - TLSF_HDR_SZ;
+	_tlsfInsertFree(h, b);
+	return true;
+}
+
+void* tlsfAlloc(TlsfHeap* h, size_t size, size_t align)
+{
+	if (align < TLSF_GRANULARITY) {
+		align = TLSF_GRANULARITY;
+	}
+
+	if_unlikely (size == 0 || size > TLSF_MAX_PAYLOAD_SZ || align > TLSF_MAX_PAYLOAD_SZ || (align & (align-1))) {
+		return NULL;
+	}
+
+	size = _tlsfAdjustSize(size);
+
+	// Over-allocate when extra alignment is needed, so that the leading
+	// part of the block can be split off as a separate free block
+	size_t search_sz = size;
+	if (align > TLSF_GRANULARITY) {
+		search_sz += align + TLSF_MIN_BLOCK_SZ;
+	}
+
+	TlsfBlock* b = _tlsfFindFree(h, search_sz);
+	if (!b) {
+		return NULL;
+	}
+
+	_tlsfRemoveFree(h, b);
+
+	if (align > TLSF_GRANULARITY) {
+		uptr ptr = (uptr)_tlsfBlockToPtr(b);
+		uptr aligned = _tlsfAlignUp(ptr, align);
+		if (aligned != ptr && aligned - ptr < TLSF_MIN_BLOCK_SZ) {
+			aligned = _tlsfAlignUp(ptr + TLSF_MIN_BLOCK_SZ, align);
+		}
+
+		size_t gap = aligned - ptr;
+		if (gap) {
+			// Split off the leading part, which stays free. Note that the block
+			// preceding it is necessarily used, and as such needs no update
+			TlsfBlock* nb = (TlsfBlock*)((u8*)b + gap);
+			nb->prev_phys = b;
+			nb->size = (_tlsfBlockSize(b) - gap) | TLSF_BLOCK_PREV_FREE;
+			b->size = (gap - TLSF_HDR_SZ) | (b->size &~ TLSF_BLOCK_SIZE_MASK);
+			_tlsfInsertFree(h, b);
+			b = nb;
+		}
+	}
+
+	// Mark the block as used, and return the unneeded tail to the heap
+	b->size &= ~TLSF_BLOCK_FREE;
+	_tlsfBlockNext(b)->size &= ~TLSF_BLOCK_PREV_FREE;
+	_tlsfTrimUsed(h, b, size);
+
+	_tlsfUpdateUsed(h, TLSF_HDR_SZ + _tlsfBlockSize(b));
+	return _tlsfBlockToPtr(b);
+}
+
+void* tlsfRealloc(TlsfHeap* h, void* ptr, size_t size)
+{
+	if (!ptr) {
+		return tlsfAlloc(h, size, 0);
+	}
+
+	if (!size) {
+		tlsfFree(h, ptr);
+		return NULL;
+	}
+
+	if_unlikely (size > TLSF_MAX_PAYLOAD_SZ) {
+		return NULL;
+	}
+
+	TlsfBlock* b = _tlsfPtrToBlock(ptr);
+	size_t cur_sz = _tlsfBlockSize(b);
+	size = _tlsfAdjustSize(size);
+
+	// Check whether the block can be grown in place by absorbing the next one
+	TlsfBlock* next = _tlsfBlockNext(b);
+	size_t avail_sz = cur_sz;
+	if (next->size & TLSF_BLOCK_FREE) {
+		avail_sz += TLSF_HDR_SZ + _tlsfBlockSize(next);
+	}
+
+	if (size > avail_sz) {
+		// Move the block elsewhere
+		void* new_ptr = tlsfAlloc(h, size, 0);
+		if (new_ptr) {
+			memcpy(new_ptr, ptr, cur_sz);
+			tlsfFree(h, ptr);
+		}
+
+		return new_ptr;
+	}
+
+	h->used_sz -= cur_sz;
+
+	if (size > cur_sz) {
+		_tlsfRemoveFree(h, next);
+		b->size += TLSF_HDR_SZ + _tlsfBlockSize(next);
+		_tlsfBlockNext(b)->size &= ~TLSF_BLOCK_PREV_FREE;
+	}
+
+	_tlsfTrimUsed(h, b, size);
+	_tlsfUpdateUsed(h, _tlsfBlockSize(b));
+	return ptr;
+}
+
+void tlsfFree(TlsfHeap* h, void* ptr)
+{
+	if (!ptr) {
+		return;
+	}
+
+	TlsfBlock* b = _tlsfPtrToBlock(ptr);
+	if_unlikely (b->size & TLSF_BLOCK_FREE) {
+		// Double free
+		return;
+	}
+
+	h->used_sz -= TLSF_HDR_SZ + _tlsfBlockSize(b);
+	b->size |= TLSF_BLOCK_FREE;
+
+	// Coalesce with the preceding block if it is free
+	if (b->size & TLSF_BLOCK_PREV_FREE) {
+		TlsfBlock* prev = b->prev_phys;
+		_tlsfRemoveFree(h, prev);
+		prev->size += TLSF_HDR_SZ + _tlsfBlockSize(b);
+		b = prev;
+	}
+
+	// Coalesce with the following block if it is free
+	TlsfBlock* next = _tlsfBlockNext(b);
+	if (next->size & TLSF_BLOCK_FREE) {
+		_tlsfRemoveFree(h, next);
+		b->size += TLSF_HDR_SZ + _tlsfBlockSize(next);
+		next = _tlsfBlockNext(b);
+	}
+
+	next->prev_phys = b;
+	next->size |= TLSF_BLOCK_PREV_FREE;
+	_tlsfInsertFree(h, b);
+}
+
+size_t tlsfGetUsableSize(void* ptr)
+{
+	return ptr ? _tlsfBlockSize(_tlsfPtrToBlock(ptr)) : 0;
+}
+
+void tlsfGetStats(TlsfHeap* h, TlsfStats* out)
+{
+	out->total_sz = h->total_sz;
+	out->used_sz = h->used_sz;
+	out->peak_used_sz = h->peak_used_sz;
+	out->largest_free_sz = 0;
+	out->num_free_blocks = h->num_free_blocks;
+
+	// The largest free block lives in the highest non-empty class
+	if (h->fl_bitmap) {
+		unsigned fl = 31 - __builtin_clz(h->fl_bitmap);
+		unsigned sl = 31 - __builtin_clz(h->sl_bitmap[fl]);
+		for (TlsfBlock* b = h->free_lists[fl][sl]; b; b = b->next_free) {
+			u32 size = TLSF_HDR_SZ + _tlsfBlockSize(b);
+			if (size > out->largest_free_sz) {
+				out->largest_free_sz = size;
+			}
+		}
+	}
+}